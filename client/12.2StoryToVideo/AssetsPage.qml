@@ -20,6 +20,8 @@ Page {
 
     Component.onCompleted: {
         console.log("AssetsPage loaded. assetsRoot =", assetsRoot)
+        // [新增] 点击资产卡片会打开 PreviewPage，空闲时预创建
+        pagePreloader.preload(Qt.resolvedUrl("PreviewPage.qml"))
     }
 
     // ⚠ 请你在这里填写资产文件夹路径，例如：
@@ -69,6 +71,17 @@ Page {
                     console.log("资产库已刷新");
                 }
             }
+
+            Button {
+                text: qsTr("清理重复 (%1)").arg(assetIndex.duplicateCount)
+                font.pixelSize: 14
+                enabled: assetIndex.duplicateCount > 0
+                onClicked: {
+                    // 仅合并字节完全一致的重复文件 (硬链接)，近似重复只做标记
+                    var saved = assetIndex.dedupeStorage();
+                    console.log("重复资产清理完成，节省字节:", saved);
+                }
+            }
         }
 
         // 搜索 + 新建按钮
@@ -194,11 +207,12 @@ Page {
                         property string thumbPathPng: folderPath + "/thumb.png"
                         property string thumbToShow: ""
 
+                        // 经 C++ ThumbnailProvider 在后台线程解码并缩小，避免大图原尺寸上传纹理
                         Component.onCompleted: {
                             if (Qt.resolvedUrl(thumbPathJpg) !== "") {
-                                thumbToShow = "file:///" + thumbPathJpg
+                                thumbToShow = "image://thumbnail/" + thumbPathJpg
                             } else if (Qt.resolvedUrl(thumbPathPng) !== "") {
-                                thumbToShow = "file:///" + thumbPathPng
+                                thumbToShow = "image://thumbnail/" + thumbPathPng
                             } else {
                                 thumbToShow = ""
                             }
@@ -223,6 +237,16 @@ Page {
                                     fillMode: Image.PreserveAspectCrop
                                     visible: thumbToShow !== ""
                                     source: thumbToShow
+                                    sourceSize.width: 240
+                                    sourceSize.height: 110
+                                    asynchronous: true
+
+                                    // 没有 thumb 图片时，由媒体辅助进程从 video.mp4 取第 1 秒的帧
+                                    onStatusChanged: {
+                                        if (status === Image.Error && thumbToShow.indexOf("video.mp4") < 0) {
+                                            thumbToShow = "image://thumbnail/" + folderPath + "/video.mp4#t=1"
+                                        }
+                                    }
                                 }
 
                                 // fallback 文本
@@ -255,6 +279,23 @@ Page {
                                 }
                             }
 
+                            // 近似重复标记 (依赖 duplicateCount 变化触发重新求值)
+                            Rectangle {
+                                width: 96
+                                height: 26
+                                radius: 13
+                                color: "#FFF4E5"
+                                visible: assetIndex.duplicateCount >= 0 &&
+                                         (assetIndex.duplicateOf(thumbPathJpg) !== "" ||
+                                          assetIndex.duplicateOf(thumbPathPng) !== "")
+                                Text {
+                                    anchors.centerIn: parent
+                                    text: qsTr("疑似重复")
+                                    font.pixelSize: 12
+                                    color: "#D97706"
+                                }
+                            }
+
                             MouseArea {
                                 anchors.fill: parent
                                 onClicked: {
@@ -263,8 +304,8 @@ Page {
 
                                     console.log("打开视频:", videoPath)
 
-                                    pageStack.push(Qt.resolvedUrl("PreviewPage.qml"), {
-                                        videoPath: videoPath
+                                    pageStack.push(pagePreloader.page(Qt.resolvedUrl("PreviewPage.qml")), {
+                                        videoSource: videoPath
                                     })
                                 }
                                 hoverEnabled: true
@@ -106,6 +106,20 @@ Page {
             generationProgress = pct;
             console.log("生成进度更新:", pct + "%", "Story ID:", sId);
         }
+
+        // [新增] 服务端过载：请求已在本地排队，稍后自动重试
+        onSubmissionDelayed: function(seconds) {
+            if (!isGenerating) return;
+            statusMessage = qsTr("服务器繁忙，约 %1 秒后自动重试").arg(seconds);
+        }
+
+        // [新增] 历史耗时模型给出的剩余时间
+        onCompilationEta: function(sId, seconds) {
+            if (!isGenerating || seconds < 0) return;
+            statusMessage = seconds >= 60
+                    ? qsTr("正在生成，预计还需约 %1 分钟").arg(Math.ceil(seconds / 60))
+                    : qsTr("正在生成，预计还需约 %1 秒").arg(seconds);
+        }
     }
 
     // --- 错误对话框 ---
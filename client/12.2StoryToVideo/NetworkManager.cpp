@@ -6,6 +6,10 @@
 #include <QUrlQuery>
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QDateTime>
+#include <QTimer>
+#include "metrics.h"
+#include "admissioncontroller.h"
 
 // 用户定义的属性 Key
 const QNetworkRequest::Attribute ShotIdAttribute =
@@ -14,21 +18,99 @@ const QNetworkRequest::Attribute RequestTypeAttribute =
     (QNetworkRequest::Attribute)(QNetworkRequest::UserMax + 2);
 const QNetworkRequest::Attribute TaskIdAttribute =
     (QNetworkRequest::Attribute)(QNetworkRequest::UserMax + 3);
+const QNetworkRequest::Attribute ClientTagAttribute =
+    (QNetworkRequest::Attribute)(QNetworkRequest::UserMax + 4);
+const QNetworkRequest::Attribute ProjectIdAttribute =
+    (QNetworkRequest::Attribute)(QNetworkRequest::UserMax + 5);
+// [新增] 请求发出时间 (ms)，用于请求耗时指标
+const QNetworkRequest::Attribute StartTimeAttribute =
+    (QNetworkRequest::Attribute)(QNetworkRequest::UserMax + 6);
+
+// [新增] 指标标签中的请求类型名 (与 NetworkManager::RequestType 的取值对应)
+static QString requestTypeName(int type)
+{
+    switch (type) {
+    case 1: return "create_project";
+    case 2: return "update_shot";
+    case 3: return "generate_video";
+    case 4: return "poll_status";
+    case 5: return "get_shot_list";
+    case 6: return "update_priority";
+    case 7: return "generate_tts";
+    case 8: return "long_poll";
+    default: return "unknown";
+    }
+}
+
+// [新增] 长轮询参数
+static const int DefaultLongPollWaitSeconds = 25;   // 低于常见代理的 30 秒空闲超时
+static const int MinLongPollWaitSeconds = 4;        // 代理连这也保持不住时退回定时轮询
+static const int LongPollMaxFailures = 3;           // 连续快速失败后才判任务查询失败
+
+// [新增] 每个请求结束时记录次数与耗时 (只有原子操作，无人抓取时几乎没有开销)
+static void recordRequestMetrics(QNetworkReply *reply)
+{
+    const QNetworkRequest request = reply->request();
+    const QString type = requestTypeName(request.attribute(RequestTypeAttribute).toInt());
+    const QString typeLabel = Metrics::label("type", type);
+    const bool ok = reply->error() == QNetworkReply::NoError;
+
+    Metrics *metrics = Metrics::instance();
+    metrics->counter("stv_http_requests_total", "API requests sent by NetworkManager, by type and result.",
+                     typeLabel + "," + Metrics::label("result", ok ? "ok" : "error"))->inc();
+
+    const qint64 startedAt = request.attribute(StartTimeAttribute).toLongLong();
+    if (startedAt > 0) {
+        const double seconds = (QDateTime::currentMSecsSinceEpoch() - startedAt) / 1000.0;
+        metrics->histogram("stv_http_request_duration_seconds", "API request latency by type.",
+                           Metrics::requestBuckets(), typeLabel)->observe(seconds);
+    }
+}
 
 
-NetworkManager::NetworkManager(QObject *parent) : QObject(parent)
+NetworkManager::NetworkManager(QObject *parent) : QObject(parent), m_pollNotBefore(0)
+    , m_transport(LongPolling), m_transportConfirmed(false), m_transportForced(false)
+    , m_longPollWaitSeconds(DefaultLongPollWaitSeconds)
 {
+    QString gateway = qEnvironmentVariable("STV_GATEWAY_URL", "http://172.23.197.68:18080");
+    while (gateway.endsWith('/')) {
+        gateway.chop(1);
+    }
+    PROJECT_API_URL = QUrl(gateway + "/v1/projects");
+    TASK_API_BASE_URL = QUrl(gateway + "/tasks");
+
     m_networkManager = new QNetworkAccessManager(this);
 
     connect(m_networkManager, &QNetworkAccessManager::finished,
             this, &NetworkManager::onNetworkReplyFinished);
 
-    qDebug() << "NetworkManager 实例化成功。";
+    m_admission = new AdmissionController(this);
+    connect(m_admission, &AdmissionController::throttled, this, &NetworkManager::submissionThrottled);
+
+    // [新增] 任务状态传输方式
+    const QString transport = qEnvironmentVariable("STV_TASK_TRANSPORT", "auto").toLower();
+    if (transport == "poll") {
+        m_transport = TimerPolling;
+    } else if (transport == "longpoll") {
+        m_transportConfirmed = true;
+        m_transportForced = true;
+    }
+    Metrics::instance()->gauge("stv_long_polls_outstanding", "Task long-poll requests currently held open.",
+                               this, [this]() {
+        int count = 0;
+        for (const Watch &watch : m_watches) {
+            count += watch.reply ? 1 : 0;
+        }
+        return double(count);
+    });
+
+    qDebug() << "NetworkManager 实例化成功。Gateway:" << gateway << "任务状态:" << (isLongPolling() ? "长轮询" : "定时轮询");
 }
 
 
 // --- 1. 业务 API 请求：直接创建项目 (POST /v1/api/projects) ---
-void NetworkManager::createProjectDirect(const QString &title, const QString &storyText, const QString &style, const QString &description)
+void NetworkManager::createProjectDirect(const QString &title, const QString &storyText, const QString &style, const QString &description,
+                                         const QString &tag)
 {
     qDebug() << "发送 CreateProjectDirect 请求...";
 
@@ -44,8 +126,11 @@ void NetworkManager::createProjectDirect(const QString &title, const QString &st
     QNetworkRequest request(url);
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
     request.setAttribute(RequestTypeAttribute, NetworkManager::CreateProjectDirect);
+    request.setAttribute(StartTimeAttribute, QDateTime::currentMSecsSinceEpoch());
+    request.setAttribute(ClientTagAttribute, tag);
 
-    m_networkManager->post(request, QByteArray());
+    // [修改] 经准入队列发出，服务端过载时在本地排队
+    m_admission->submit([this, request]() { return m_networkManager->post(request, QByteArray()); });
 }
 
 // --- 2. 资源获取 API：获取分镜列表 (GET /v1/api/projects/:id/shots) ---
@@ -57,6 +142,7 @@ void NetworkManager::getShotListRequest(const QString &projectId)
 
     QNetworkRequest request(queryUrl);
     request.setAttribute(RequestTypeAttribute, NetworkManager::GetShotList);
+    request.setAttribute(StartTimeAttribute, QDateTime::currentMSecsSinceEpoch());
 
     // 存储 projectId，用于在回复时关联数据
     request.setRawHeader("X-Project-Id", projectId.toUtf8());
@@ -82,9 +168,11 @@ void NetworkManager::updateShotRequest(const QString &projectId, const QString &
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
     request.setAttribute(RequestTypeAttribute, NetworkManager::UpdateShot);
+    request.setAttribute(StartTimeAttribute, QDateTime::currentMSecsSinceEpoch());
+
     request.setAttribute(ShotIdAttribute, shotId);
 
-    m_networkManager->post(request, postData);
+    m_admission->submit([this, request, postData]() { return m_networkManager->post(request, postData); });
 }
 
 // --- 4. 任务 API 请求：生成视频 (POST /v1/api/projects/:project_id/video) ---
@@ -96,7 +184,8 @@ void NetworkManager::generateVideoRequest(const QString &projectId)
 
     QJsonObject requestJson;
     requestJson["format"] = "mp4";
-    requestJson["resolution"] = "1920x1080";
+    requestJson["resolution"] = videoResolution();
+    requestJson["renditions"] = QJsonArray::fromStringList(videoRenditionLadder());
 
     QJsonDocument doc(requestJson);
     QByteArray postData = doc.toJson(QJsonDocument::Compact);
@@ -105,45 +194,277 @@ void NetworkManager::generateVideoRequest(const QString &projectId)
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
     request.setAttribute(RequestTypeAttribute, NetworkManager::GenerateVideo);
+    request.setAttribute(StartTimeAttribute, QDateTime::currentMSecsSinceEpoch());
+
+    request.setAttribute(ProjectIdAttribute, projectId);
 
-    m_networkManager->post(request, postData);
+    m_admission->submit([this, request, postData]() { return m_networkManager->post(request, postData); });
+}
+
+// --- 4b. [新增] 任务 API 请求：旁白配音 (POST /v1/projects/:project_id/tts) ---
+void NetworkManager::generateTtsRequest(const QString &projectId, const QString &voice)
+{
+    QUrl url = QUrl(PROJECT_API_URL.toString() + "/" + projectId + "/tts");
+    qDebug() << "发送 GenerateTts 请求 for Project ID:" << projectId << "URL:" << url;
+
+    QJsonObject requestJson;
+    if (!voice.isEmpty()) {
+        requestJson["voice"] = voice;
+    }
+    QByteArray postData = QJsonDocument(requestJson).toJson(QJsonDocument::Compact);
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setAttribute(RequestTypeAttribute, NetworkManager::GenerateTts);
+    request.setAttribute(StartTimeAttribute, QDateTime::currentMSecsSinceEpoch());
+    request.setAttribute(ProjectIdAttribute, projectId);
+
+    m_admission->submit([this, request, postData]() { return m_networkManager->post(request, postData); });
 }
 
 // --- 5. 任务状态查询 API (GET /v1/api/tasks/:task_id) ---
 void NetworkManager::pollTaskStatus(const QString &taskId)
 {
+    // [新增] 服务端要求退避期间不查询 (任务本身并未失败)
+    if (QDateTime::currentMSecsSinceEpoch() < m_pollNotBefore) {
+        return;
+    }
     QUrl queryUrl = TASK_API_BASE_URL.toString() + "/" + taskId;
     qDebug() << "发送 PollTaskStatus 请求 for Task ID:" << taskId;
 
     QNetworkRequest request(queryUrl);
     request.setAttribute(RequestTypeAttribute, NetworkManager::PollStatus);
+    request.setAttribute(StartTimeAttribute, QDateTime::currentMSecsSinceEpoch());
     request.setAttribute(TaskIdAttribute, taskId);
 
     m_networkManager->get(request);
 }
 
+// --- 5b. [新增] 长轮询任务状态 (GET /tasks/:task_id?wait=N&since=...) ---
+void NetworkManager::watchTask(const QString &taskId)
+{
+    if (!isLongPolling() || m_watches.contains(taskId)) {
+        return;
+    }
+    m_watches.insert(taskId, Watch());
+    sendLongPoll(taskId);
+}
+
+void NetworkManager::unwatchTask(const QString &taskId)
+{
+    // 先移除再 abort：abort 会同步触发 finished，回调里找不到 watch 即忽略
+    const Watch watch = m_watches.take(taskId);
+    if (watch.reply) {
+        watch.reply->abort();
+    }
+    // 不再跟踪的任务不会再报告终态，归还准入名额
+    m_admission->taskEnded(taskId);
+}
+
+void NetworkManager::sendLongPoll(const QString &taskId)
+{
+    auto it = m_watches.find(taskId);
+    if (it == m_watches.end() || it->reply) {
+        return;
+    }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now < m_pollNotBefore) {
+        rearmLongPoll(taskId, int(m_pollNotBefore - now));
+        return;
+    }
+
+    QUrl url(TASK_API_BASE_URL.toString() + "/" + taskId);
+    QUrlQuery query;
+    query.addQueryItem("wait", QString::number(m_longPollWaitSeconds));
+    if (!it->since.isEmpty()) {
+        query.addQueryItem("since", it->since);
+    }
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    request.setAttribute(RequestTypeAttribute, NetworkManager::LongPoll);
+    request.setAttribute(StartTimeAttribute, now);
+    request.setAttribute(TaskIdAttribute, taskId);
+    // 比服务端最长等待多留余量，超过仍无响应视为连接被代理挂住
+    request.setTransferTimeout((m_longPollWaitSeconds + 10) * 1000);
+
+    it->reply = m_networkManager->get(request);
+}
+
+void NetworkManager::rearmLongPoll(const QString &taskId, int delayMs)
+{
+    // sendLongPoll 会检查 watch 是否还在、是否已有挂起请求，多余的定时器无害
+    QTimer::singleShot(qMax(0, delayMs), this, [this, taskId]() { sendLongPoll(taskId); });
+}
+
+void NetworkManager::handleLongPollReply(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    const QString taskId = reply->request().attribute(TaskIdAttribute).toString();
+    auto it = m_watches.find(taskId);
+    if (it == m_watches.end() || it->reply != reply) {
+        return;   // 已取消关注或已退回定时轮询
+    }
+    it->reply = nullptr;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (AdmissionController::isThrottled(reply)) {
+        const qint64 retryAfter = AdmissionController::retryAfterMs(reply);
+        m_pollNotBefore = qMax(m_pollNotBefore, now + retryAfter);
+        qDebug() << "服务端过载，长轮询暂停" << retryAfter << "ms";
+        rearmLongPoll(taskId, int(retryAfter));
+        return;
+    }
+
+    if (reply->error() != QNetworkReply::NoError) {
+        const QString errorMsg = QString("网络错误 (%1): %2").arg(reply->error()).arg(reply->errorString());
+        const qint64 heldMs = now - reply->request().attribute(StartTimeAttribute).toLongLong();
+        qDebug() << "长轮询失败:" << taskId << errorMsg << "挂起了" << heldMs << "ms";
+
+        // 挂起一段时间后才断开：多半是代理掐断了空闲连接，缩短等待时间再试
+        if (heldMs >= MinLongPollWaitSeconds * 1000) {
+            m_longPollWaitSeconds /= 2;
+            if (m_longPollWaitSeconds < MinLongPollWaitSeconds) {
+                if (!m_transportForced) {
+                    fallBackToTimerPolling("代理无法保持挂起的请求");
+                    return;
+                }
+                m_longPollWaitSeconds = MinLongPollWaitSeconds;
+            }
+            qDebug() << "长轮询等待时间缩短为" << m_longPollWaitSeconds << "s";
+            rearmLongPoll(taskId, 0);
+            return;
+        }
+        if (++it->failures >= LongPollMaxFailures) {
+            m_watches.erase(it);
+            m_admission->taskEnded(taskId);
+            emit taskRequestFailed(taskId, errorMsg);
+            return;
+        }
+        rearmLongPoll(taskId, 1000 * it->failures);
+        return;
+    }
+
+    const QJsonObject taskObj = QJsonDocument::fromJson(reply->readAll()).object();
+    readQueueDepth(reply, taskObj);
+    const bool supported = !reply->rawHeader("X-Long-Poll").isEmpty();
+    it->failures = 0;
+    it->since = taskObj["updated_at"].toString();
+    // 终态任务服务端不再挂起 (立即返回)，必须结束关注，否则会变成零间隔的请求循环
+    const bool terminal = isTerminalStatus(taskObj["status"].toString());
+    if (terminal) {
+        m_watches.erase(it);
+    }
+
+    // 下面的信号可能让 ViewModel 调用 unwatchTask，之后不再使用 it
+    handleTaskObject(taskId, taskObj);
+
+    if (!supported && !m_transportConfirmed) {
+        fallBackToTimerPolling("服务端忽略了 wait 参数");
+        return;
+    }
+    if (supported && !m_transportConfirmed) {
+        m_transportConfirmed = true;
+        qDebug() << "服务端支持长轮询，wait =" << reply->rawHeader("X-Long-Poll");
+    }
+    if (terminal) {
+        return;
+    }
+    // 强制长轮询但服务端立即返回时，至少间隔 1 秒，避免空转
+    rearmLongPoll(taskId, supported ? 0 : 1000);
+}
+
+void NetworkManager::fallBackToTimerPolling(const QString &reason)
+{
+    if (m_transport == TimerPolling) {
+        return;
+    }
+    qDebug() << "长轮询不可用，退回定时轮询:" << reason;
+    m_transport = TimerPolling;
+    const QHash<QString, Watch> watches = m_watches;
+    m_watches.clear();
+    for (const Watch &watch : watches) {
+        if (watch.reply) {
+            watch.reply->abort();
+        }
+    }
+}
+
+// --- 6. 任务优先级提示 (POST /tasks/priority) ---
+void NetworkManager::updateTaskPriorities(const QVariantMap &priorities)
+{
+    QUrl url = QUrl(TASK_API_BASE_URL.toString() + "/priority");
+
+    QJsonArray items;
+    for (auto it = priorities.constBegin(); it != priorities.constEnd(); ++it) {
+        QJsonObject item;
+        item["task_id"] = it.key();
+        item["priority"] = it.value().toInt();
+        items.append(item);
+    }
+    QJsonObject requestJson;
+    requestJson["tasks"] = items;
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    request.setAttribute(RequestTypeAttribute, NetworkManager::UpdatePriority);
+    request.setAttribute(StartTimeAttribute, QDateTime::currentMSecsSinceEpoch());
+
+    m_networkManager->post(request, QJsonDocument(requestJson).toJson(QJsonDocument::Compact));
+}
+
 
 void NetworkManager::onNetworkReplyFinished(QNetworkReply *reply)
 {
+    recordRequestMetrics(reply);
+
+    // [新增] 长轮询有自己的重试与退化逻辑
+    if (reply->request().attribute(RequestTypeAttribute).toInt() == NetworkManager::LongPoll) {
+        handleLongPollReply(reply);
+        return;
+    }
+
+    // [新增] 过载反馈：提交类请求的 429/503 由准入队列按 Retry-After 重新排队；
+    // 轮询被限流时整体退避，不当作任务失败
+    const RequestType requestType = (RequestType)reply->request().attribute(RequestTypeAttribute).toInt();
+    if (requestType == NetworkManager::CreateProjectDirect || requestType == NetworkManager::UpdateShot
+            || requestType == NetworkManager::GenerateVideo || requestType == NetworkManager::GenerateTts) {
+        if (m_admission->finished(reply)) {
+            reply->deleteLater();
+            return;
+        }
+    } else if (AdmissionController::isThrottled(reply)) {
+        const qint64 retryAfter = AdmissionController::retryAfterMs(reply);
+        m_pollNotBefore = qMax(m_pollNotBefore, QDateTime::currentMSecsSinceEpoch() + retryAfter);
+        qDebug() << "服务端过载，任务查询暂停" << retryAfter << "ms";
+        reply->deleteLater();
+        return;
+    }
+
     // --- 1. 检查网络错误 ---
     if (reply->error() != QNetworkReply::NoError) {
         QString errorMsg = QString("网络错误 (%1): %2").arg(reply->error()).arg(reply->errorString());
         qDebug() << errorMsg;
 
         RequestType type = (RequestType)reply->request().attribute(RequestTypeAttribute).toInt();
-        if (type == NetworkManager::PollStatus) {
+        if (type == NetworkManager::UpdatePriority) {
+            // 服务端不支持优先级时忽略，不打扰用户
+        } else if (type == NetworkManager::PollStatus) {
              QString taskId = reply->request().attribute(TaskIdAttribute).toString();
+             m_admission->taskEnded(taskId);
              emit taskRequestFailed(taskId, errorMsg);
         } else {
             emit networkError(errorMsg);
         }
 
+        m_admission->hold(reply, QStringList()); // [新增] 提交失败，立即归还准入名额
         reply->deleteLater();
         return;
     }
 
     QByteArray responseData = reply->readAll();
     RequestType type = (RequestType)reply->request().attribute(RequestTypeAttribute).toInt();
+    QStringList createdTasks; // [新增] 本次提交创建的任务，占用准入名额直到终态
 
     // A. 处理创建项目 (Project) 的回复 (返回 Task IDs)
     if (type == NetworkManager::CreateProjectDirect)
@@ -165,8 +486,11 @@ void NetworkManager::onNetworkReplyFinished(QNetworkReply *reply)
              emit networkError("项目创建成功，但缺少任务 ID 无法启动轮询。");
         } else {
             qDebug() << "项目和任务创建成功，Project ID:" << projectId << "，Text Task ID:" << textTaskId;
+            // 创建项目被接受即归还名额 (createdTasks 留空)：文本任务要跑完整个分镜生成，
+            // 占用到终态会让章节模式的子项目两两串行提交，总耗时不再接近最长的章节
             // 发出信号，通知 ViewModel 启动文本任务轮询
-            emit textTaskCreated(projectId, textTaskId, shotTaskIdsList);
+            emit textTaskCreated(projectId, textTaskId, shotTaskIdsList,
+                                 reply->request().attribute(ClientTagAttribute).toString());
         }
     }
     // B. 处理获取分镜列表 (GET /projects/:id/shots) 的回复
@@ -193,12 +517,29 @@ void NetworkManager::onNetworkReplyFinished(QNetworkReply *reply)
         QJsonDocument jsonDoc = QJsonDocument::fromJson(responseData);
         QJsonObject jsonObj = jsonDoc.object();
         QString taskId = jsonObj["task_id"].toString();
+        readQueueDepth(reply, jsonObj);
 
         if (taskId.isEmpty()) {
             emit networkError("API 返回中未找到 task_id。");
         } else {
             QString shotId = (type == NetworkManager::UpdateShot) ? reply->request().attribute(ShotIdAttribute).toString() : QString();
-            emit taskCreated(taskId, shotId);
+            QString projectId = (type == NetworkManager::GenerateVideo) ? reply->request().attribute(ProjectIdAttribute).toString() : QString();
+            createdTasks << taskId;
+            emit taskCreated(taskId, shotId, projectId);
+        }
+    }
+    // C2. [新增] 配音任务创建的回复
+    else if (type == NetworkManager::GenerateTts)
+    {
+        QJsonObject jsonObj = QJsonDocument::fromJson(responseData).object();
+        QString taskId = jsonObj["task_id"].toString();
+        readQueueDepth(reply, jsonObj);
+
+        if (taskId.isEmpty()) {
+            emit networkError("配音 API 返回中未找到 task_id。");
+        } else {
+            createdTasks << taskId;
+            emit ttsTaskCreated(taskId, reply->request().attribute(ProjectIdAttribute).toString());
         }
     }
     // D. 任务状态查询 (PollStatus) 的回复
@@ -208,21 +549,58 @@ void NetworkManager::onNetworkReplyFinished(QNetworkReply *reply)
         QJsonDocument jsonDoc = QJsonDocument::fromJson(responseData);
         // Gateway 直接返回任务对象，不是嵌套在 "task" 键下
         QJsonObject taskObj = jsonDoc.object();
+        readQueueDepth(reply, taskObj);
+        handleTaskObject(taskId, taskObj);
+    }
+    // E. 优先级提示的回复 (仅日志)
+    else if (type == NetworkManager::UpdatePriority)
+    {
+        qDebug() << "任务优先级已更新:" << QJsonDocument::fromJson(responseData).object()["updated"].toInt();
+    }
 
-        QString status = taskObj["status"].toString();
-        int progress = taskObj["progress"].toInt();
+    // [新增] 非提交类请求不在准入队列中，hold() 直接忽略
+    m_admission->hold(reply, createdTasks);
+    reply->deleteLater();
+}
+
+bool NetworkManager::isTerminalStatus(const QString &status)
+{
+    return status == "finished" || status == "failed" || status == "error" || status == "cancelled";
+}
 
-        qDebug() << "Task:" << taskId << " Status:" << status << " Progress:" << progress << " Message:" << taskObj["message"].toString();
+void NetworkManager::handleTaskObject(const QString &taskId, const QJsonObject &taskObj)
+{
+    QString status = taskObj["status"].toString();
+    int progress = taskObj["progress"].toInt();
 
-        if (status == "finished") {
-            // 任务完成，提取 result 字段
-            QVariantMap resultMap = taskObj["result"].toObject().toVariantMap();
-            emit taskResultReceived(taskId, resultMap);
-        } else {
-            // 任务进行中
-            emit taskStatusReceived(taskId, progress, status, taskObj["message"].toString());
-        }
+    qDebug() << "Task:" << taskId << " Status:" << status << " Progress:" << progress << " Message:" << taskObj["message"].toString();
+
+    // [新增] 终态归还提交时占用的准入名额
+    if (isTerminalStatus(status)) {
+        m_admission->taskEnded(taskId);
     }
 
-    reply->deleteLater();
+    if (status == "finished") {
+        // 任务完成，提取 result 字段
+        QVariantMap resultMap = taskObj["result"].toObject().toVariantMap();
+        emit taskResultReceived(taskId, resultMap);
+    } else if (isTerminalStatus(status)) {
+        // [新增] 失败/取消：按请求失败上报，ViewModel 停止轮询并清理任务
+        const QString message = taskObj["message"].toString();
+        emit taskRequestFailed(taskId, message.isEmpty() ? QString("任务状态: %1").arg(status) : message);
+    } else {
+        // 任务进行中
+        emit taskStatusReceived(taskId, progress, status, taskObj["message"].toString());
+    }
+}
+
+void NetworkManager::readQueueDepth(QNetworkReply *reply, const QJsonObject &json)
+{
+    int depth = AdmissionController::queueDepthHeader(reply);
+    if (depth < 0 && json.contains("queue_depth")) {
+        depth = json["queue_depth"].toInt();
+    }
+    if (depth >= 0) {
+        m_admission->reportQueueDepth(depth);
+    }
 }
@@ -2,12 +2,17 @@
 #define NETWORKMANAGER_H
 
 #include <QObject>
+#include <QHash>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QString>
+#include <QStringList>
 #include <QUrl>
 #include <QVariantMap>
 #include <QVariantList>
+#include <QJsonObject>
+
+class AdmissionController;
 
 class NetworkManager : public QObject
 {
@@ -17,7 +22,9 @@ public:
 
     // --- 1. 项目创建 (Direct / projects API) ---
     // 负责创建项目并获取所有 Task IDs
-    void createProjectDirect(const QString &title, const QString &storyText, const QString &style, const QString &description);
+    // [新增] tag 由调用方指定，原样随 textTaskCreated 返回 (章节模式用于区分并行提交的子项目)
+    void createProjectDirect(const QString &title, const QString &storyText, const QString &style, const QString &description,
+                             const QString &tag = QString());
 
     // --- 2. 资源获取 API (项目/分镜数据) ---
     // [新增] 获取分镜列表，用于文本任务完成后
@@ -26,17 +33,42 @@ public:
     // --- 3. 任务 API 请求 (异步 / tasks API) ---
     void updateShotRequest(const QString &projectId, const QString &shotId, const QString &prompt, const QString &style);
     void generateVideoRequest(const QString &projectId);
+    // [新增] 整个项目的旁白配音 (POST /v1/projects/{id}/tts)，voice 为空时由服务端选默认音色
+    void generateTtsRequest(const QString &projectId, const QString &voice = QString());
 
     // --- 4. 任务状态查询 API ---
     void pollTaskStatus(const QString &taskId);
 
+    // [新增] 长轮询 (GET /tasks/{id}?wait=N&since=<updated_at>)：每个任务保持一个挂起的请求，
+    // 服务端在任务变化或超时后返回，收到后立即发出下一个，进度几乎无延迟且没有固定的 1 秒轮询。
+    // STV_TASK_TRANSPORT=poll|longpoll|auto，默认 auto：响应带 X-Long-Poll 头才继续使用，
+    // 服务端不支持，或代理 (FRP 等) 反复掐断挂起的连接时，退回定时轮询 pollTaskStatus()
+    bool isLongPolling() const { return m_transport == LongPolling; }
+    void watchTask(const QString &taskId);
+    void unwatchTask(const QString &taskId);
+
+    // [新增] 视频任务请求的分辨率 (耗时模型也以此为特征)
+    static QString videoResolution() { return QStringLiteral("1920x1080"); }
+    // [新增] 同时请求的播放档位 (含最高档)；预览按带宽选择，导出始终使用 videoResolution()
+    static QStringList videoRenditionLadder()
+    {
+        return { QStringLiteral("1920x1080"), QStringLiteral("1280x720"), QStringLiteral("854x480"), QStringLiteral("640x360") };
+    }
+
+    // [新增] 任务优先级提示 (taskId -> 优先级，数值越小越先执行)；尽力而为，失败只记日志
+    void updateTaskPriorities(const QVariantMap &priorities);
+
 
 signals:
     // [修改] 1. 文本任务创建成功信号：返回 ProjectID 和所有 Task IDs
-    void textTaskCreated(const QString &projectId, const QString &textTaskId, const QVariantList &shotTaskIds);
+    void textTaskCreated(const QString &projectId, const QString &textTaskId, const QVariantList &shotTaskIds,
+                         const QString &tag = QString());
 
     // [保留] 2. 业务请求成功并返回 task_id (用于分镜重生成/视频)
-    void taskCreated(const QString &taskId, const QString &shotId = QString());
+    // 视频任务同时返回其所属的 projectId
+    void taskCreated(const QString &taskId, const QString &shotId = QString(), const QString &projectId = QString());
+    // [新增] 配音任务已创建
+    void ttsTaskCreated(const QString &taskId, const QString &projectId);
 
     // [保留] 3. 任务状态更新 (用于轮询)
     void taskStatusReceived(const QString &taskId, int progress, const QString &status, const QString &message);
@@ -51,16 +83,53 @@ signals:
     void taskRequestFailed(const QString &taskId, const QString &errorMsg);
     void networkError(const QString &errorMsg);
 
+    // [新增] 7. 服务端过载 (429/503)，提交已暂停并将在 retryAfterSeconds 后自动重试
+    void submissionThrottled(int retryAfterSeconds);
+
 private slots:
     void onNetworkReplyFinished(QNetworkReply *reply);
 
 private:
+    enum TaskTransport {
+        TimerPolling,
+        LongPolling
+    };
+    struct Watch {
+        QNetworkReply *reply = nullptr;   // 挂起中的长轮询请求
+        QString since;                    // 上次看到的 updated_at
+        int failures = 0;
+    };
+
+    // [新增] 长轮询
+    void sendLongPoll(const QString &taskId);
+    void rearmLongPoll(const QString &taskId, int delayMs);
+    void handleLongPollReply(QNetworkReply *reply);
+    void fallBackToTimerPolling(const QString &reason);
+    // 任务对象 -> taskStatusReceived / taskResultReceived (定时轮询与长轮询共用)
+    void handleTaskObject(const QString &taskId, const QJsonObject &taskObj);
+    static bool isTerminalStatus(const QString &status);   // finished / failed / error / cancelled
+
+    // [新增] 服务端队列深度提示：响应头 X-Queue-Depth 或 JSON 字段 queue_depth
+    void readQueueDepth(QNetworkReply *reply, const QJsonObject &json);
+
     QNetworkAccessManager *m_networkManager;
+    // [新增] 提交类请求的准入队列 (AIMD 窗口 + Retry-After)
+    AdmissionController *m_admission;
+    // [新增] 轮询被限流时，在此时间 (ms) 之前跳过任务查询
+    qint64 m_pollNotBefore;
+
+    // [新增] 任务状态传输方式
+    TaskTransport m_transport;
+    bool m_transportConfirmed;        // auto 模式下服务端已确认支持 wait
+    bool m_transportForced;           // STV_TASK_TRANSPORT=longpoll：不自动退回定时轮询
+    int m_longPollWaitSeconds;
+    QHash<QString, Watch> m_watches;  // taskId -> 长轮询状态
 
     // 通过本地 FRP visitor 访问真实服务端 (172.23.197.68:18080 -> 云端 Gateway 8080)
     // 云端 Gateway 路径: /v1/projects, /tasks/{id} (查询任务状态)
-    const QUrl PROJECT_API_URL = QUrl("http://172.23.197.68:18080/v1/projects");
-    const QUrl TASK_API_BASE_URL = QUrl("http://172.23.197.68:18080/tasks");
+    // [修改] 环境变量 STV_GATEWAY_URL 可指向其他 Gateway (例如本地 mock-server 做浸泡测试)
+    QUrl PROJECT_API_URL;
+    QUrl TASK_API_BASE_URL;
 
     enum RequestType {
         CreateProjectDirect = 1,
@@ -68,7 +137,12 @@ private:
         GenerateVideo = 3,
         PollStatus = 4,
         // [新增] 资源获取类型
-        GetShotList = 5
+        GetShotList = 5,
+        UpdatePriority = 6,
+        // [新增] 配音任务
+        GenerateTts = 7,
+        // [新增] 长轮询任务状态
+        LongPoll = 8
     };
 };
 
@@ -18,6 +18,16 @@ Page {
 
     property string projectId: ""
     property string videoSource: ""
+    // 远程原始地址；本地缓存完成后 videoSource 会切换为 file:// 地址
+    property string remoteSource: ""
+
+    // [新增] 自适应码率：未缓存时播放按带宽选择的档位 (为空表示直接播放 videoSource)。
+    // 每到一个分段边界重新评估，卡顿时立即降档；导出仍使用 remoteSource (最高档)
+    property string renditionUrl: ""
+    property string renditionInfo: ""
+    property int renditionSegmentMs: 4000
+    property int renditionSegment: -1
+    property bool renditionSwitching: false
 
     title: "成品预览 (" + projectId + ")"
 
@@ -25,6 +35,85 @@ Page {
     Component.onCompleted: {
         console.log("PreviewPage loaded, videoSource:", videoSource);
         console.log("Available multimedia backends:", QtMultimedia.availableBackends);
+        startAdaptivePlayback();
+    }
+
+    // 页面池复用时属性经 push 逐个设置，等全部设置完再选择起播档位
+    onRemoteSourceChanged: Qt.callLater(startAdaptivePlayback)
+
+    function startAdaptivePlayback() {
+        renditionSegment = -1;
+        renditionSwitching = false;
+        // 已是本地缓存或本地文件时不需要自适应
+        var choice = (projectId.length > 0 && remoteSource.length > 0 && videoSource === remoteSource)
+                ? viewModel.selectRendition(projectId, "", false) : ({});
+        renditionUrl = choice.url || "";
+        renditionInfo = choice.url ? describeRendition(choice) : "";
+        if (choice.url) {
+            // 缺少分段长度 (或为 0) 时沿用默认的 4 秒，避免 position / 0 后不再切换档位
+            renditionSegmentMs = (choice.segmentSeconds > 0 ? choice.segmentSeconds : 4) * 1000;
+            console.log("PreviewPage: 起播档位", renditionInfo);
+        }
+    }
+
+    function describeRendition(choice) {
+        return qsTr("%1 · %2 kbps").arg(choice.resolution).arg(choice.bitrateKbps)
+                + (choice.estimateKbps > 0 ? qsTr(" (带宽约 %1 kbps)").arg(Math.round(choice.estimateKbps)) : "");
+    }
+
+    // 切换档位并保持播放位置 (与切换到本地缓存相同的做法)
+    function applyRendition(choice) {
+        if (!choice.url || choice.url === renditionUrl) return;
+        var position = videoPlayer.position;
+        var wasPlaying = videoPlayer.playbackState === MediaPlayer.PlayingState;
+        renditionSwitching = true;
+        renditionUrl = choice.url;
+        renditionInfo = describeRendition(choice);
+        console.log("PreviewPage: 切换档位", renditionInfo);
+        if (position > 0) {
+            videoPlayer.setPosition(position);
+        }
+        if (wasPlaying) {
+            videoPlayer.play();
+        }
+    }
+
+    // [新增] 页面池：由 pagePreloader 预创建的实例出栈后回收，下次 push 直接复用 MediaPlayer/VideoOutput
+    StackView.onRemoved: pagePreloader.release(previewPage)
+
+    // 回收前清空本次预览的状态 (由 PagePreloader 调用)
+    function resetForReuse() {
+        videoPlayer.stop();
+        renditionUrl = "";
+        renditionInfo = "";
+        videoSource = "";
+        remoteSource = "";
+        projectId = "";
+        exportButton.isExporting = false;
+        exportButton.text = qsTr("导出视频");
+    }
+
+    Connections {
+        target: viewModel
+
+        onMediaCached: {
+            if (remoteSource.length === 0 || url !== remoteSource || videoSource === localUrl) return;
+
+            // 切换到本地文件并保持播放位置
+            var position = videoPlayer.position;
+            var wasPlaying = videoPlayer.playbackState === MediaPlayer.PlayingState;
+            console.log("PreviewPage: 切换到本地缓存", localUrl);
+            videoSource = localUrl;
+            // 本地文件是最高档，不再需要自适应
+            renditionUrl = "";
+            renditionInfo = "";
+            if (position > 0) {
+                videoPlayer.setPosition(position);
+            }
+            if (wasPlaying) {
+                videoPlayer.play();
+            }
+        }
     }
 
     Rectangle {
@@ -100,7 +189,7 @@ Page {
             // 【关键修改】在 Qt 5.8 中，有时需要先创建 MediaPlayer，再创建 VideoOutput
             MediaPlayer {
                 id: videoPlayer
-                source: videoSource
+                source: renditionUrl.length > 0 ? renditionUrl : videoSource
 
                 // 添加事件监听用于调试
                 onErrorOccurred: console.error("MediaPlayer error:", error, errorString)
@@ -109,6 +198,23 @@ Page {
                     if (mediaStatus === MediaPlayer.LoadedMedia) {
                         console.log("视频已加载，时长:", duration, "ms");
                     }
+                    // [新增] 卡顿立即降档；切换档位本身引起的缓冲不算
+                    if (mediaStatus === MediaPlayer.LoadedMedia || mediaStatus === MediaPlayer.BufferedMedia) {
+                        renditionSwitching = false;
+                    } else if (mediaStatus === MediaPlayer.StalledMedia && renditionUrl.length > 0 && !renditionSwitching) {
+                        applyRendition(viewModel.selectRendition(projectId, renditionUrl, true));
+                    }
+                }
+                // [新增] 分段边界：按最新的带宽估计决定升/降档
+                onPositionChanged: {
+                    if (renditionUrl.length === 0 || renditionSegmentMs <= 0 || playbackState !== MediaPlayer.PlayingState) return;
+                    var segment = Math.floor(position / renditionSegmentMs);
+                    if (segment === renditionSegment) return;
+                    var first = renditionSegment < 0;
+                    renditionSegment = segment;
+                    if (!first && !renditionSwitching) {
+                        applyRendition(viewModel.selectRendition(projectId, renditionUrl, false));
+                    }
                 }
                 onHasVideoChanged: console.log("Has video:", hasVideo)
                 onHasAudioChanged: console.log("Has audio:", hasAudio)
@@ -200,7 +306,7 @@ Page {
         // 添加格式信息显示
         Rectangle {
             Layout.fillWidth: true
-            Layout.preferredHeight: 60
+            Layout.preferredHeight: renditionInfo.length > 0 ? 80 : 60
             color: macCard
             radius: 12
             border.color: macBorder
@@ -231,6 +337,15 @@ Page {
                     font.family: macBodyFont
                     color: macTextSecondary
                 }
+
+                // [新增] 当前播放档位
+                Text {
+                    visible: renditionInfo.length > 0
+                    text: qsTr("播放档位: %1").arg(renditionInfo)
+                    font.pointSize: 11
+                    font.family: macBodyFont
+                    color: macTextSecondary
+                }
             }
         }
 
@@ -280,30 +395,38 @@ Page {
                         isExporting = true;
                         exportButton.text = qsTr("导出中...");
                         console.log("启动视频文件导出功能...");
-                        
-                        // 调用 C++ 导出方法 (如果有)
-                        if (viewModel && viewModel.exportVideo) {
-                            viewModel.exportVideo(projectId, videoSource);
-                        } else {
-                            // 模拟导出完成
-                            exportTimer.start();
-                        }
+                        // 优先导出远程原始地址 (最高档，与当前播放档位无关) 对应的缓存文件；本地草稿直接使用 file:// 地址
+                        viewModel.exportVideo(projectId, remoteSource.length > 0 ? remoteSource : videoSource);
                     }
                 }
             }
         }
+    }
+    }
 
-        // 模拟导出完成的定时器
-        Timer {
-            id: exportTimer
-            interval: 2000
-            onTriggered: {
-                exportButton.isExporting = false;
-                exportButton.text = qsTr("导出视频");
-                exportSuccessDialog.open();
-            }
+    Connections {
+        target: viewModel
+
+        onExportProgress: {
+            if (projectId !== previewPage.projectId) return;
+            exportButton.text = qsTr("导出中... %1%").arg(percent);
+        }
+
+        onExportFinished: {
+            if (projectId !== previewPage.projectId) return;
+            exportButton.isExporting = false;
+            exportButton.text = qsTr("导出视频");
+            exportSuccessDialog.filePath = filePath;
+            exportSuccessDialog.open();
+        }
+
+        onExportFailed: {
+            if (projectId !== previewPage.projectId) return;
+            exportButton.isExporting = false;
+            exportButton.text = qsTr("导出视频");
+            exportFailedDialog.errorText = errorMsg;
+            exportFailedDialog.open();
         }
-    }
     }
 
     // 导出成功对话框
@@ -314,8 +437,27 @@ Page {
         anchors.centerIn: parent
         standardButtons: Dialog.Ok
 
+        property string filePath: ""
+
+        Label {
+            text: qsTr("视频已成功导出到本地！\n\n文件位置: %1").arg(exportSuccessDialog.filePath)
+            wrapMode: Text.WordWrap
+            width: 280
+        }
+    }
+
+    // 导出失败对话框
+    Dialog {
+        id: exportFailedDialog
+        title: qsTr("导出失败")
+        modal: true
+        anchors.centerIn: parent
+        standardButtons: Dialog.Ok
+
+        property string errorText: ""
+
         Label {
-            text: qsTr("视频已成功导出到本地！\n\n文件位置: ~/Downloads/")
+            text: exportFailedDialog.errorText
             wrapMode: Text.WordWrap
             width: 280
         }
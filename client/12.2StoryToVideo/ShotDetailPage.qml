@@ -29,6 +29,9 @@ Page {
     // 使用属性值作为页面标题
     title: qsTr("分镜详情")
 
+    // [新增] 由 pagePreloader 预创建的实例出栈后交还销毁 (并在空闲时预创建下一个)
+    StackView.onRemoved: pagePreloader.release(shotDetailPage)
+
     // 假设可用的转场效果列表
     readonly property var transitionModels: ["cut", "fade", "wipe", "zoom", "dissolve", "crossfade"]
 
@@ -13,12 +13,63 @@ SOURCES += main.cpp \
     ViewModel.cpp \
     NetworkManager.cpp \
     datamanager.cpp \
-    videoexporter.cpp
+    videoexporter.cpp \
+    taskexecutor.cpp \
+    imagescaler.cpp \
+    thumbnailprovider.cpp \
+    imagehash.cpp \
+    assetindex.cpp \
+    localvideorenderer.cpp \
+    mediacache.cpp \
+    exportmanager.cpp \
+    streamdigest.cpp \
+    storysplitter.cpp \
+    mediaworkerclient.cpp \
+    metrics.cpp \
+    soaktest.cpp \
+    etamodel.cpp \
+    admissioncontroller.cpp \
+    peercache.cpp \
+    deltasync.cpp \
+    waveformpeaks.cpp \
+    sessionsnapshot.cpp \
+    pagepreloader.cpp \
+    blurhash.cpp \
+    orderkey.cpp \
+    adaptivebitrate.cpp \
+    localhttp.cpp \
+    commandline.cpp
 # C++ 头文件
 HEADERS += ViewModel.h \
     NetworkManager.h \
     datamanager.h \
-    videoexporter.h
+    videoexporter.h \
+    taskexecutor.h \
+    imagescaler.h \
+    thumbnailprovider.h \
+    imagehash.h \
+    assetindex.h \
+    localvideorenderer.h \
+    mediacache.h \
+    exportmanager.h \
+    streamdigest.h \
+    storysplitter.h \
+    mediaworkerclient.h \
+    mediaworkerprotocol.h \
+    metrics.h \
+    soaktest.h \
+    etamodel.h \
+    admissioncontroller.h \
+    peercache.h \
+    deltasync.h \
+    waveformpeaks.h \
+    sessionsnapshot.h \
+    pagepreloader.h \
+    blurhash.h \
+    orderkey.h \
+    adaptivebitrate.h \
+    localhttp.h \
+    commandline.h
 
 RESOURCES += qml.qrc
 
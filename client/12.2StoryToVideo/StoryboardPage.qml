@@ -21,6 +21,8 @@ Page {
     // 状态属性：用于控制视频生成进度和按钮状态
     property bool isVideoGenerating: false
     property string videoStatusMessage: ""
+    property string videoEtaText: ""
+    property bool isDraftExporting: false
 
     // 基础常量：API 地址前缀
     readonly property string apiBaseUrl: "http://119.45.124.222:8080"
@@ -35,6 +37,9 @@ Page {
     // 【核心修复】接收 StackView 的引用 (需要 CreatePage.qml 传递 pageStack)
     property var stackViewRef: null
 
+    // [新增] 由 main.qml 从上次会话快照恢复：先显示快照，再后台向服务端刷新分镜
+    property bool restoredFromSnapshot: false
+
     // ----------------------------------------------------
     // 2. 数据模型
     // ----------------------------------------------------
@@ -57,6 +62,12 @@ Page {
             } else {
                 console.warn("Component.onCompleted: shotsData 为空。");
             }
+            if (restoredFromSnapshot) {
+                viewModel.refreshProject(storyId);
+            }
+            // [新增] 下一步可能打开的页面在空闲时预创建，点击时直接 push 现成实例
+            pagePreloader.preload(Qt.resolvedUrl("ShotDetailPage.qml"));
+            pagePreloader.preload(Qt.resolvedUrl("PreviewPage.qml"));
             console.log("DEBUG CHECK: Now defining the ViewModel signal CONNECTIONS block.");
         }
 
@@ -80,17 +91,62 @@ Page {
                         console.log("QML DEBUG A2: Project ID Match (Signal ID === Page ID).");
 
                         storyboardPage.isVideoGenerating = (percent < 100);
-                        storyboardPage.videoStatusMessage = qsTr("视频合成中 (%1)...").arg(percent);
+                        storyboardPage.videoStatusMessage = qsTr("视频合成中 (%1%)...").arg(percent) + storyboardPage.videoEtaText;
 
-                        if (percent === 100) {
-                            console.log("QML DEBUG A2: Compilation reached 100%. Calling displayVideoResource...");
-                            displayVideoResource(storyId); // 使用隐式 storyId
-                        }
+                        // 100% 后的跳转由 onVideoResourceReady 负责 (携带真实资源 URL)
                     } else {
                         console.warn("QML WARNING A2: Project ID Mismatch. Ignoring signal.");
                     }
                 }
 
+                // [新增] 历史耗时模型给出的剩余时间，附在合成进度后面
+                onCompilationEta: {
+                    if (storyId !== storyboardPage.storyId) return;
+                    if (secondsRemaining < 0) {
+                        storyboardPage.videoEtaText = "";
+                    } else if (secondsRemaining >= 60) {
+                        storyboardPage.videoEtaText = qsTr("，约 %1 分钟").arg(Math.ceil(secondsRemaining / 60));
+                    } else {
+                        storyboardPage.videoEtaText = qsTr("，约 %1 秒").arg(secondsRemaining);
+                    }
+                }
+
+                onVideoResourceReady: {
+                    if (storyId === storyboardPage.storyId) {
+                        console.log("QML DEBUG A3: Video resource ready:", videoUrl);
+                        displayVideoResource(storyId, videoUrl);
+                    }
+                }
+
+                // [新增] 本地草稿导出
+                onDraftExportProgress: {
+                    if (storyId === storyboardPage.storyId) {
+                        storyboardPage.videoStatusMessage = qsTr("本地草稿导出中 (%1%)...").arg(percent);
+                    }
+                }
+
+                onDraftExportFinished: {
+                    if (storyId !== storyboardPage.storyId) return;
+                    storyboardPage.isDraftExporting = false;
+                    storyboardPage.videoStatusMessage = qsTr("本地草稿导出成功");
+                    pageStack.push(pagePreloader.page(Qt.resolvedUrl("PreviewPage.qml")), {
+                        videoSource: videoUrl,
+                        projectId: storyId
+                    });
+                }
+
+                onDraftExportCancelled: {
+                    if (storyId !== storyboardPage.storyId) return;
+                    storyboardPage.isDraftExporting = false;
+                    storyboardPage.videoStatusMessage = qsTr("本地草稿导出已取消");
+                }
+
+                onDraftExportFailed: {
+                    if (storyId !== storyboardPage.storyId) return;
+                    storyboardPage.isDraftExporting = false;
+                    storyboardPage.videoStatusMessage = qsTr("本地草稿导出失败: %1").arg(errorMsg);
+                }
+
                 onGenerationFailed: {
                     storyboardPage.isVideoGenerating = false;
                     storyboardPage.videoStatusMessage = qsTr("生成失败: %1").arg(errorMsg);
@@ -162,12 +218,27 @@ Page {
 
         // ========== 分镜列表 (GridView) ==========
         GridView {
+            id: shotGrid
             Layout.fillWidth: true
             Layout.fillHeight: true
             model: storyboardModel
             cellWidth: 320
             cellHeight: 320
 
+            // 上报可见分镜区间，服务端优先生成用户正在看的分镜图片
+            function reportVisibleShots() {
+                if (count === 0 || storyId.length === 0 || width <= 0) return;
+                var columns = Math.max(1, Math.floor(width / cellWidth));
+                var first = Math.floor(contentY / cellHeight) * columns;
+                var last = Math.ceil((contentY + height) / cellHeight) * columns - 1;
+                viewModel.setVisibleShotRange(storyId, Math.max(0, first), Math.min(count - 1, last));
+            }
+
+            onContentYChanged: reportVisibleShots()
+            onHeightChanged: reportVisibleShots()
+            onWidthChanged: reportVisibleShots()
+            onCountChanged: reportVisibleShots()
+
             delegate: Item {
                 width: GridView.view.cellWidth
                 height: GridView.view.cellHeight
@@ -185,7 +256,7 @@ Page {
                         anchors.fill: parent
                         onClicked: {
                             // [核心修复] 显式构造对象，并使用 pageStack.push()
-                            pageStack.push(Qt.resolvedUrl("ShotDetailPage.qml"), {
+                            pageStack.push(pagePreloader.page(Qt.resolvedUrl("ShotDetailPage.qml")), {
                                 shotData: {
                                     shotId: model.shotId,
                                     shotOrder: model.shotOrder,
@@ -217,23 +288,51 @@ Page {
                                     Layout.fillWidth: true
                                 }
 
+                                // [新增] 调整分镜顺序 (前移/后移一位)
+                                ToolButton {
+                                    text: "‹"
+                                    enabled: index > 0
+                                    onClicked: moveShot(index, index - 1)
+                                }
+                                ToolButton {
+                                    text: "›"
+                                    enabled: index < storyboardModel.count - 1
+                                    onClicked: moveShot(index, index + 1)
+                                }
+
                                 // 2. 图像预览区
                                 Rectangle {
                                     Layout.preferredWidth: 100
                                     Layout.preferredHeight: 100
                                     color: "#ECEFF1"
 
+                                    // [新增] BlurHash 占位图：同步解码，首帧即显示；完整图片就绪后淡出
                                     Image {
+                                        source: model.placeholderUrl
+                                        anchors.fill: parent
+                                        fillMode: Image.PreserveAspectFit
+                                        asynchronous: false
+                                        sourceSize.width: 32
+                                        sourceSize.height: 32
+                                        smooth: true
+                                        visible: source != "" && shotImage.opacity < 1
+                                    }
+
+                                    Image {
+                                        id: shotImage
                                         source: model.imageUrl
                                         anchors.fill: parent
                                         fillMode: Image.PreserveAspectFit
+                                        asynchronous: true
+                                        opacity: status === Image.Ready ? 1 : 0
+                                        Behavior on opacity { NumberAnimation { duration: 250 } }
                                     }
                                 }
                             }
 
                             // 3. 分镜序号和描述
                             Text {
-                                text: qsTr("分镜 %1: %2").arg(model.shotOrder).arg(model.shotTitle)
+                                text: qsTr("分镜 %1: %2").arg(index + 1).arg(model.shotTitle)
                                 font.bold: true
                                 font.family: macTitleFont
                                 color: macTextPrimary
@@ -297,6 +396,39 @@ Page {
             }
         }
 
+        // [新增] 本地草稿导出 (低分辨率，本机 ffmpeg 编码，不占用服务端 GPU)
+        RowLayout {
+            Layout.fillWidth: true
+            spacing: 10
+            visible: viewModel.isLocalExportAvailable()
+
+            Button {
+                text: isDraftExporting ? qsTr("本地导出中...") : qsTr("本地快速预览 (草稿)")
+                Layout.fillWidth: true
+                Layout.preferredHeight: 36
+                enabled: !isDraftExporting && !isVideoGenerating && storyboardModel.count > 0
+                font.family: macBodyFont
+                onClicked: {
+                    var shots = [];
+                    for (var i = 0; i < storyboardModel.count; i++) {
+                        var item = storyboardModel.get(i);
+                        shots.push({ imageUrl: item.imageUrl, transition: item.transition });
+                    }
+                    isDraftExporting = true;
+                    videoStatusMessage = qsTr("本地草稿导出中...");
+                    viewModel.exportDraftVideo(storyId, shots);
+                }
+            }
+
+            Button {
+                text: qsTr("取消")
+                Layout.preferredHeight: 36
+                visible: isDraftExporting
+                font.family: macBodyFont
+                onClicked: viewModel.cancelDraftExport(storyId)
+            }
+        }
+
         // 状态消息显示
         Label {
             text: videoStatusMessage
@@ -349,6 +481,8 @@ Page {
                 shotPrompt: shot.prompt,
                 status: shot.status,
                 imageUrl: fullImageUrl,
+                placeholderUrl: shot.placeholderUrl || "",
+                orderKey: shot.orderKey || "",
                 transition: shot.transition
             });
         }
@@ -357,10 +491,44 @@ Page {
         storyboardPage.title = qsTr("故事板预览: %1").arg(storyTitle);
     }
 
+    // [新增] 分镜重排：只有被移动的分镜获得新的排序键，本地项目文件只追加一条排序记录
+    function moveShot(from, to) {
+        if (to < 0 || to >= storyboardModel.count) return;
+        var shotId = storyboardModel.get(from).shotId;
+        var result = viewModel.moveShot(storyId, shotId, to);
+        if (!result.orderKeys) return;
+
+        storyboardModel.move(from, to, 1);
+        var keys = result.orderKeys;
+        for (var i = 0; i < storyboardModel.count; i++) {
+            var key = keys[storyboardModel.get(i).shotId];
+            if (key !== undefined) {
+                storyboardModel.setProperty(i, "orderKey", key);
+            }
+        }
+
+        var fileName = "project_" + storyId + ".json";
+        if (!result.rebalanced) {
+            dataManager.saveShotOrder(fileName, shotId, keys[shotId]);
+            return;
+        }
+        // 排序键整体重排 (很少发生)：项目文件整体保存一次
+        var project = dataManager.loadData(fileName);
+        if (!project.shots) return;
+        for (var j = 0; j < project.shots.length; j++) {
+            var shot = project.shots[j];
+            var newKey = keys[shot.id || shot.shotId];
+            if (newKey !== undefined) {
+                shot.orderKey = newKey;
+            }
+        }
+        dataManager.saveData(project, fileName);
+    }
+
     // *** 视频合成完成后的跳转函数 (使用 stackViewRef) ***
-    function displayVideoResource(projectId) {
-        // 构造视频资源的 URL
-        var videoUrl = apiBaseUrl + "/static/tasks/123/proj-test-0001.mp4";
+    function displayVideoResource(projectId, remoteUrl) {
+        // 已缓存则直接使用本地文件，否则先播放远程地址，缓存完成后 PreviewPage 自动切换
+        var videoUrl = viewModel.cachedMediaUrl(remoteUrl);
 
         // --- DIAGNOSTIC LOG 1: Function Entry ---
         console.log("NAV DEBUG 1: Display resource function entered. Project:", projectId);
@@ -377,8 +545,9 @@ Page {
 
                 try {
                     // 使用传递进来的 StackView 引用进行 push
-                    stackViewRef.push(Qt.resolvedUrl("PreviewPage.qml"), {
+                    stackViewRef.push(pagePreloader.page(Qt.resolvedUrl("PreviewPage.qml")), {
                         videoSource: videoUrl,
+                        remoteSource: remoteUrl,
                         projectId: projectId
                     });
                     console.log("✅ NAV SUCCESS: PreviewPage push succeeded.");
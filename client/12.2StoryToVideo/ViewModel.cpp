@@ -1,5 +1,15 @@
 #include "ViewModel.h"
 #include "NetworkManager.h"
+#include "localvideorenderer.h"
+#include "mediacache.h"
+#include "exportmanager.h"
+#include "storysplitter.h"
+#include "metrics.h"
+#include "etamodel.h"
+#include "taskexecutor.h"
+#include "blurhash.h"
+#include "orderkey.h"
+#include "datamanager.h"
 #include <QDebug>
 #include <QDateTime>
 #include <QTimer>
@@ -10,7 +20,18 @@
 #include <QUrl>
 #include <QCoreApplication>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QVariantList>
+#include <QStandardPaths>
+#include <QGuiApplication>
+#include <QWindow>
+#include <QEvent>
+
+// [新增] 本地渲染器的任务 ID 带类型前缀：同一个 storyId 可能同时有草稿导出和章节成片拼接，
+// 裸 ID 会互相顶替 (render/concatFiles 遇到同 ID 会取消旧任务)，回调也无法区分
+static const QString DraftJobPrefix = QStringLiteral("draft:");
+static const QString ConcatJobPrefix = QStringLiteral("concat:");
 
 
 // ==========================================================
@@ -31,6 +52,8 @@ ViewModel::ViewModel(QObject *parent) : QObject(parent)
 
     connect(m_networkManager, &NetworkManager::taskCreated,
             this, &ViewModel::handleTaskCreated);
+    connect(m_networkManager, &NetworkManager::ttsTaskCreated,
+            this, &ViewModel::handleTtsTaskCreated);
     connect(m_networkManager, &NetworkManager::taskStatusReceived,
             this, &ViewModel::handleTaskStatusReceived);
     connect(m_networkManager, &NetworkManager::taskResultReceived,
@@ -41,9 +64,112 @@ ViewModel::ViewModel(QObject *parent) : QObject(parent)
     // [重要] ViewModel 监听 networkError 并转发为 generationFailed
     connect(m_networkManager, &NetworkManager::networkError,
             this, &ViewModel::handleNetworkError);
+    connect(m_networkManager, &NetworkManager::submissionThrottled,
+            this, &ViewModel::submissionDelayed);
 
     connect(m_pollingTimer, &QTimer::timeout, this, &ViewModel::pollCurrentTask);
-    m_pollingTimer->setInterval(1000); // 每 1 秒轮询一次
+    m_pollingTimer->setInterval(ForegroundPollIntervalMs); // 每 1 秒轮询一次
+
+    // 应用切到后台 (其他应用获得焦点不算) 时放慢轮询
+    m_inBackground = false;
+    if (qGuiApp) {
+        connect(qGuiApp, &QGuiApplication::applicationStateChanged,
+                this, &ViewModel::updateBackgroundState);
+    }
+
+    // 滚动过程中可见区间变化频繁，250ms 内合并为一次请求
+    m_visibleFirst = -1;
+    m_visibleLast = -1;
+    m_priorityTimer = new QTimer(this);
+    m_priorityTimer->setSingleShot(true);
+    m_priorityTimer->setInterval(250);
+    connect(m_priorityTimer, &QTimer::timeout, this, &ViewModel::sendPriorityHints);
+
+    // 本地媒体缓存：视频任务完成后立即预取，预览/导出读本地文件
+    m_mediaCache = new MediaCache(this);
+    connect(m_mediaCache, &MediaCache::cached,
+            this, [this](const QString &url, const QString &localPath) {
+        emit mediaCached(url, QUrl::fromLocalFile(localPath).toString());
+        onChapterVideoCached(url, localPath);
+        onNarrationCached(url, localPath);
+    });
+    // [新增] 成片预取的下载进度同时作为带宽样本
+    m_abr = new AdaptiveBitrate(this);
+    connect(m_mediaCache, &MediaCache::downloadProgress, m_abr, &AdaptiveBitrate::addProgress);
+    connect(m_mediaCache, &MediaCache::downloadFailed,
+            this, [this](const QString &url, const QString &errorMsg) {
+        for (const ChapterProject &project : m_chapterProjects) {
+            if (project.videoUrls.contains(url)) {
+                emit generationFailed(QString("章节视频下载失败: %1").arg(errorMsg));
+            }
+        }
+    });
+
+    // 历史耗时模型 (跨会话保存)
+    m_etaModel = new EtaModel(this);
+
+    // 本地项目文件：收到故事板时写入，之后的重排只在排序日志里追加 (StoryboardPage::moveShot)
+    m_projectFiles = new DataManager(this);
+
+    // [新增] 热启动快照：记住当前故事板，并把分镜图片预取进媒体缓存，下次启动不走网络即可显示
+    connect(this, &ViewModel::storyboardGenerated, this, [this](const QVariant &storyData) {
+        rememberStoryboard(storyData.toMap());
+    });
+    connect(this, &ViewModel::imageGenerationFinished, this, &ViewModel::rememberShotImage);
+
+    // 导出队列 (exportId 即 projectId)
+    m_exportManager = new ExportManager(m_mediaCache, this);
+    connect(m_exportManager, &ExportManager::exportProgress, this, &ViewModel::exportProgress);
+    connect(m_exportManager, &ExportManager::exportFinished,
+            this, [this](const QString &projectId, const QString &filePath, const QString &method) {
+        qDebug() << "视频导出完成:" << projectId << filePath << "方式:" << method;
+        emit exportFinished(projectId, filePath);
+    });
+    connect(m_exportManager, &ExportManager::exportFailed, this, &ViewModel::exportFailed);
+
+    // [新增] 抓取时才求值的任务状态指标
+    Metrics::instance()->gauge("stv_tasks_active", "Server tasks currently tracked and polled by the client.",
+                               this, [this]() { return double(m_activeTasks.size()); });
+    Metrics::instance()->gauge("stv_poll_interval_seconds", "Current task polling interval.",
+                               this, [this]() { return m_pollingTimer->interval() / 1000.0; });
+
+    // 本地草稿渲染 (jobId 为 "draft:<storyId>")
+    m_localRenderer = new LocalVideoRenderer(this);
+    // 章节模式的成片拼接也复用该渲染器 (jobId 为 "concat:<逻辑项目 ID>")
+    connect(m_localRenderer, &LocalVideoRenderer::renderProgress,
+            this, [this](const QString &jobId, int percent) {
+        if (jobId.startsWith(ConcatJobPrefix)) {
+            emit compilationProgress(jobId.mid(ConcatJobPrefix.size()), qMin(99, 95 + percent / 20));
+        } else if (jobId.startsWith(DraftJobPrefix)) {
+            emit draftExportProgress(jobId.mid(DraftJobPrefix.size()), percent);
+        }
+    });
+    connect(m_localRenderer, &LocalVideoRenderer::renderFinished,
+            this, [this](const QString &jobId, const QString &outputPath) {
+        const QString videoUrl = QUrl::fromLocalFile(outputPath).toString();
+        if (jobId.startsWith(ConcatJobPrefix)) {
+            const QString storyId = jobId.mid(ConcatJobPrefix.size());
+            qDebug() << "章节成片拼接完成:" << storyId << outputPath;
+            emit compilationProgress(storyId, 100);
+            emit videoResourceReady(storyId, videoUrl);
+        } else if (jobId.startsWith(DraftJobPrefix)) {
+            emit draftExportFinished(jobId.mid(DraftJobPrefix.size()), videoUrl);
+        }
+    });
+    connect(m_localRenderer, &LocalVideoRenderer::renderFailed,
+            this, [this](const QString &jobId, const QString &errorMsg) {
+        if (jobId.startsWith(ConcatJobPrefix)) {
+            emit generationFailed(QString("章节视频拼接失败: %1").arg(errorMsg));
+        } else if (jobId.startsWith(DraftJobPrefix)) {
+            emit draftExportFailed(jobId.mid(DraftJobPrefix.size()), errorMsg);
+        }
+    });
+    connect(m_localRenderer, &LocalVideoRenderer::renderCancelled,
+            this, [this](const QString &jobId) {
+        if (jobId.startsWith(DraftJobPrefix)) {
+            emit draftExportCancelled(jobId.mid(DraftJobPrefix.size()));
+        }
+    });
 
     qDebug() << "ViewModel 实例化成功。";
 }
@@ -55,6 +181,14 @@ void ViewModel::generateStoryboard(const QString &storyText, const QString &styl
 
     QString title = "新故事项目 - " + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
     QString description = "由用户输入的文本创建的项目。";
+    m_lastStyle = style;
+
+    // 长故事切成章节并行提交，总耗时接近最长章节而不是全文
+    const QStringList chapters = StorySplitter::split(storyText);
+    if (chapters.size() > 1) {
+        startChapterProject(title, chapters, style, description);
+        return;
+    }
 
     // 触发项目创建 (POST /v1/api/projects)，返回所有 Task IDs
     m_networkManager->createProjectDirect(
@@ -69,30 +203,420 @@ void ViewModel::startVideoCompilation(const QString &storyId)
 {
     qDebug() << ">>> C++ 收到请求：生成视频，委托给 NetworkManager for ID:" << storyId;
 
+    auto chapter = m_chapterProjects.find(storyId);
+    if (chapter != m_chapterProjects.end()) {
+        // 各章节分别合成，全部完成后在本地按顺序拼接
+        chapter->progress.fill(0);
+        chapter->videoUrls = QStringList(chapter->subProjectIds.size(), QString());
+        chapter->videoFiles = chapter->videoUrls;
+        for (const QString &subProjectId : chapter->subProjectIds) {
+            m_networkManager->generateVideoRequest(subProjectId);
+        }
+        return;
+    }
+
     m_networkManager->generateVideoRequest(storyId);
 }
 
 void ViewModel::generateShotImage(const QString &shotId, const QString &prompt, const QString &transition)
 {
-    qDebug() << ">>> C++ 收到请求：生成单张图像 Shot:" << shotId << "Project:" << m_projectId;
-    m_networkManager->updateShotRequest(m_projectId, shotId, prompt, transition);
+    // 章节模式下分镜属于各自的子项目
+    const QString projectId = m_shotProjects.value(shotId, m_projectId);
+    qDebug() << ">>> C++ 收到请求：生成单张图像 Shot:" << shotId << "Project:" << projectId;
+    m_networkManager->updateShotRequest(projectId, shotId, prompt, transition);
+}
+
+bool ViewModel::isLocalExportAvailable() const
+{
+    return m_localRenderer->isAvailable();
+}
+
+void ViewModel::exportDraftVideo(const QString &storyId, const QVariantList &shots)
+{
+    qDebug() << ">>> C++ 收到请求：本地草稿导出 Story:" << storyId << "分镜数:" << shots.count();
+
+    QVector<LocalVideoRenderer::Segment> segments;
+    for (const QVariant &varShot : shots) {
+        const QVariantMap shotMap = varShot.toMap();
+        const QString imageUrl = shotMap.value("imageUrl").toString();
+        if (imageUrl.isEmpty()) {
+            continue; // 尚未生成图片的分镜跳过
+        }
+
+        LocalVideoRenderer::Segment segment;
+        segment.imageSource = imageUrl;
+        segment.duration = shotMap.value("duration", 3.0).toDouble();
+        if (segment.duration <= 0) {
+            segment.duration = 3.0;
+        }
+        segment.transition = shotMap.value("transition", "cut").toString();
+        segments.append(segment);
+    }
+
+    const QString outputPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+            + "/drafts/" + storyId + ".mp4";
+    m_localRenderer->render(DraftJobPrefix + storyId, segments, outputPath);
+}
+
+void ViewModel::setVisibleShotRange(const QString &storyId, int first, int last)
+{
+    if (storyId != m_projectId || (first == m_visibleFirst && last == m_visibleLast)) {
+        return;
+    }
+    m_visibleFirst = first;
+    m_visibleLast = last;
+    m_priorityTimer->start();
+}
+
+void ViewModel::sendPriorityHints()
+{
+    if (m_visibleFirst < 0 || m_shotOrder.isEmpty()) {
+        return;
+    }
+
+    // 可见分镜优先级为 0，其余按与可见区间的距离递增
+    QVariantMap changed;
+    for (int i = 0; i < m_shotOrder.size(); ++i) {
+        const QString taskId = m_shotTaskOf.value(m_shotOrder[i]);
+        if (taskId.isEmpty()) {
+            continue;
+        }
+        int priority = 0;
+        if (i < m_visibleFirst) {
+            priority = m_visibleFirst - i;
+        } else if (i > m_visibleLast) {
+            priority = i - m_visibleLast;
+        }
+        if (m_sentPriorities.value(taskId, -1) != priority) {
+            m_sentPriorities.insert(taskId, priority);
+            changed.insert(taskId, priority);
+        }
+    }
+
+    if (!changed.isEmpty()) {
+        qDebug() << "ViewModel: 发送优先级提示，可见区间" << m_visibleFirst << "-" << m_visibleLast
+                 << "变化任务数:" << changed.size();
+        m_networkManager->updateTaskPriorities(changed);
+    }
+}
+
+QString ViewModel::cachedMediaUrl(const QString &url)
+{
+    const QString localPath = m_mediaCache->localPath(url);
+    return localPath.isEmpty() ? url : QUrl::fromLocalFile(localPath).toString();
+}
+
+QString ViewModel::exportVideo(const QString &projectId, const QString &videoSource)
+{
+    if (videoSource.isEmpty()) {
+        emit exportFailed(projectId, "没有可导出的视频");
+        return QString();
+    }
+    return m_exportManager->enqueue(projectId.isEmpty() ? QString("video") : projectId, videoSource);
+}
+
+// --- [新增] 旁白配音 ---
+
+void ViewModel::generateNarration(const QString &storyId, const QString &voice)
+{
+    if (m_chapterProjects.contains(storyId)) {
+        // 章节模式的逻辑项目在服务端没有对应实体
+        emit generationFailed("章节模式的项目暂不支持整体配音。");
+        return;
+    }
+    qDebug() << ">>> C++ 收到请求：生成配音 for ID:" << storyId << "voice:" << voice;
+    m_networkManager->generateTtsRequest(storyId, voice);
+}
+
+QVariantList ViewModel::waveformPeaks(const QString &storyId, double startSeconds, double endSeconds, int buckets) const
+{
+    QVariantList list;
+    auto it = m_waveforms.constFind(storyId);
+    if (it == m_waveforms.constEnd()) {
+        return list;
+    }
+    const QVector<float> peaks = it->range(startSeconds, endSeconds, qBound(1, buckets, 8192));
+    list.reserve(peaks.size());
+    for (float value : peaks) {
+        list.append(value);
+    }
+    return list;
+}
+
+double ViewModel::narrationDuration(const QString &storyId) const
+{
+    auto it = m_waveforms.constFind(storyId);
+    return it == m_waveforms.constEnd() ? 0 : it->durationSeconds();
+}
+
+// --- [新增] 热启动快照 ---
+
+void ViewModel::refreshProject(const QString &storyId)
+{
+    if (storyId.isEmpty()) {
+        return;
+    }
+    qDebug() << ">>> C++ 收到请求：刷新快照恢复的项目" << storyId;
+    m_projectId = storyId;
+    m_networkManager->getShotListRequest(storyId);
+}
+
+QVariantMap ViewModel::sessionState()
+{
+    const QString storyId = m_sessionStory.value("id").toString();
+    if (storyId.isEmpty()) {
+        return QVariantMap();
+    }
+
+    // 只保留 StoryboardPage::loadShotsModel 用到的字段
+    QVariantList rows;
+    for (const QVariant &varShot : m_sessionStory.value("shots").toList()) {
+        const QVariantMap shot = varShot.toMap();
+        QVariantMap row;
+        row["id"] = shot.value("id");
+        row["order"] = shot.value("shotOrder", shot.value("order"));
+        row["title"] = shot.value("title");
+        row["description"] = shot.value("description");
+        row["prompt"] = shot.value("prompt");
+        row["status"] = shot.value("status");
+        row["transition"] = shot.value("transition");
+        row["imageUrl"] = cachedMediaUrl(shot.value("imageUrl").toString());
+        row["placeholderUrl"] = shot.value("placeholderUrl");
+        row["orderKey"] = shot.value("orderKey");
+        rows.append(row);
+    }
+
+    QVariantMap project;
+    project["id"] = storyId;
+    project["title"] = m_sessionStory.value("title");
+    // 章节模式的逻辑项目在服务端没有对应实体，恢复后不刷新
+    project["refreshable"] = !m_chapterProjects.contains(storyId);
+    project["shots"] = rows;
+    return project;
+}
+
+void ViewModel::rememberStoryboard(const QVariantMap &storyMap)
+{
+    m_sessionStory = storyMap;
+    for (const QVariant &varShot : storyMap.value("shots").toList()) {
+        const QString imageUrl = varShot.toMap().value("imageUrl").toString();
+        if (imageUrl.startsWith("http", Qt::CaseInsensitive)) {
+            m_mediaCache->prefetch(imageUrl);
+        }
+    }
+}
+
+void ViewModel::rememberShotImage(const QString &shotId, const QString &imageUrl)
+{
+    QVariantList shots = m_sessionStory.value("shots").toList();
+    for (QVariant &varShot : shots) {
+        QVariantMap shot = varShot.toMap();
+        if (shot.value("id").toString() == shotId) {
+            shot["imageUrl"] = imageUrl;
+            shot["status"] = "generated";
+            varShot = shot;
+            m_sessionStory["shots"] = shots;
+            m_mediaCache->prefetch(imageUrl);
+            return;
+        }
+    }
+}
+
+void ViewModel::resetShotOrder(const QVariantList &shots)
+{
+    m_shotOrder.clear();
+    for (const QVariant &varShot : shots) {
+        m_shotOrder.append(varShot.toMap().value("id").toString());
+    }
+    // 优先级提示只针对当前分镜板，之前项目的映射不再需要
+    for (auto it = m_shotTaskOf.begin(); it != m_shotTaskOf.end();) {
+        if (m_shotOrder.contains(it.key())) {
+            ++it;
+        } else {
+            it = m_shotTaskOf.erase(it);
+        }
+    }
+    m_sentPriorities.clear();
+    m_visibleFirst = -1;
+    m_visibleLast = -1;
+}
+
+static QString projectFileName(const QString &storyId)
+{
+    // 与 StoryboardPage.qml 中的文件名一致
+    return "project_" + storyId + ".json";
+}
+
+void ViewModel::assignOrderKeys(const QString &storyId, QVariantList *shots)
+{
+    // 本地调整过的排序键：项目文件 (已合并排序日志，跨重启保留) 为基础，本次会话内存中的更新覆盖
+    QHash<QString, QString> localKeys;
+    for (const QVariant &varShot : m_projectFiles->loadData(projectFileName(storyId)).value("shots").toList()) {
+        const QVariantMap shot = varShot.toMap();
+        const QString key = shot.value("orderKey").toString();
+        if (!key.isEmpty()) {
+            localKeys.insert(shot.value("id", shot.value("shotId")).toString(), key);
+        }
+    }
+    if (storyId == m_sessionStory.value("id").toString()) {
+        for (const QVariant &varShot : m_sessionStory.value("shots").toList()) {
+            const QVariantMap shot = varShot.toMap();
+            const QString key = shot.value("orderKey").toString();
+            if (!key.isEmpty()) {
+                localKeys.insert(shot.value("id").toString(), key);
+            }
+        }
+    }
+    if (!localKeys.isEmpty()) {
+        for (QVariant &varShot : *shots) {
+            QVariantMap shot = varShot.toMap();
+            const QString key = localKeys.value(shot.value("id").toString());
+            if (!key.isEmpty()) {
+                shot["orderKey"] = key;
+                varShot = shot;
+            }
+        }
+    }
+    // 有新分镜 (缺少排序键) 时按服务端的整数顺序整体分配
+    OrderKey::normalize(shots);
+}
+
+// 整体写入项目文件 (同时清空排序日志)，之后的重排才有文件可以追加
+void ViewModel::saveProjectFile(const QVariantMap &storyMap)
+{
+    const QString storyId = storyMap.value("id").toString();
+    if (storyId.isEmpty()) {
+        return;
+    }
+    if (!m_projectFiles->saveData(storyMap, projectFileName(storyId))) {
+        qDebug() << "ViewModel: 项目文件保存失败" << storyId;
+    }
+}
+
+QVariantMap ViewModel::moveShot(const QString &storyId, const QString &shotId, int toIndex)
+{
+    QVariantMap result;
+    if (storyId != m_sessionStory.value("id").toString()) {
+        return result;
+    }
+    QVariantList shots = m_sessionStory.value("shots").toList();
+    int from = -1;
+    for (int i = 0; i < shots.size(); ++i) {
+        if (shots[i].toMap().value("id").toString() == shotId) {
+            from = i;
+            break;
+        }
+    }
+    if (from < 0 || toIndex < 0 || toIndex >= shots.size()) {
+        return result;
+    }
+
+    QVariantMap moved = shots.takeAt(from).toMap();
+    const QString before = toIndex > 0 ? shots[toIndex - 1].toMap().value("orderKey").toString() : QString();
+    const QString after = toIndex < shots.size() ? shots[toIndex].toMap().value("orderKey").toString() : QString();
+    const QString key = OrderKey::between(before, after);
+    moved["orderKey"] = key;
+    shots.insert(toIndex, moved);
+
+    QVariantMap orderKeys;
+    const bool rebalance = OrderKey::needsRebalance(key);
+    if (rebalance) {
+        // 很少发生：同一位置反复插入使键超长，整体换成均匀分布的短键
+        const QStringList keys = OrderKey::spread(shots.size());
+        for (int i = 0; i < shots.size(); ++i) {
+            QVariantMap shot = shots[i].toMap();
+            shot["orderKey"] = keys[i];
+            shots[i] = shot;
+            orderKeys.insert(shot.value("id").toString(), keys[i]);
+        }
+        qDebug() << "ViewModel: 分镜排序键重排," << shots.size() << "个分镜";
+    } else {
+        orderKeys.insert(shotId, key);
+    }
+    m_sessionStory["shots"] = shots;
+
+    // 与 QML 模型保持一致 (视口优先级按下标计算)
+    if (storyId == m_projectId && m_shotOrder.value(from) == shotId) {
+        m_shotOrder.move(from, toIndex);
+        m_sentPriorities.clear();
+    }
+
+    result["orderKeys"] = orderKeys;
+    result["rebalanced"] = rebalance;
+    return result;
+}
+
+QVariantMap ViewModel::selectRendition(const QString &storyId, const QString &currentUrl, bool stalled)
+{
+    QVariantMap result;
+    const QVector<AdaptiveBitrate::Rendition> renditions = m_renditions.value(storyId);
+    if (renditions.isEmpty()) {
+        return result;
+    }
+
+    int current = -1;
+    for (int i = 0; !currentUrl.isEmpty() && i < renditions.size(); ++i) {
+        if (renditions[i].url == currentUrl) {
+            current = i;
+            break;
+        }
+    }
+    const int index = m_abr->choose(renditions, current, stalled);
+    const AdaptiveBitrate::Rendition &rendition = renditions[index];
+    result["url"] = rendition.url;
+    result["resolution"] = rendition.resolution;
+    result["bitrateKbps"] = rendition.bitrateKbps;
+    result["estimateKbps"] = m_abr->estimateKbps();
+    result["segmentSeconds"] = m_abr->segmentSeconds();
+    return result;
+}
+
+void ViewModel::cancelDraftExport(const QString &storyId)
+{
+    qDebug() << ">>> C++ 收到请求：取消本地草稿导出 Story:" << storyId;
+    m_localRenderer->cancel(DraftJobPrefix + storyId);
 }
 
 
 // --- 任务调度与轮询管理 ---
 
 // [修改] 阶段 1：处理文本任务创建成功 (DEBUG INJECTION HERE)
-void ViewModel::handleTextTaskCreated(const QString &projectId, const QString &textTaskId, const QVariantList &shotTaskIds)
+void ViewModel::handleTextTaskCreated(const QString &projectId, const QString &textTaskId, const QVariantList &shotTaskIds,
+                                      const QString &tag)
 {
     qDebug() << "ViewModel: 收到 Text Task ID:" << textTaskId << "，Shot Tasks Count:" << shotTaskIds.count();
 
-    m_projectId = projectId;
+    // 章节子项目：tag 形如 "<逻辑项目 ID>#<章节下标>"
+    const int sep = tag.lastIndexOf('#');
+    auto chapter = sep > 0 ? m_chapterProjects.find(tag.left(sep)) : m_chapterProjects.end();
+    if (chapter != m_chapterProjects.end()) {
+        const int index = tag.mid(sep + 1).toInt();
+        if (index >= 0 && index < chapter->subProjectIds.size()) {
+            chapter->subProjectIds[index] = projectId;
+            m_chapterOf.insert(projectId, chapter->id);
+            qDebug() << "ViewModel: 章节" << index + 1 << "/" << chapter->subProjectIds.size() << "子项目:" << projectId;
+        }
+        m_projectId = chapter->id;
+        m_shotTaskIds += shotTaskIds;
+    } else {
+        m_projectId = projectId;
+        m_shotTaskIds = shotTaskIds;
+    }
     m_textTaskId = textTaskId;
-    m_shotTaskIds = shotTaskIds;
+    m_shotTasksByProject.insert(projectId, shotTaskIds);
 
     QVariantMap taskInfo;
     taskInfo["type"] = "text_task";
     taskInfo["id"] = projectId;
+    taskInfo["submittedAt"] = QDateTime::currentMSecsSinceEpoch();
+    Metrics::instance()->counter("stv_tasks_submitted_total", "Server tasks started by the client, by type.",
+                                 Metrics::label("type", "text_task"))->inc();
+
+    EtaModel::Features features;
+    features.type = "text_task";
+    features.shotCount = shotTaskIds.size();
+    features.style = m_lastStyle;
+    m_etaModel->begin(textTaskId, features);
 
     m_activeTasks.insert(textTaskId, taskInfo);
     startPollingTimer();
@@ -106,6 +630,8 @@ void ViewModel::handleShotListReceived(const QString &projectId, const QVariantL
     // --- 构造完整 URL 并标准化数据结构 ---
     QVariantList processedShots;
     const QString API_BASE_URL = "http://119.45.124.222:8080";
+    // 分镜列表每个项目只取一次，取出后不再保留 (长时间运行时不随项目数增长)
+    const QVariantList shotTaskIds = m_shotTasksByProject.take(projectId);
 
     for (const QVariant &varShot : shots) {
         QVariantMap shotMap = varShot.toMap();
@@ -125,6 +651,13 @@ void ViewModel::handleShotListReceived(const QString &projectId, const QVariantL
             }
         }
 
+        // [新增] BlurHash 占位图：图片还没下载 (甚至还没生成) 时先显示模糊色块
+        const QString blurHash = shotMap.value("blurhash", shotMap.value("blurHash")).toString();
+        const QString placeholderUrl = BlurHashProvider::urlFor(blurHash);
+        if (!placeholderUrl.isEmpty()) {
+            shotMap["placeholderUrl"] = placeholderUrl;
+        }
+
         // QML ListModel 期望的键名为 'shotId', 'shotOrder', 'shotTitle' 等
         // 由于 backend SQL 使用 'id', 'order', 'title'，我们在这里进行映射。
         shotMap["shotId"] = shotMap["id"];
@@ -133,10 +666,25 @@ void ViewModel::handleShotListReceived(const QString &projectId, const QVariantL
         shotMap["shotDescription"] = shotMap["description"];
         shotMap["shotPrompt"] = shotMap["prompt"];
 
+        // 服务端按 shot_order 把 shot_task_ids 依次分配给分镜
+        const int order = shotMap["order"].toInt();
+        if (order >= 1 && order <= shotTaskIds.size()) {
+            m_shotTaskOf.insert(shotMap["id"].toString(), shotTaskIds[order - 1].toString());
+        }
+        // 重生成时按分镜找回所属项目，不依赖 "当前项目" (多个项目同时进行时也正确)
+        m_shotProjects.insert(shotMap["id"].toString(), projectId);
+
         processedShots.append(shotMap);
     }
     // ------------------------------------
+    // 章节子项目的分镜在拼接后统一分配排序键 (各章节单独分配会互相穿插)
+    if (m_chapterOf.contains(projectId)) {
+        collectChapterStoryboard(projectId, processedShots);
+        return;
+    }
 
+    // [新增] 服务端只给整数 order；刷新同一项目时沿用本地已调整的排序键
+    assignOrderKeys(projectId, &processedShots);
 
     // 将分镜列表发射给 QML (StoryboardPage)
     QVariantMap storyMap;
@@ -144,6 +692,8 @@ void ViewModel::handleShotListReceived(const QString &projectId, const QVariantL
     storyMap["title"] = "LLM 生成的故事 (MOCK DATA)";
     storyMap["shots"] = processedShots; // 传递处理后的分镜列表
 
+    saveProjectFile(storyMap);
+    resetShotOrder(processedShots);
     emit storyboardGenerated(QVariant::fromValue(storyMap));
 
     // [TODO] 启动所有 shot_task_ids 的轮询 (Stage 2) - 真实流程需要在此处启动
@@ -166,12 +716,15 @@ void ViewModel::handleTaskResultReceived(const QString &taskId, const QVariantMa
     qDebug() << "DEBUG MAP CHECK: Successfully retrieved map. Task Type:" << taskInfo["type"].toString();
     QString type = taskInfo["type"].toString();
     QString projectId = taskInfo["id"].toString();
+    recordTaskMetrics(taskInfo, "succeeded");
+    m_etaModel->finish(taskId, true);
 
     qDebug() << "333333  -"<<type;
     if (type == "text_task") {
         // [Stage 1 Done] 文本任务完成
         stopPollingTimer(taskId);
-        m_networkManager->getShotListRequest(m_projectId); // 获取分镜列表
+        notifyCompletion("故事板已生成");
+        m_networkManager->getShotListRequest(projectId); // 获取分镜列表 (章节模式下为子项目)
 
     } else if (type == "shot_task" || type == "shot") {
         // 分镜图片任务完成 (Stage 2 Done 或重生成)
@@ -185,13 +738,19 @@ void ViewModel::handleTaskResultReceived(const QString &taskId, const QVariantMa
         qDebug() << "DEBUG CALL CHECK: Attempting to call processVideoResult for Project:" << projectId;
         processVideoResult(projectId, resultData);
         stopPollingTimer(taskId);
+        notifyCompletion("视频已合成");
+
+    } else if (type == "tts") {
+        stopPollingTimer(taskId);
+        processTtsResult(projectId, resultData);
+        notifyCompletion("配音已生成");
     }
 }
 
 
 // --- 辅助函数 (其他函数保持不变) ---
 
-void ViewModel::handleTaskCreated(const QString &taskId, const QString &shotId)
+void ViewModel::handleTaskCreated(const QString &taskId, const QString &shotId, const QString &projectId)
 {
     qDebug() << "ViewModel: 收到通用任务 Task ID:" << taskId;
 
@@ -200,11 +759,41 @@ void ViewModel::handleTaskCreated(const QString &taskId, const QString &shotId)
 
     if (shotId.isEmpty()) {
         taskInfo["type"] = "video";
-        taskInfo["id"] = m_projectId; // 使用当前 Project ID
+        taskInfo["id"] = projectId.isEmpty() ? m_projectId : projectId; // 请求时的 Project ID
     } else {
         taskInfo["type"] = "shot";
         taskInfo["id"] = shotId;
     }
+    trackTask(taskId, taskInfo);
+}
+
+// [新增] 配音任务：按项目跟踪
+void ViewModel::handleTtsTaskCreated(const QString &taskId, const QString &projectId)
+{
+    qDebug() << "ViewModel: 收到配音任务 Task ID:" << taskId << "Project:" << projectId;
+    QVariantMap taskInfo;
+    taskInfo["type"] = "tts";
+    taskInfo["id"] = projectId;
+    trackTask(taskId, taskInfo);
+}
+
+void ViewModel::trackTask(const QString &taskId, const QVariantMap &info)
+{
+    QVariantMap taskInfo = info;
+    taskInfo["submittedAt"] = QDateTime::currentMSecsSinceEpoch();
+    Metrics::instance()->counter("stv_tasks_submitted_total", "Server tasks started by the client, by type.",
+                                 Metrics::label("type", taskInfo["type"].toString()))->inc();
+
+    EtaModel::Features features;
+    features.type = taskInfo["type"].toString();
+    features.style = m_lastStyle;
+    if (features.type == "video") {
+        features.shotCount = shotCountOf(taskInfo["id"].toString());
+        features.resolution = NetworkManager::videoResolution();
+    } else if (features.type == "tts") {
+        features.shotCount = shotCountOf(taskInfo["id"].toString());
+    }
+    m_etaModel->begin(taskId, features);
 
     m_activeTasks.insert(taskId, taskInfo);
     startPollingTimer();
@@ -215,15 +804,44 @@ void ViewModel::handleTaskStatusReceived(const QString &taskId, int progress, co
 {
     if (!m_activeTasks.contains(taskId)) return;
 
-    QVariantMap taskInfo = m_activeTasks[taskId];
-    QString type = taskInfo["type"].toString();
-    QString identifier = taskInfo["id"].toString();
+    publishProgress(taskId, progress);
 
-    if (type == "text_task" || type == "video") {
+    qDebug() << "Task:" << taskId << " Status:" << status << " Message:" << message;
+}
+
+void ViewModel::publishProgress(const QString &taskId, int serverProgress)
+{
+    const QVariantMap taskInfo = m_activeTasks.value(taskId);
+    const QString type = taskInfo["type"].toString();
+    const QString identifier = taskInfo["id"].toString();
+
+    // 服务端进度是跳变的 (mock 每 10%，Gateway 的视频 0→50→100)，按历史耗时在两次跳变之间插值
+    const int progress = m_etaModel->progress(taskId, serverProgress);
+    if (m_chapterOf.contains(identifier)) {
+        reportChapterProgress(identifier, progress);
+    } else if (type == "text_task" || type == "video") {
         emit compilationProgress(identifier, progress);
+        emit compilationEta(identifier, m_etaModel->remainingSeconds(taskId));
+    } else if (type == "tts") {
+        emit narrationProgress(identifier, progress);
     }
+}
 
-    qDebug() << "Task:" << taskId << " Status:" << status << " Message:" << message;
+int ViewModel::shotCountOf(const QString &projectId) const
+{
+    auto chapter = m_chapterProjects.constFind(m_chapterOf.value(projectId));
+    if (chapter != m_chapterProjects.constEnd()) {
+        const int index = chapter->subProjectIds.indexOf(projectId);
+        return index >= 0 ? chapter->shots[index].size() : 0;
+    }
+    if (m_chapterProjects.contains(projectId)) {
+        int total = 0;
+        for (const QVariantList &shots : m_chapterProjects[projectId].shots) {
+            total += shots.size();
+        }
+        return total;
+    }
+    return projectId == m_projectId ? m_shotOrder.size() : 0;
 }
 
 
@@ -232,6 +850,8 @@ void ViewModel::handleTaskRequestFailed(const QString &taskId, const QString &er
     if (m_activeTasks.contains(taskId)) {
         QVariantMap taskInfo = m_activeTasks[taskId];
         qDebug() << "任务轮询失败:" << taskId << errorMsg;
+        recordTaskMetrics(taskInfo, "failed");
+        m_etaModel->finish(taskId, false);
         emit generationFailed(QString("任务 %1 失败: %2").arg(taskInfo["id"].toString()).arg(errorMsg));
         stopPollingTimer(taskId);
     }
@@ -239,6 +859,12 @@ void ViewModel::handleTaskRequestFailed(const QString &taskId, const QString &er
 
 void ViewModel::startPollingTimer()
 {
+    // [新增] 长轮询模式下每个任务各自挂起一个请求；定时器只用于本地插值进度
+    if (m_networkManager->isLongPolling()) {
+        for (auto it = m_activeTasks.constBegin(); it != m_activeTasks.constEnd(); ++it) {
+            m_networkManager->watchTask(it.key());
+        }
+    }
     if (!m_pollingTimer->isActive()) {
         m_pollingTimer->start();
         qDebug() << "轮询定时器已启动。";
@@ -248,6 +874,7 @@ void ViewModel::startPollingTimer()
 void ViewModel::stopPollingTimer(const QString &taskId)
 {
     m_activeTasks.remove(taskId);
+    m_networkManager->unwatchTask(taskId);
     if (m_activeTasks.isEmpty() && m_pollingTimer->isActive()) {
         m_pollingTimer->stop();
         qDebug() << "所有任务完成，轮询定时器已停止。";
@@ -260,9 +887,103 @@ void ViewModel::pollCurrentTask()
         m_pollingTimer->stop();
         return;
     }
+    // 历史耗时足够时，离预计完成还早的任务拉长查询间隔；进度条照常按时间推进
+    // [修改] 长轮询模式下状态由挂起的请求推送，这里只推进进度条
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const bool longPolling = m_networkManager->isLongPolling();
     QList<QString> taskIds = m_activeTasks.keys();
     for (const QString &taskId : taskIds) {
-        m_networkManager->pollTaskStatus(taskId);
+        if (!longPolling && m_etaModel->shouldPoll(taskId, now)) {
+            m_networkManager->pollTaskStatus(taskId);
+        } else {
+            publishProgress(taskId, -1);
+        }
+    }
+}
+
+// --- 后台感知轮询 ---
+
+void ViewModel::watchWindow(QWindow *window)
+{
+    if (m_window) {
+        m_window->removeEventFilter(this);
+        disconnect(m_window, nullptr, this, nullptr);
+    }
+    m_window = window;
+    if (!window) {
+        return;
+    }
+    connect(window, &QWindow::visibilityChanged, this, &ViewModel::updateBackgroundState);
+    // 切到其他桌面或被完全遮挡时没有专门的信号，只能从 Expose 事件里取 isExposed()
+    window->installEventFilter(this);
+    updateBackgroundState();
+}
+
+bool ViewModel::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == m_window && event->type() == QEvent::Expose) {
+        // 事件处理完后 isExposed() 才是新值
+        QMetaObject::invokeMethod(this, &ViewModel::updateBackgroundState, Qt::QueuedConnection);
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void ViewModel::updateBackgroundState()
+{
+    bool background = false;
+    if (qGuiApp) {
+        const Qt::ApplicationState state = qGuiApp->applicationState();
+        background = state == Qt::ApplicationHidden || state == Qt::ApplicationSuspended;
+    }
+    if (m_window) {
+        const QWindow::Visibility visibility = m_window->visibility();
+        background = background || visibility == QWindow::Hidden || visibility == QWindow::Minimized
+                || !m_window->isExposed();
+    }
+    if (background == m_inBackground) {
+        return;
+    }
+    m_inBackground = background;
+
+    if (background) {
+        qDebug() << "ViewModel: 窗口不可见，轮询间隔放慢到" << BackgroundPollIntervalMs << "ms";
+        m_pollingTimer->setInterval(BackgroundPollIntervalMs);
+    } else {
+        qDebug() << "ViewModel: 窗口恢复可见，立即刷新任务状态";
+        m_pollingTimer->setInterval(ForegroundPollIntervalMs);
+        if (!m_activeTasks.isEmpty()) {
+            // 追一次最新状态，再按前台节奏继续
+            pollCurrentTask();
+            m_pollingTimer->start();
+        }
+    }
+}
+
+void ViewModel::notifyCompletion(const QString &what)
+{
+    if (!m_inBackground) {
+        return;
+    }
+    qDebug() << "ViewModel: 后台任务完成，提醒用户:" << what;
+    // 任务栏闪烁 / Dock 图标弹跳，直到用户切回窗口
+    if (m_window) {
+        QGuiApplication::alert(m_window, 0);
+    }
+}
+
+void ViewModel::recordTaskMetrics(const QVariantMap &taskInfo, const QString &outcome)
+{
+    const QString labels = Metrics::label("type", taskInfo["type"].toString()) + "," + Metrics::label("outcome", outcome);
+    Metrics *metrics = Metrics::instance();
+    metrics->counter("stv_tasks_completed_total", "Server tasks that reached a terminal state, by type and outcome.",
+                     labels)->inc();
+
+    // 从提交到客户端观察到结束的端到端耗时 (含轮询间隔)
+    const qint64 submittedAt = taskInfo.value("submittedAt").toLongLong();
+    if (submittedAt > 0) {
+        metrics->histogram("stv_task_duration_seconds", "End-to-end task latency as observed by the client.",
+                           Metrics::taskBuckets(), labels)
+                ->observe((QDateTime::currentMSecsSinceEpoch() - submittedAt) / 1000.0);
     }
 }
 
@@ -341,7 +1062,213 @@ void ViewModel::processVideoResult(const QString &storyId, const QVariantMap &re
     // 最终确认日志
     qDebug() << "视频资源 URL:" << qmlUrl;
 
+    if (m_chapterOf.contains(storyId)) {
+        collectChapterVideo(storyId, qmlUrl);
+        return;
+    }
+
+    // [新增] 预览用的多个档位；最高档 (qmlUrl) 仍是导出与本地缓存的来源
+    const QVector<AdaptiveBitrate::Rendition> renditions =
+            AdaptiveBitrate::parse(resultData.value("renditions").toList(), qmlUrl, "http://119.45.124.222:8080");
+    if (renditions.size() > 1) {
+        m_renditions.insert(storyId, renditions);
+        qDebug() << "视频档位:" << renditions.size() << "个，最低" << renditions.first().resolution
+                 << "最高" << renditions.last().resolution;
+    }
+
+    // 任务一完成就开始后台下载到本地缓存，进入预览页时尽量直接播放本地文件
+    m_mediaCache->prefetch(qmlUrl);
+
     // 发射信号给 QML
     emit compilationProgress(storyId, 100);
+    emit videoResourceReady(storyId, qmlUrl);
     qDebug() << "C++ DEBUG: CompilationProgress signal EMITTED for ID:" << storyId;
 }
+
+
+// --- 章节模式 ---
+
+void ViewModel::startChapterProject(const QString &title, const QStringList &chapters, const QString &style, const QString &description)
+{
+    ChapterProject project;
+    project.id = "chapters-" + QDateTime::currentDateTime().toString("yyyyMMddhhmmsszzz");
+    project.subProjectIds = QStringList(chapters.size(), QString());
+    project.shots.resize(chapters.size());
+    project.progress.fill(0, chapters.size());
+    project.storyboardsReceived = 0;
+    m_chapterProjects.insert(project.id, project);
+    m_projectId = project.id;
+    m_shotTaskIds.clear();
+
+    qDebug() << ">>> 章节模式：故事切分为" << chapters.size() << "章，逻辑项目:" << project.id;
+
+    // 所有章节同时提交，服务端并行处理文本与图片任务
+    for (int i = 0; i < chapters.size(); ++i) {
+        m_networkManager->createProjectDirect(
+            QString("%1 (第 %2/%3 章)").arg(title).arg(i + 1).arg(chapters.size()),
+            chapters[i],
+            style,
+            description,
+            QString("%1#%2").arg(project.id).arg(i));
+    }
+}
+
+void ViewModel::reportChapterProgress(const QString &subProjectId, int progress)
+{
+    auto chapter = m_chapterProjects.find(m_chapterOf.value(subProjectId));
+    if (chapter == m_chapterProjects.end()) return;
+
+    const int index = chapter->subProjectIds.indexOf(subProjectId);
+    if (index < 0) return;
+    chapter->progress[index] = progress;
+
+    // 整体进度取各章节平均值；成片阶段预留最后 5% 给本地拼接
+    int total = 0;
+    for (int value : chapter->progress) {
+        total += value;
+    }
+    int percent = total / chapter->progress.size();
+    if (!chapter->videoUrls.isEmpty()) {
+        percent = percent * 95 / 100;
+    }
+    emit compilationProgress(chapter->id, percent);
+}
+
+void ViewModel::collectChapterStoryboard(const QString &subProjectId, const QVariantList &shots)
+{
+    auto chapter = m_chapterProjects.find(m_chapterOf.value(subProjectId));
+    if (chapter == m_chapterProjects.end()) return;
+
+    const int index = chapter->subProjectIds.indexOf(subProjectId);
+    if (index < 0 || !chapter->shots[index].isEmpty()) return;
+
+    QVariantList chapterShots;
+    for (const QVariant &varShot : shots) {
+        QVariantMap shotMap = varShot.toMap();
+        shotMap["projectId"] = subProjectId;
+        shotMap["chapter"] = index + 1;
+        m_shotProjects.insert(shotMap["shotId"].toString(), subProjectId);
+        chapterShots.append(shotMap);
+    }
+    chapter->shots[index] = chapterShots;
+    ++chapter->storyboardsReceived;
+    qDebug() << "ViewModel: 章节" << index + 1 << "分镜已就绪 (" << chapter->storyboardsReceived
+             << "/" << chapter->subProjectIds.size() << ")";
+
+    if (chapter->storyboardsReceived < chapter->subProjectIds.size()) {
+        return;
+    }
+
+    // 所有章节就绪：按章节顺序拼接，重新编号 (排序键按拼接后的顺序分配，章节内的 order 不再使用)
+    QVariantList stitched;
+    for (const QVariantList &list : chapter->shots) {
+        for (const QVariant &varShot : list) {
+            QVariantMap shotMap = varShot.toMap();
+            shotMap.remove("orderKey");
+            shotMap["order"] = stitched.size() + 1;
+            shotMap["shotOrder"] = stitched.size() + 1;
+            stitched.append(shotMap);
+        }
+    }
+
+    QVariantMap storyMap;
+    storyMap["id"] = chapter->id;
+    storyMap["title"] = QString("LLM 生成的故事 (%1 章)").arg(chapter->subProjectIds.size());
+    assignOrderKeys(chapter->id, &stitched);
+    storyMap["shots"] = stitched;
+
+    saveProjectFile(storyMap);
+    resetShotOrder(stitched);
+    emit storyboardGenerated(QVariant::fromValue(storyMap));
+}
+
+void ViewModel::collectChapterVideo(const QString &subProjectId, const QString &videoUrl)
+{
+    auto chapter = m_chapterProjects.find(m_chapterOf.value(subProjectId));
+    if (chapter == m_chapterProjects.end()) return;
+
+    const int index = chapter->subProjectIds.indexOf(subProjectId);
+    if (index < 0) return;
+    chapter->videoUrls[index] = videoUrl;
+    chapter->progress[index] = 100;
+
+    // 拼接需要本地文件：已缓存直接使用，否则等待 MediaCache::cached
+    const QString localPath = m_mediaCache->localPath(videoUrl);
+    if (localPath.isEmpty()) {
+        m_mediaCache->prefetch(videoUrl);
+    } else {
+        onChapterVideoCached(videoUrl, localPath);
+    }
+    reportChapterProgress(subProjectId, 100);
+}
+
+void ViewModel::processTtsResult(const QString &storyId, const QVariantMap &resultData)
+{
+    QString audioUrl = resultData["resource_url"].toString();
+    if (audioUrl.isEmpty()) {
+        emit generationFailed(QString("配音失败：未找到音频资源路径。"));
+        return;
+    }
+    if (!audioUrl.startsWith("http", Qt::CaseInsensitive)) {
+        audioUrl = QString("http://119.45.124.222:8080%1").arg(audioUrl);
+    }
+    qDebug() << "配音资源 URL:" << audioUrl;
+
+    // 音频先流式下载进媒体缓存，缓存完成后再生成波形
+    m_pendingNarration.insert(audioUrl, storyId);
+    const QString localPath = m_mediaCache->localPath(audioUrl);
+    if (!localPath.isEmpty()) {
+        onNarrationCached(audioUrl, localPath);
+    } else {
+        m_mediaCache->prefetch(audioUrl);
+    }
+}
+
+void ViewModel::onNarrationCached(const QString &url, const QString &localPath)
+{
+    if (!m_pendingNarration.contains(url)) {
+        return;
+    }
+    const QString storyId = m_pendingNarration.take(url);
+    emit narrationReady(storyId, QUrl::fromLocalFile(localPath).toString());
+
+    // 峰值文件按音频内容摘要命名：同一段音频只解码一次，重启后直接载入
+    QString key = m_mediaCache->digestOf(url);
+    if (key.isEmpty()) {
+        key = QFileInfo(localPath).completeBaseName();
+    }
+    const QString peaksPath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + "/waveforms/" + key + ".peaks";
+
+    TaskExecutor::instance()->run(this, [localPath, peaksPath](const CancellationToken &) {
+        if (!QFile::exists(peaksPath)) {
+            QString errorMsg;
+            if (!WaveformPeaks::build(localPath, peaksPath, &errorMsg)) {
+                qDebug() << "波形生成失败:" << errorMsg;
+                return WaveformPeaks();
+            }
+        }
+        return WaveformPeaks::load(peaksPath);
+    }, [this, storyId](const WaveformPeaks &peaks) {
+        if (!peaks.isValid()) {
+            return;
+        }
+        m_waveforms.insert(storyId, peaks);
+        emit waveformReady(storyId, peaks.durationSeconds());
+    });
+}
+
+void ViewModel::onChapterVideoCached(const QString &url, const QString &localPath)
+{
+    for (ChapterProject &chapter : m_chapterProjects) {
+        const int index = chapter.videoUrls.indexOf(url);
+        if (index < 0) continue;
+
+        chapter.videoFiles[index] = localPath;
+        if (chapter.videoFiles.contains(QString())) continue;
+
+        const QString outputPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+                + "/chapters/" + chapter.id + ".mp4";
+        m_localRenderer->concatFiles(ConcatJobPrefix + chapter.id, chapter.videoFiles, outputPath);
+    }
+}
@@ -8,8 +8,19 @@
 #include <QVariantList> // [新增]
 #include <QTimer>
 #include <QHash>
+#include <QPointer>
+#include <QStringList>
+#include <QVector>
+#include "waveformpeaks.h"
+#include "adaptivebitrate.h"
 
 class NetworkManager;
+class LocalVideoRenderer;
+class MediaCache;
+class QWindow;
+class ExportManager;
+class DataManager;
+class EtaModel;
 
 class ViewModel : public QObject
 {
@@ -18,22 +29,95 @@ class ViewModel : public QObject
 public:
     explicit ViewModel(QObject *parent = nullptr);
 
+    // [新增] 轮询节奏：窗口可见时 1 秒，最小化/被遮挡/应用进入后台时放慢
+    static const int ForegroundPollIntervalMs = 1000;
+    static const int BackgroundPollIntervalMs = 15000;
+
+    // [新增] 监听主窗口可见性 (最小化、隐藏、完全被遮挡)，由 main.cpp 在 QML 加载后调用
+    void watchWindow(QWindow *window);
+
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
     Q_INVOKABLE void generateStoryboard(const QString &storyText, const QString &style);
     Q_INVOKABLE void startVideoCompilation(const QString &storyId);
     Q_INVOKABLE void generateShotImage(const QString &shotId, const QString &prompt, const QString &transition);
 
+    // [新增] 本地草稿导出：分镜图片 + 转场在本机用 ffmpeg 编码为低分辨率 MP4，无需服务端
+    Q_INVOKABLE bool isLocalExportAvailable() const;
+    Q_INVOKABLE void exportDraftVideo(const QString &storyId, const QVariantList &shots);
+    Q_INVOKABLE void cancelDraftExport(const QString &storyId);
+
+    // [新增] 视口优先级：StoryboardPage 滚动时上报可见分镜区间 (模型下标，含两端)，
+    // 可见分镜的图片任务优先，其次按与可见区间的距离排序
+    Q_INVOKABLE void setVisibleShotRange(const QString &storyId, int first, int last);
+
+    // [新增] 媒体缓存：已缓存返回本地 file:// URL，否则原样返回远程 URL
+    Q_INVOKABLE QString cachedMediaUrl(const QString &url);
+
+    // [新增] 导出视频到下载目录：优先从本地缓存克隆/硬链接，多个导出按顺序排队。返回目标路径
+    Q_INVOKABLE QString exportVideo(const QString &projectId, const QString &videoSource);
+
+    // [新增] 旁白配音：提交 TTS 任务，完成后音频流式下载进媒体缓存，并在后台生成多级波形峰值文件
+    Q_INVOKABLE void generateNarration(const QString &storyId, const QString &voice = QString());
+    // [新增] 时间线绘制用：[startSeconds, endSeconds) 内 buckets 对 (min, max)，取值 -1..1；
+    // 只读内存中的峰值，不解码音频。波形尚未就绪时返回空列表
+    Q_INVOKABLE QVariantList waveformPeaks(const QString &storyId, double startSeconds, double endSeconds, int buckets) const;
+    Q_INVOKABLE double narrationDuration(const QString &storyId) const;
+
+    // [新增] 热启动：从快照恢复的项目在后台重新拉取分镜列表 (结果经 storyboardGenerated 刷新页面)
+    Q_INVOKABLE void refreshProject(const QString &storyId);
+    // [新增] 退出时写入 SessionSnapshot 的当前项目：{ id, title, refreshable, shots }，
+    // 分镜图片已缓存时换成本地 file:// URL
+    QVariantMap sessionState();
+
+    // [新增] 分镜重排：把 shotId 移到模型下标 toIndex，只为它生成一个新的排序键 (OrderKey)。
+    // 返回 { orderKeys: { 分镜ID: 排序键 }, rebalanced }；键过长时整体重排，orderKeys 含全部分镜
+    Q_INVOKABLE QVariantMap moveShot(const QString &storyId, const QString &shotId, int toIndex);
+
+    // [新增] 自适应码率：PreviewPage 起播 (currentUrl 为空)、每个分段边界、卡顿 (stalled) 时调用。
+    // 返回 { url, resolution, bitrateKbps, estimateKbps, segmentSeconds }；项目没有多个档位时返回空 map，
+    // 页面继续播放原始地址。导出不受影响，始终使用最高档
+    Q_INVOKABLE QVariantMap selectRendition(const QString &storyId, const QString &currentUrl, bool stalled);
+
 signals:
     void storyboardGenerated(const QVariant &storyData);
     void generationFailed(const QString &errorMsg);
     void imageGenerationFinished(const QString &shotId, const QString &imageUrl);
     void compilationProgress(const QString &storyId, int percent);
+    // [新增] 预计剩余秒数 (基于历史耗时模型，与 compilationProgress 同步发出)
+    void compilationEta(const QString &storyId, int secondsRemaining);
+    // [新增] 服务端过载，提交在本地排队，约 retryAfterSeconds 秒后自动重试
+    void submissionDelayed(int retryAfterSeconds);
+
+    // [新增] 视频任务完成，携带真实资源 URL (同时已开始后台预取到本地缓存)
+    void videoResourceReady(const QString &storyId, const QString &videoUrl);
+    // [新增] 远程资源已下载到本地缓存
+    void mediaCached(const QString &url, const QString &localUrl);
+
+    // [新增] 旁白配音
+    void narrationProgress(const QString &storyId, int percent);
+    void narrationReady(const QString &storyId, const QString &audioUrl);       // 本地 file:// URL
+    void waveformReady(const QString &storyId, double durationSeconds);
+
+    // [新增] 视频导出
+    void exportProgress(const QString &projectId, int percent);
+    void exportFinished(const QString &projectId, const QString &filePath);
+    void exportFailed(const QString &projectId, const QString &errorMsg);
+
+    // [新增] 本地草稿导出
+    void draftExportProgress(const QString &storyId, int percent);
+    void draftExportFinished(const QString &storyId, const QString &videoUrl);
+    void draftExportFailed(const QString &storyId, const QString &errorMsg);
+    void draftExportCancelled(const QString &storyId);
 
 private slots:
     // [新增] 处理文本任务创建成功，启动文本任务轮询
-    void handleTextTaskCreated(const QString &projectId, const QString &textTaskId, const QVariantList &shotTaskIds);
+    void handleTextTaskCreated(const QString &projectId, const QString &textTaskId, const QVariantList &shotTaskIds,
+                               const QString &tag);
 
     // [修改/通用] 任务状态管理槽函数
-    void handleTaskCreated(const QString &taskId, const QString &shotId);
+    void handleTaskCreated(const QString &taskId, const QString &shotId, const QString &projectId);
+    void handleTtsTaskCreated(const QString &taskId, const QString &projectId);
     void handleTaskStatusReceived(const QString &taskId, int progress, const QString &status, const QString &message);
     void handleTaskResultReceived(const QString &taskId, const QVariantMap &resultData);
     void handleTaskRequestFailed(const QString &taskId, const QString &errorMsg);
@@ -48,10 +132,24 @@ private slots:
 
     void handleNetworkError(const QString &errorMsg);
 
+    // [新增] 合并滚动期间的可见区间变化后发送优先级提示
+    void sendPriorityHints();
+
+    // [新增] 前后台切换：调整轮询间隔，回到前台时立即刷新一次
+    void updateBackgroundState();
+
 
 private:
     NetworkManager *m_networkManager;
     QTimer *m_pollingTimer;
+    LocalVideoRenderer *m_localRenderer;
+    MediaCache *m_mediaCache;
+    ExportManager *m_exportManager;
+    DataManager *m_projectFiles; // [新增] 本地项目文件 project_<ID>.json (分镜排序键的持久化)
+    EtaModel *m_etaModel;        // [新增] 历史耗时模型：平滑进度、剩余时间、轮询节奏
+    AdaptiveBitrate *m_abr;      // [新增] 预览档位选择 (带宽来自媒体缓存的下载进度)
+    QHash<QString, QVector<AdaptiveBitrate::Rendition>> m_renditions;   // 项目 ID -> 视频档位 (码率升序)
+    QString m_lastStyle;         // 最近一次提交的风格 (耗时模型特征)
 
     // --- [新增] 状态存储 ---
     QString m_projectId;         // 当前项目的 ID
@@ -61,10 +159,65 @@ private:
     // 存储所有正在轮询的任务 ID -> 对应的 QML ID (用于 Stage 1, 2, 视频)
     QHash<QString, QVariantMap> m_activeTasks;
 
+    // --- [新增] 视口优先级 ---
+    QHash<QString, QVariantList> m_shotTasksByProject;  // 项目 ID -> shot_task_ids (按分镜顺序)
+    QHash<QString, QString> m_shotTaskOf;               // 分镜 ID -> 图片任务 ID
+    QStringList m_shotOrder;                            // 当前故事板的分镜顺序 (与 QML 模型一致)
+    QHash<QString, int> m_sentPriorities;               // 已发送的优先级，只发送变化的部分
+    QTimer *m_priorityTimer;
+    int m_visibleFirst;
+    int m_visibleLast;
+
+    // --- [新增] 后台感知轮询 ---
+    QPointer<QWindow> m_window;
+    bool m_inBackground;
+    void notifyCompletion(const QString &what);
+    // [新增] 按耗时模型插值后的进度/剩余时间发给 QML (服务端进度为 -1 表示只按时间推进)
+    void publishProgress(const QString &taskId, int serverProgress);
+    int shotCountOf(const QString &projectId) const;
+    // [新增] 开始跟踪并轮询一个服务端任务 (提交计数、耗时模型)
+    void trackTask(const QString &taskId, const QVariantMap &taskInfo);
+    // [新增] 任务结束时记录耗时指标 (outcome: succeeded / failed)
+    void recordTaskMetrics(const QVariantMap &taskInfo, const QString &outcome);
+
+    // --- [新增] 章节模式：长故事切成多个子项目并行生成，对 QML 呈现为一个逻辑项目 ---
+    struct ChapterProject {
+        QString id;                   // 逻辑项目 ID (QML 看到的 storyId)
+        QStringList subProjectIds;    // 按章节顺序的子项目 ID
+        QVector<QVariantList> shots;  // 各章节的分镜
+        QVector<int> progress;        // 各章节当前任务进度
+        QStringList videoUrls;        // 各章节成片 (远程 URL)
+        QStringList videoFiles;       // 各章节成片的本地缓存路径
+        int storyboardsReceived;
+    };
+    QHash<QString, ChapterProject> m_chapterProjects;  // 逻辑 ID -> 章节项目
+    QHash<QString, QString> m_chapterOf;               // 子项目 ID -> 逻辑 ID
+    QHash<QString, QString> m_shotProjects;            // 分镜 ID -> 所属子项目 (重生成时使用)
+
+    void startChapterProject(const QString &title, const QStringList &chapters, const QString &style, const QString &description);
+    void reportChapterProgress(const QString &subProjectId, int progress);
+    void collectChapterStoryboard(const QString &subProjectId, const QVariantList &shots);
+    void collectChapterVideo(const QString &subProjectId, const QString &videoUrl);
+    void onChapterVideoCached(const QString &url, const QString &localPath);
+
     // 私有辅助函数
     void processStoryboardResult(const QString &taskId, const QVariantMap &resultData);
     void processImageResult(const QString &shotId, const QVariantMap &resultData);
     void processVideoResult(const QString &storyId, const QVariantMap &resultData);
+    void processTtsResult(const QString &storyId, const QVariantMap &resultData);
+    void onNarrationCached(const QString &url, const QString &localPath);
+
+    // --- [新增] 旁白配音 ---
+    QHash<QString, QString> m_pendingNarration;   // 等待缓存的音频 URL -> 项目 ID
+    QHash<QString, WaveformPeaks> m_waveforms;    // 项目 ID -> 已载入的波形峰值
+
+    // --- [新增] 热启动快照 ---
+    QVariantMap m_sessionStory;                   // 最近一次发给 QML 的故事板 (含之后的图片更新)
+    void rememberStoryboard(const QVariantMap &storyMap);
+    void rememberShotImage(const QString &shotId, const QString &imageUrl);
+    void resetShotOrder(const QVariantList &shots);
+    void assignOrderKeys(const QString &storyId, QVariantList *shots);
+    void saveProjectFile(const QVariantMap &storyMap);
 
 };
 
@@ -0,0 +1,184 @@
+#include "adaptivebitrate.h"
+#include "metrics.h"
+#include <QVariantMap>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double FastHalfLifeSeconds = 2.0;
+const double SlowHalfLifeSeconds = 8.0;
+// 太小的样本主要反映请求延迟而不是带宽
+const qint64 MinSampleBytes = 32 * 1024;
+const qint64 MinSampleMs = 100;
+
+double decayFor(double halfLifeSeconds, double weightSeconds)
+{
+    return std::pow(0.5, weightSeconds / halfLifeSeconds);
+}
+
+// bitrate <= budget 的最高档；都超出时返回 0 (最低档)
+int highestWithin(const QVector<AdaptiveBitrate::Rendition> &renditions, double budgetKbps)
+{
+    int best = 0;
+    for (int i = 0; i < renditions.size(); ++i) {
+        if (renditions[i].bitrateKbps <= budgetKbps) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+AdaptiveBitrate::AdaptiveBitrate(QObject *parent)
+    : QObject(parent)
+    , m_enabled(qEnvironmentVariable("STV_ABR") != "0")
+    , m_segmentSeconds(qEnvironmentVariableIntValue("STV_ABR_SEGMENT_SECONDS"))
+    , m_fastKbps(0)
+    , m_slowKbps(0)
+    , m_totalWeightSeconds(0)
+{
+    m_clock.start();
+    // 未设置、无法解析或为 0 时，按秒数换算分段下标会除以 0，回退到默认值
+    if (m_segmentSeconds <= 0) {
+        m_segmentSeconds = DefaultSegmentSeconds;
+    }
+    if (!m_enabled) {
+        qDebug() << "AdaptiveBitrate: 已关闭 (STV_ABR=0)，预览直接播放最高档";
+    }
+    Metrics::instance()->gauge("stv_throughput_estimate_kbps", "Download throughput estimate used for rendition selection (-1 before the first sample).",
+                               this, [this]() { return estimateKbps(); });
+}
+
+
+// --- 1. 档位列表 ---
+QVector<AdaptiveBitrate::Rendition> AdaptiveBitrate::parse(const QVariantList &renditions, const QString &fullQualityUrl,
+                                                           const QString &baseUrl)
+{
+    QVector<Rendition> result;
+    int highestBitrate = 0;
+    bool hasFullQuality = false;
+    for (const QVariant &varRendition : renditions) {
+        const QVariantMap map = varRendition.toMap();
+        Rendition rendition;
+        rendition.url = map.value("url", map.value("resource_url")).toString();
+        rendition.resolution = map.value("resolution").toString();
+        rendition.bitrateKbps = map.value("bitrate", map.value("bitrate_kbps")).toInt();
+        if (rendition.url.isEmpty() || rendition.bitrateKbps <= 0) {
+            continue;
+        }
+        if (!rendition.url.startsWith("http", Qt::CaseInsensitive)) {
+            rendition.url = baseUrl + rendition.url;
+        }
+        hasFullQuality = hasFullQuality || rendition.url == fullQualityUrl;
+        highestBitrate = qMax(highestBitrate, rendition.bitrateKbps);
+        result.append(rendition);
+    }
+    if (result.isEmpty()) {
+        return result;   // 服务端没有给出档位：只有原始地址，不做自适应
+    }
+    if (!hasFullQuality && !fullQualityUrl.isEmpty()) {
+        Rendition full;
+        full.url = fullQualityUrl;
+        full.resolution = QStringLiteral("原始");
+        full.bitrateKbps = highestBitrate + 1;
+        result.append(full);
+    }
+    std::stable_sort(result.begin(), result.end(), [](const Rendition &a, const Rendition &b) {
+        return a.bitrateKbps < b.bitrateKbps;
+    });
+    return result;
+}
+
+
+// --- 2. 带宽估计 ---
+void AdaptiveBitrate::addProgress(const QString &url, qint64 receivedBytes, qint64 totalBytes)
+{
+    const qint64 now = m_clock.elapsed();
+    auto it = m_transfers.find(url);
+    if (it == m_transfers.end() || receivedBytes < it->bytes) {
+        // 新的下载：从第一次进度开始计时 (不把建立连接的时间算进带宽)
+        Transfer transfer;
+        transfer.bytes = receivedBytes;
+        transfer.atMs = now;
+        m_transfers.insert(url, transfer);
+        return;
+    }
+
+    const qint64 bytes = receivedBytes - it->bytes;
+    const qint64 durationMs = now - it->atMs;
+    const bool finished = totalBytes > 0 && receivedBytes >= totalBytes;
+    if ((bytes >= MinSampleBytes && durationMs >= MinSampleMs) || (finished && durationMs > 0 && bytes > 0)) {
+        addSample(bytes, durationMs);
+        it->bytes = receivedBytes;
+        it->atMs = now;
+    }
+    if (finished) {
+        m_transfers.erase(it);
+    }
+}
+
+void AdaptiveBitrate::addSample(qint64 bytes, qint64 durationMs)
+{
+    const double seconds = durationMs / 1000.0;
+    const double kbps = bytes * 8.0 / 1000.0 / seconds;
+    const double fastDecay = decayFor(FastHalfLifeSeconds, seconds);
+    const double slowDecay = decayFor(SlowHalfLifeSeconds, seconds);
+    m_fastKbps = kbps * (1 - fastDecay) + m_fastKbps * fastDecay;
+    m_slowKbps = kbps * (1 - slowDecay) + m_slowKbps * slowDecay;
+    m_totalWeightSeconds += seconds;
+}
+
+double AdaptiveBitrate::estimateKbps() const
+{
+    if (m_totalWeightSeconds <= 0) {
+        return -1;
+    }
+    // 两个平均值都从 0 起步，按已计入的总时长修正，否则开头会严重低估
+    const double fast = m_fastKbps / (1 - decayFor(FastHalfLifeSeconds, m_totalWeightSeconds));
+    const double slow = m_slowKbps / (1 - decayFor(SlowHalfLifeSeconds, m_totalWeightSeconds));
+    return qMin(fast, slow);
+}
+
+
+// --- 3. 选择档位 ---
+int AdaptiveBitrate::choose(const QVector<Rendition> &renditions, int currentIndex, bool stalled)
+{
+    if (renditions.isEmpty()) {
+        return -1;
+    }
+    const int top = renditions.size() - 1;
+    if (!m_enabled) {
+        return top;
+    }
+
+    const double estimate = estimateKbps();
+    int next = currentIndex;
+    if (currentIndex < 0 || currentIndex > top) {
+        // 起播：没有样本时从最低档开始，第一个分段边界再按实测带宽升档
+        next = estimate < 0 ? 0 : highestWithin(renditions, estimate * UpSwitchSafety);
+    } else if (stalled) {
+        next = qMax(0, currentIndex - 1);
+        if (estimate >= 0) {
+            next = qMin(next, highestWithin(renditions, estimate * StaySafety));
+        }
+    } else if (estimate >= 0) {
+        if (renditions[currentIndex].bitrateKbps > estimate * StaySafety) {
+            next = qMin(currentIndex, highestWithin(renditions, estimate * StaySafety));
+        } else {
+            next = qMax(currentIndex, highestWithin(renditions, estimate * UpSwitchSafety));
+        }
+    }
+
+    if (currentIndex >= 0 && next != currentIndex) {
+        const bool up = next > currentIndex;
+        qDebug() << "AdaptiveBitrate:" << (up ? "升档" : "降档") << renditions[currentIndex].resolution
+                 << "->" << renditions[next].resolution << "估计带宽" << qRound(estimate) << "kbps"
+                 << (stalled ? "(卡顿)" : "");
+        Metrics::instance()->counter("stv_rendition_switches_total", "Preview rendition switches, by direction.",
+                                     Metrics::label("direction", up ? "up" : "down"))->inc();
+    }
+    return next;
+}
@@ -0,0 +1,67 @@
+#ifndef ADAPTIVEBITRATE_H
+#define ADAPTIVEBITRATE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+
+// 自适应码率：视频任务同时给出多个档位 (分辨率/码率/地址)，预览按测得的下载带宽选择播放档位，
+// 播放中每到一个分段边界 (segmentSeconds()) 重新评估一次，卡顿时立即降一档。
+// 带宽来自媒体缓存的下载进度 (成片在任务完成时就开始后台预取)，用快/慢两个半衰期的指数滑动平均，取较小值。
+// 导出不经过这里，始终使用最高档的原始地址。STV_ABR=0 关闭，预览直接播放最高档；
+// STV_ABR_SEGMENT_SECONDS 调整分段长度 (缺省或非正数时用 DefaultSegmentSeconds)。
+class AdaptiveBitrate : public QObject
+{
+    Q_OBJECT
+public:
+    struct Rendition {
+        QString url;
+        QString resolution;    // 例如 1280x720
+        int bitrateKbps = 0;
+    };
+
+    explicit AdaptiveBitrate(QObject *parent = nullptr);
+
+    // 分段长度：两次档位评估之间至少播放这么久
+    static const int DefaultSegmentSeconds = 4;
+    // 升档只用估计带宽的 70%，保持当前档只要求 90% (避免在两档之间来回切换)
+    static constexpr double UpSwitchSafety = 0.7;
+    static constexpr double StaySafety = 0.9;
+
+    bool isEnabled() const { return m_enabled; }
+    int segmentSeconds() const { return m_segmentSeconds; }   // 始终为正数
+
+    // 任务结果中的 renditions (resolution / bitrate / url)，按码率升序；相对地址以 baseUrl 补全。
+    // fullQualityUrl (resource_url) 不在列表中时作为最高档补上
+    static QVector<Rendition> parse(const QVariantList &renditions, const QString &fullQualityUrl, const QString &baseUrl);
+
+    // 下载进度样本 (同一 URL 的累计字节数)；由 MediaCache::downloadProgress 驱动
+    void addProgress(const QString &url, qint64 receivedBytes, qint64 totalBytes);
+
+    // 估计带宽 (kbit/s)，还没有样本时返回 -1
+    double estimateKbps() const;
+
+    // 选择档位下标：currentIndex < 0 表示起播；stalled 表示刚刚卡顿
+    int choose(const QVector<Rendition> &renditions, int currentIndex, bool stalled);
+
+private:
+    struct Transfer {
+        qint64 bytes = 0;
+        qint64 atMs = 0;
+    };
+
+    void addSample(qint64 bytes, qint64 durationMs);
+
+    bool m_enabled;
+    int m_segmentSeconds;
+    QElapsedTimer m_clock;
+    QHash<QString, Transfer> m_transfers;   // URL -> 上次计入样本时的累计字节与时间
+    double m_fastKbps;                      // 半衰期 2 秒
+    double m_slowKbps;                      // 半衰期 8 秒
+    double m_totalWeightSeconds;            // 已计入的样本总时长，用于修正起始偏差
+};
+
+#endif // ADAPTIVEBITRATE_H
@@ -0,0 +1,218 @@
+#include "admissioncontroller.h"
+#include "metrics.h"
+#include <QDateTime>
+#include <QNetworkReply>
+#include <QTimer>
+#include <QDebug>
+
+// 两次窗口收缩的最小间隔
+static const qint64 DecreaseCooldownMs = 1000;
+
+AdmissionController::AdmissionController(QObject *parent)
+    : QObject(parent),
+      m_nextSlot(0),
+      m_window(InitialWindow),
+      m_lastQueueDepth(-1),
+      m_notBefore(0),
+      m_lastDecrease(0)
+{
+    m_resumeTimer = new QTimer(this);
+    m_resumeTimer->setSingleShot(true);
+    connect(m_resumeTimer, &QTimer::timeout, this, &AdmissionController::pump);
+
+    Metrics::instance()->gauge("stv_admission_window", "Current AIMD window for job submissions.",
+                               this, [this]() { return m_window; });
+    Metrics::instance()->gauge("stv_admission_queued", "Job submissions waiting in the local admission queue.",
+                               this, [this]() { return double(m_queue.size()); });
+}
+
+
+// --- 1. 排队与准入 ---
+void AdmissionController::submit(Sender sender)
+{
+    Pending pending;
+    pending.send = sender;
+    pending.attempts = 0;
+    m_queue.append(pending);
+    pump();
+}
+
+void AdmissionController::pump()
+{
+    const qint64 wait = backoffRemainingMs();
+    if (wait > 0) {
+        m_resumeTimer->start(int(wait));
+        return;
+    }
+    expireHolds();
+    while (!m_queue.isEmpty() && inFlight() < int(m_window)) {
+        Pending pending = m_queue.takeFirst();
+        ++pending.attempts;
+        QNetworkReply *reply = pending.send();
+        if (reply) {
+            m_inFlight.insert(reply, pending);
+        }
+    }
+    if (!m_queue.isEmpty()) {
+        qDebug() << "AdmissionController: 窗口" << m_window << "在途" << inFlight()
+                 << "排队" << m_queue.size();
+    }
+}
+
+qint64 AdmissionController::backoffRemainingMs() const
+{
+    return qMax<qint64>(0, m_notBefore - QDateTime::currentMSecsSinceEpoch());
+}
+
+
+// --- 2. 反馈 ---
+bool AdmissionController::finished(QNetworkReply *reply)
+{
+    auto it = m_inFlight.find(reply);
+    if (it == m_inFlight.end()) {
+        return false;
+    }
+    const Pending pending = it.value();
+    m_inFlight.erase(it);
+
+    const int depth = queueDepthHeader(reply);
+    if (depth >= 0) {
+        reportQueueDepth(depth);
+    }
+
+    if (isThrottled(reply)) {
+        const qint64 retryAfter = retryAfterMs(reply);
+        m_notBefore = qMax(m_notBefore, QDateTime::currentMSecsSinceEpoch() + retryAfter);
+        decrease();
+        Metrics::instance()->counter("stv_admission_throttled_total",
+                                     "Job submissions rejected by the server with 429/503.")->inc();
+        emit throttled(int((retryAfter + 999) / 1000));
+
+        if (pending.attempts < MaxAttempts) {
+            qDebug() << "AdmissionController: 服务端过载，" << retryAfter << "ms 后重试 (第"
+                     << pending.attempts << "次)，窗口缩小到" << m_window;
+            // 保持原有提交顺序：重试的请求排在队首
+            m_queue.prepend(pending);
+            pump();
+            return true;
+        }
+        qDebug() << "AdmissionController: 重试次数用尽，放弃该请求";
+        pump();
+        return false;
+    }
+
+    // 名额暂不释放：请求被接受时由它创建的任务继续占用，出错时由 hold() 的空列表释放。
+    // 只有成功且服务端不拥堵时才扩大窗口 (加性增长)
+    m_awaitingTasks.insert(reply);
+    if (reply->error() == QNetworkReply::NoError
+            && (m_lastQueueDepth < 0 || m_lastQueueDepth <= QueueDepthLowWater)) {
+        m_window = qMin<double>(MaxWindow, m_window + 1.0 / m_window);
+    }
+    pump();
+    return false;
+}
+
+void AdmissionController::hold(QNetworkReply *reply, const QStringList &taskIds)
+{
+    if (!m_awaitingTasks.remove(reply)) {
+        return;
+    }
+    if (!taskIds.isEmpty()) {
+        const int slot = m_nextSlot++;
+        m_heldSince.insert(slot, QDateTime::currentMSecsSinceEpoch());
+        for (const QString &taskId : taskIds) {
+            m_taskSlot.insert(taskId, slot);
+        }
+    }
+    pump();
+}
+
+void AdmissionController::taskEnded(const QString &taskId)
+{
+    auto it = m_taskSlot.find(taskId);
+    if (it == m_taskSlot.end()) {
+        return;
+    }
+    const int slot = it.value();
+    m_taskSlot.erase(it);
+    // 同一次提交创建的任务都结束后才释放
+    if (m_taskSlot.values().contains(slot)) {
+        return;
+    }
+    releaseSlot(slot);
+    pump();
+}
+
+void AdmissionController::releaseSlot(int slot)
+{
+    m_heldSince.remove(slot);
+    for (auto it = m_taskSlot.begin(); it != m_taskSlot.end();) {
+        it = it.value() == slot ? m_taskSlot.erase(it) : it + 1;
+    }
+}
+
+void AdmissionController::expireHolds()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const QList<int> slots = m_heldSince.keys();
+    for (int slot : slots) {
+        if (now - m_heldSince.value(slot) > MaxHoldMs) {
+            qDebug() << "AdmissionController: 任务长时间没有终态，释放名额" << m_taskSlot.keys(slot);
+            releaseSlot(slot);
+        }
+    }
+}
+
+void AdmissionController::reportQueueDepth(int depth)
+{
+    m_lastQueueDepth = depth;
+    if (depth >= QueueDepthHighWater) {
+        decrease();
+    }
+}
+
+void AdmissionController::decrease()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - m_lastDecrease < DecreaseCooldownMs) {
+        return;
+    }
+    m_lastDecrease = now;
+    m_window = qMax(1.0, m_window / 2);
+}
+
+
+// --- 3. 响应解析 ---
+bool AdmissionController::isThrottled(QNetworkReply *reply)
+{
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    return status == 429 || status == 503;
+}
+
+qint64 AdmissionController::retryAfterMs(QNetworkReply *reply)
+{
+    const QByteArray value = reply->rawHeader("Retry-After").trimmed();
+    if (value.isEmpty()) {
+        return DefaultRetryAfterMs;
+    }
+    bool ok = false;
+    const qint64 seconds = value.toLongLong(&ok);
+    qint64 ms = DefaultRetryAfterMs;
+    if (ok) {
+        ms = seconds * 1000;
+    } else {
+        // HTTP 日期格式: "Wed, 21 Oct 2015 07:28:00 GMT"
+        const QDateTime at = QDateTime::fromString(QString::fromLatin1(value), Qt::RFC2822Date);
+        if (at.isValid()) {
+            ms = QDateTime::currentDateTimeUtc().msecsTo(at);
+        }
+    }
+    return qBound<qint64>(0, ms, MaxRetryAfterMs);
+}
+
+int AdmissionController::queueDepthHeader(QNetworkReply *reply)
+{
+    bool ok = false;
+    const int depth = reply->rawHeader("X-Queue-Depth").trimmed().toInt(&ok);
+    return ok ? depth : -1;
+}
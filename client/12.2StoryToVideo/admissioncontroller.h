@@ -0,0 +1,93 @@
+#ifndef ADMISSIONCONTROLLER_H
+#define ADMISSIONCONTROLLER_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+#include <functional>
+
+class QNetworkReply;
+class QTimer;
+
+// 提交类请求 (创建项目 / 重生成分镜 / 生成视频) 的本地准入队列。
+// - 同时在途的提交数受 AIMD 窗口限制：成功一次窗口加 1/窗口，被限流时减半。
+//   提交被接受后名额由它创建的服务端任务继续占用，任务到达终态 (finished/failed/cancelled) 才释放；
+//   创建项目例外，被接受即释放 (章节模式的子项目需要同时提交)
+// - 服务端返回 429/503 时按 Retry-After 暂停所有提交，原请求重新排到队首
+// - 任务查询结果中的队列深度 (X-Queue-Depth / queue_depth) 过高时同样收缩窗口，低时才允许增长
+class AdmissionController : public QObject
+{
+    Q_OBJECT
+public:
+    // 被准入时调用，负责真正发出请求并返回 reply
+    typedef std::function<QNetworkReply *()> Sender;
+
+    explicit AdmissionController(QObject *parent = nullptr);
+
+    static const int InitialWindow = 2;
+    static const int MaxWindow = 8;
+    static const int MaxAttempts = 5;            // 同一请求最多被限流重试的次数
+    static const int QueueDepthHighWater = 16;   // 服务端排队超过该值时收缩窗口
+    static const int QueueDepthLowWater = 4;     // 服务端排队低于该值时才允许扩大窗口
+    static const int DefaultRetryAfterMs = 2000;
+    static const int MaxRetryAfterMs = 120000;
+    static const int MaxHoldMs = 15 * 60 * 1000; // 任务迟迟没有终态 (例如已不再轮询) 时名额最多保留这么久
+
+    void submit(Sender sender);
+
+    // 提交类请求结束时调用。返回 true 表示被限流且已重新排队，调用方应忽略该 reply；
+    // 否则名额仍被占用，调用方解析出任务 ID 后必须调用 hold()
+    bool finished(QNetworkReply *reply);
+
+    // 名额转交给 reply 创建的任务，全部任务结束 (taskEnded) 后释放；taskIds 为空 (请求失败/未返回任务) 时立即释放
+    void hold(QNetworkReply *reply, const QStringList &taskIds);
+
+    // 任务到达终态或不再被跟踪
+    void taskEnded(const QString &taskId);
+
+    // 来自任意响应的服务端队列深度提示
+    void reportQueueDepth(int depth);
+
+    // 429 / 503 视为过载
+    static bool isThrottled(QNetworkReply *reply);
+    // Retry-After (秒数或 HTTP 日期)，缺省时返回 DefaultRetryAfterMs
+    static qint64 retryAfterMs(QNetworkReply *reply);
+    // 响应头 X-Queue-Depth，没有时返回 -1
+    static int queueDepthHeader(QNetworkReply *reply);
+
+    double window() const { return m_window; }
+    int queued() const { return m_queue.size(); }
+    int inFlight() const { return m_inFlight.size() + m_awaitingTasks.size() + m_heldSince.size(); }
+    qint64 backoffRemainingMs() const;
+
+signals:
+    // 服务端要求暂停提交 (可用于界面提示)
+    void throttled(int retryAfterSeconds);
+
+private:
+    struct Pending {
+        Sender send;
+        int attempts;
+    };
+
+    void pump();
+    void decrease();
+    void releaseSlot(int slot);
+    void expireHolds();
+
+    QList<Pending> m_queue;
+    QHash<QNetworkReply *, Pending> m_inFlight;
+    QSet<QNetworkReply *> m_awaitingTasks;   // 已返回、尚未 hold() 的提交
+    QHash<int, qint64> m_heldSince;          // 由任务占用的名额 -> 开始占用的时间 (ms)
+    QHash<QString, int> m_taskSlot;          // 任务 ID -> 名额
+    int m_nextSlot;
+    double m_window;
+    int m_lastQueueDepth;
+    qint64 m_notBefore;        // 在此时间 (ms) 之前不发新的提交
+    qint64 m_lastDecrease;     // 限制收缩频率，一批并发的 429 只减半一次
+    QTimer *m_resumeTimer;
+};
+
+#endif // ADMISSIONCONTROLLER_H
@@ -0,0 +1,348 @@
+#include "assetindex.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetIndex::AssetIndex(QObject *parent)
+    : QObject(parent), m_duplicateCount(0)
+{
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(2000); // 合并短时间内的多次写入
+    connect(m_saveTimer, &QTimer::timeout, this, &AssetIndex::save);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+            if (m_saveTimer->isActive())
+                save();
+        });
+    }
+
+    load();
+}
+
+AssetIndex *AssetIndex::instance()
+{
+    static AssetIndex *s_instance = new AssetIndex(QCoreApplication::instance());
+    return s_instance;
+}
+
+
+// --- 1. 记录与查询 ---
+void AssetIndex::recordImage(const QString &path, quint64 hash)
+{
+    QMetaObject::invokeMethod(this, [this, path, hash]() {
+        insertEntry(path, hash, true);
+    }, Qt::AutoConnection);
+}
+
+void AssetIndex::recordContentDigest(const QString &path, const QByteArray &sha256)
+{
+    QMetaObject::invokeMethod(this, [this, path, sha256]() {
+        if (m_contentDigests.value(path) != sha256) {
+            m_contentDigests.insert(path, sha256);
+            m_saveTimer->start();
+        }
+    }, Qt::AutoConnection);
+}
+
+void AssetIndex::insertEntry(const QString &path, quint64 hash, bool notify)
+{
+    auto it = m_byPath.constFind(path);
+    if (it != m_byPath.constEnd()) {
+        Entry &existing = m_entries[it.value()];
+        if (existing.hash == hash) {
+            return;
+        }
+        // 同一路径的图片被重新生成：更新哈希，旧的字节摘要作废，重建树并重算重复关系 (BK-tree 不支持删除)
+        existing.hash = hash;
+        m_contentDigests.remove(path);
+        rebuildDuplicates(notify);
+        m_saveTimer->start();
+        return;
+    }
+
+    Entry entry;
+    entry.path = path;
+    entry.hash = hash;
+
+    int distance = 0;
+    const int nearest = m_tree.nearest(hash, DuplicateThreshold, &distance);
+    if (nearest >= 0) {
+        const Entry &original = m_entries[nearest];
+        entry.duplicateOf = original.duplicateOf.isEmpty() ? original.path : original.duplicateOf;
+    }
+
+    m_entries.append(entry);
+    m_byPath.insert(path, m_entries.size() - 1);
+    m_tree.insert(hash, m_entries.size() - 1);
+
+    if (!entry.duplicateOf.isEmpty()) {
+        ++m_duplicateCount;
+        if (notify) {
+            qDebug() << "AssetIndex: 检测到近似重复图片" << path << "≈" << entry.duplicateOf << "距离" << distance;
+            emit duplicateDetected(path, entry.duplicateOf, distance);
+            emit duplicatesChanged();
+        }
+    }
+    if (notify) {
+        m_saveTimer->start();
+    }
+}
+
+// 按插入顺序重新计算全部重复关系：哈希变化既影响原来指向该图片的条目 (旧邻域)，
+// 也影响新哈希附近的条目 (新邻域)，整体重算与逐条插入的结果一致且不会遗漏
+void AssetIndex::rebuildDuplicates(bool notify)
+{
+    m_tree.clear();
+    int count = 0;
+    bool changed = false;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        Entry &entry = m_entries[i];
+        int distance = 0;
+        const int nearest = m_tree.nearest(entry.hash, DuplicateThreshold, &distance);
+        QString original;
+        if (nearest >= 0) {
+            const Entry &candidate = m_entries[nearest];
+            original = candidate.duplicateOf.isEmpty() ? candidate.path : candidate.duplicateOf;
+        }
+        if (original != entry.duplicateOf) {
+            changed = true;
+            entry.duplicateOf = original;
+            if (notify && !original.isEmpty()) {
+                qDebug() << "AssetIndex: 检测到近似重复图片" << entry.path << "≈" << original << "距离" << distance;
+                emit duplicateDetected(entry.path, original, distance);
+            }
+        }
+        if (!original.isEmpty()) {
+            ++count;
+        }
+        m_tree.insert(entry.hash, i);
+    }
+
+    if (changed || count != m_duplicateCount) {
+        m_duplicateCount = count;
+        if (notify) {
+            emit duplicatesChanged();
+        }
+    }
+}
+
+QString AssetIndex::duplicateOf(const QString &path) const
+{
+    auto it = m_byPath.constFind(path);
+    return it == m_byPath.constEnd() ? QString() : m_entries[it.value()].duplicateOf;
+}
+
+QVariantList AssetIndex::findSimilar(const QString &path, int maxDistance) const
+{
+    QVariantList result;
+    auto it = m_byPath.constFind(path);
+    if (it == m_byPath.constEnd()) {
+        return result;
+    }
+
+    const QVector<QPair<int, int>> matches = m_tree.query(m_entries[it.value()].hash, maxDistance);
+    for (const QPair<int, int> &match : matches) {
+        if (match.first == it.value()) {
+            continue;
+        }
+        QVariantMap item;
+        item["path"] = m_entries[match.first].path;
+        item["distance"] = match.second;
+        result.append(item);
+    }
+    return result;
+}
+
+QString AssetIndex::hashOf(const QString &path) const
+{
+    auto it = m_byPath.constFind(path);
+    return it == m_byPath.constEnd() ? QString() : ImageHash::toHex(m_entries[it.value()].hash);
+}
+
+
+// --- 2. 存储去重 ---
+static QByteArray fileDigest(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(&file);
+    return hash.result();
+}
+
+QByteArray AssetIndex::contentDigest(const QString &path)
+{
+    auto it = m_contentDigests.constFind(path);
+    if (it != m_contentDigests.constEnd()) {
+        return it.value();
+    }
+    const QByteArray digest = fileDigest(path);
+    if (!digest.isEmpty()) {
+        m_contentDigests.insert(path, digest);
+        m_saveTimer->start();
+    }
+    return digest;
+}
+
+static bool isSameFile(const QString &a, const QString &b)
+{
+#ifdef Q_OS_WIN
+    Q_UNUSED(a);
+    Q_UNUSED(b);
+    return false;
+#else
+    struct stat sa, sb;
+    if (::stat(QFile::encodeName(a).constData(), &sa) != 0 ||
+        ::stat(QFile::encodeName(b).constData(), &sb) != 0) {
+        return false;
+    }
+    return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+#endif
+}
+
+// 用 source 原子地替换 target：任何时刻 target 要么是原文件，要么是新链接
+static bool replaceFile(const QString &source, const QString &target)
+{
+#ifdef Q_OS_WIN
+    return MoveFileExW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(source).utf16()),
+                       reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(target).utf16()),
+                       MOVEFILE_REPLACE_EXISTING);
+#else
+    return ::rename(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#endif
+}
+
+static bool createHardLink(const QString &target, const QString &linkPath)
+{
+#ifdef Q_OS_WIN
+    return CreateHardLinkW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(linkPath).utf16()),
+                           reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(target).utf16()),
+                           nullptr);
+#else
+    return ::link(QFile::encodeName(target).constData(), QFile::encodeName(linkPath).constData()) == 0;
+#endif
+}
+
+qint64 AssetIndex::dedupeStorage()
+{
+    qint64 saved = 0;
+    for (const Entry &entry : m_entries) {
+        if (entry.duplicateOf.isEmpty()) {
+            continue;
+        }
+        auto original = m_byPath.constFind(entry.duplicateOf);
+        if (original == m_byPath.constEnd() || m_entries[original.value()].hash != entry.hash) {
+            continue;
+        }
+
+        // 感知哈希只负责筛选候选，真正合并前要求字节完全一致
+        // (下载时已记录的 SHA-256 直接使用，缺失时才读文件计算)
+        const QFileInfo info(entry.path);
+        if (!info.exists() || info.size() != QFileInfo(entry.duplicateOf).size() ||
+            isSameFile(entry.path, entry.duplicateOf) ||
+            contentDigest(entry.path) != contentDigest(entry.duplicateOf)) {
+            continue;
+        }
+
+        const QString tempPath = entry.path + ".dedupe";
+        QFile::remove(tempPath);
+        if (!createHardLink(entry.duplicateOf, tempPath)) {
+            qDebug() << "AssetIndex: 硬链接失败 (可能跨文件系统):" << entry.path;
+            continue;
+        }
+        // 不能先删后改名：两步之间崩溃会丢掉文件
+        if (!replaceFile(tempPath, entry.path)) {
+            qDebug() << "AssetIndex: 替换为硬链接失败:" << entry.path;
+            QFile::remove(tempPath);
+            continue;
+        }
+        saved += info.size();
+    }
+
+    qDebug() << "AssetIndex: 存储去重完成，节省字节数:" << saved;
+    return saved;
+}
+
+
+// --- 3. 持久化 ---
+QString AssetIndex::storagePath() const
+{
+    // 与 DataManager 共用 AppDataLocation/data 目录
+    QString dirPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/data/";
+    QDir dir(dirPath);
+    if (!dir.exists())
+        dir.mkpath(dirPath);
+    return dirPath + "asset_index.json";
+}
+
+void AssetIndex::load()
+{
+    QFile file(storagePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QJsonArray items = QJsonDocument::fromJson(file.readAll()).object()["images"].toArray();
+    for (const QJsonValue &value : items) {
+        const QJsonObject obj = value.toObject();
+        const QString path = obj["path"].toString();
+        bool ok = false;
+        const quint64 hash = ImageHash::fromHex(obj["dhash"].toString(), &ok);
+        // 已被删除的资产不再参与比对
+        if (ok && QFile::exists(path)) {
+            insertEntry(path, hash, false);
+            const QByteArray digest = QByteArray::fromHex(obj["sha256"].toString().toLatin1());
+            if (digest.size() == 32) {
+                m_contentDigests.insert(path, digest);
+            }
+        }
+    }
+    qDebug() << "AssetIndex 加载完成，图片数:" << m_entries.size() << "近似重复:" << m_duplicateCount;
+}
+
+void AssetIndex::save()
+{
+    QJsonArray items;
+    for (const Entry &entry : m_entries) {
+        QJsonObject obj;
+        obj["path"] = entry.path;
+        obj["dhash"] = ImageHash::toHex(entry.hash);
+        if (!entry.duplicateOf.isEmpty()) {
+            obj["duplicateOf"] = entry.duplicateOf;
+        }
+        const QByteArray digest = m_contentDigests.value(entry.path);
+        if (!digest.isEmpty()) {
+            obj["sha256"] = QString::fromLatin1(digest.toHex());
+        }
+        items.append(obj);
+    }
+
+    QJsonObject root;
+    root["version"] = 1;
+    root["images"] = items;
+
+    QFile file(storagePath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "AssetIndex 保存失败:" << storagePath();
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+}
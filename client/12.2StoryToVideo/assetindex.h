@@ -0,0 +1,70 @@
+#ifndef ASSETINDEX_H
+#define ASSETINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QVariantList>
+#include <QTimer>
+#include "imagehash.h"
+
+// 资产索引：记录进入缓存的图片的感知哈希，用于近似重复检测
+// 持久化到 AppDataLocation/data/asset_index.json，启动时重建 BK-tree
+class AssetIndex : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int duplicateCount READ duplicateCount NOTIFY duplicatesChanged)
+
+public:
+    explicit AssetIndex(QObject *parent = nullptr);
+
+    static AssetIndex *instance();
+
+    // 汉明距离不超过该值视为近似重复
+    static const int DuplicateThreshold = 6;
+
+    // 可在任意线程调用 (缩略图/缓存工作线程)，实际修改排队到索引所在线程执行
+    void recordImage(const QString &path, quint64 hash);
+
+    // 下载时已增量计算的 SHA-256 (原始字节)；存储去重直接比对，不再从磁盘读回文件
+    void recordContentDigest(const QString &path, const QByteArray &sha256);
+
+    int duplicateCount() const { return m_duplicateCount; }
+
+    // --- QML 接口 ---
+    Q_INVOKABLE QString duplicateOf(const QString &path) const;
+    Q_INVOKABLE QVariantList findSimilar(const QString &path, int maxDistance = DuplicateThreshold) const;
+    Q_INVOKABLE QString hashOf(const QString &path) const;
+
+    // 将与原件完全一致 (距离 0 且字节相同) 的重复文件替换为硬链接，返回节省的字节数
+    Q_INVOKABLE qint64 dedupeStorage();
+
+signals:
+    void duplicatesChanged();
+    void duplicateDetected(const QString &path, const QString &originalPath, int distance);
+
+private slots:
+    void save();
+
+private:
+    struct Entry {
+        QString path;
+        quint64 hash;
+        QString duplicateOf;
+    };
+
+    void insertEntry(const QString &path, quint64 hash, bool notify);
+    void rebuildDuplicates(bool notify);
+    QByteArray contentDigest(const QString &path);
+    void load();
+    QString storagePath() const;
+
+    QVector<Entry> m_entries;
+    QHash<QString, int> m_byPath;
+    QHash<QString, QByteArray> m_contentDigests;
+    BkTree m_tree;
+    int m_duplicateCount;
+    QTimer *m_saveTimer;
+};
+
+#endif // ASSETINDEX_H
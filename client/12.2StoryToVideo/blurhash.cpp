@@ -0,0 +1,162 @@
+#include "blurhash.h"
+#include <QUrl>
+#include <QVector>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const double Pi = 3.14159265358979323846;
+
+const char Base83Chars[] =
+        "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz#$%*+,-.:;=?@[]^_{|}~";
+
+int base83Value(QChar c)
+{
+    const char *p = c.unicode() < 128 ? std::strchr(Base83Chars, char(c.unicode())) : nullptr;
+    return (p && *p) ? int(p - Base83Chars) : -1;
+}
+
+// 非法字符返回 -1
+int decode83(const QString &hash, int from, int length)
+{
+    int value = 0;
+    for (int i = from; i < from + length; ++i) {
+        const int digit = base83Value(hash.at(i));
+        if (digit < 0) {
+            return -1;
+        }
+        value = value * 83 + digit;
+    }
+    return value;
+}
+
+double srgbToLinear(int value)
+{
+    const double v = value / 255.0;
+    return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+}
+
+int linearToSrgb(double value)
+{
+    const double v = qBound(0.0, value, 1.0);
+    const double srgb = v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1 / 2.4) - 0.055;
+    return qBound(0, int(srgb * 255 + 0.5), 255);
+}
+
+double signPow(double value, double exponent)
+{
+    return std::copysign(std::pow(std::fabs(value), exponent), value);
+}
+
+} // namespace
+
+
+// --- 1. 解码 ---
+bool BlurHash::isValid(const QString &hash)
+{
+    if (hash.size() < 6) {
+        return false;
+    }
+    const int sizeFlag = decode83(hash, 0, 1);
+    if (sizeFlag < 0) {
+        return false;
+    }
+    const int componentsX = sizeFlag % 9 + 1;
+    const int componentsY = sizeFlag / 9 + 1;
+    if (hash.size() != 4 + 2 * componentsX * componentsY) {
+        return false;
+    }
+    for (const QChar c : hash) {
+        if (base83Value(c) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QImage BlurHash::decode(const QString &hash, int width, int height, double punch)
+{
+    if (!isValid(hash) || width <= 0 || height <= 0) {
+        return QImage();
+    }
+    const int sizeFlag = decode83(hash, 0, 1);
+    const int componentsX = sizeFlag % 9 + 1;
+    const int componentsY = sizeFlag / 9 + 1;
+    const double maxValue = (decode83(hash, 1, 1) + 1) / 166.0 * punch;
+
+    // 分量颜色 (线性空间)：第 0 个为 DC (平均色)，其余为量化后的 AC
+    QVector<double> colors(componentsX * componentsY * 3);
+    const int dc = decode83(hash, 2, 4);
+    colors[0] = srgbToLinear(dc >> 16);
+    colors[1] = srgbToLinear((dc >> 8) & 255);
+    colors[2] = srgbToLinear(dc & 255);
+    for (int i = 1; i < componentsX * componentsY; ++i) {
+        const int value = decode83(hash, 4 + i * 2, 2);
+        colors[i * 3] = signPow((value / (19 * 19) - 9) / 9.0, 2.0) * maxValue;
+        colors[i * 3 + 1] = signPow((value / 19 % 19 - 9) / 9.0, 2.0) * maxValue;
+        colors[i * 3 + 2] = signPow((value % 19 - 9) / 9.0, 2.0) * maxValue;
+    }
+
+    // 余弦基按行/列预先算好，逐像素只剩乘加
+    QVector<double> cosX(width * componentsX);
+    for (int x = 0; x < width; ++x) {
+        for (int i = 0; i < componentsX; ++i) {
+            cosX[x * componentsX + i] = std::cos(Pi * x * i / width);
+        }
+    }
+    QVector<double> cosY(height * componentsY);
+    for (int y = 0; y < height; ++y) {
+        for (int j = 0; j < componentsY; ++j) {
+            cosY[y * componentsY + j] = std::cos(Pi * y * j / height);
+        }
+    }
+
+    QImage image(width, height, QImage::Format_RGB32);
+    for (int y = 0; y < height; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; ++x) {
+            double r = 0, g = 0, b = 0;
+            for (int j = 0; j < componentsY; ++j) {
+                for (int i = 0; i < componentsX; ++i) {
+                    const double basis = cosX[x * componentsX + i] * cosY[y * componentsY + j];
+                    const int index = (j * componentsX + i) * 3;
+                    r += colors[index] * basis;
+                    g += colors[index + 1] * basis;
+                    b += colors[index + 2] * basis;
+                }
+            }
+            line[x] = qRgb(linearToSrgb(r), linearToSrgb(g), linearToSrgb(b));
+        }
+    }
+    return image;
+}
+
+
+// --- 2. BlurHashProvider ---
+BlurHashProvider::BlurHashProvider()
+    : QQuickImageProvider(QQuickImageProvider::Image)
+{
+}
+
+QImage BlurHashProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    // '#'、'?'、'%' 等字符在 URL 中保持编码，这里解回原始 hash
+    const QString hash = QUrl::fromPercentEncoding(id.toUtf8());
+    const int width = requestedSize.width() > 0 ? qMin(requestedSize.width(), 128) : DefaultSize;
+    const int height = requestedSize.height() > 0 ? qMin(requestedSize.height(), 128) : DefaultSize;
+
+    const QImage image = BlurHash::decode(hash, width, height);
+    if (size) {
+        *size = image.size();
+    }
+    return image;
+}
+
+QString BlurHashProvider::urlFor(const QString &hash)
+{
+    if (!BlurHash::isValid(hash)) {
+        return QString();
+    }
+    return "image://placeholder/" + QString::fromLatin1(QUrl::toPercentEncoding(hash));
+}
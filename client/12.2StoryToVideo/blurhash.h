@@ -0,0 +1,34 @@
+#ifndef BLURHASH_H
+#define BLURHASH_H
+
+#include <QImage>
+#include <QQuickImageProvider>
+#include <QString>
+
+// BlurHash 解码：20~30 个字符描述一张图的低频 DCT 分量 (最多 9x9)，服务端随分镜列表下发，
+// 客户端解码成几十像素的模糊图，完整图片到达前先显示，故事板第一帧就 "有内容"。
+namespace BlurHash
+{
+    bool isValid(const QString &hash);
+
+    // 解码为 width x height 的 RGB32 图像；punch > 1 增强对比。无效时返回空图
+    QImage decode(const QString &hash, int width, int height, double punch = 1.0);
+}
+
+// QML 侧通过 "image://placeholder/<BlurHash>" 取占位图 (ID 需百分号编码，见 urlFor)。
+// 解码只有几千次乘加，直接在请求线程同步完成：Image 设为 asynchronous: false 时在首帧之前就绪。
+class BlurHashProvider : public QQuickImageProvider
+{
+public:
+    BlurHashProvider();
+
+    // 未指定 sourceSize 时的输出尺寸 (显示时由 GPU 放大，模糊图放大不失真)
+    static const int DefaultSize = 32;
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
+    // hash -> "image://placeholder/<编码后的 hash>"；无效 hash 返回空字符串
+    static QString urlFor(const QString &hash);
+};
+
+#endif // BLURHASH_H
@@ -0,0 +1,20 @@
+#include "commandline.h"
+
+CommandLine::Options CommandLine::parse(const QStringList &arguments)
+{
+    Options options;
+    for (const QString &argument : arguments) {
+        if (!argument.startsWith("--")) {
+            continue;
+        }
+        const int eq = argument.indexOf('=');
+        options.insert(eq < 0 ? argument : argument.left(eq), eq < 0 ? QString("") : argument.mid(eq + 1));
+    }
+    return options;
+}
+
+int CommandLine::intValue(const Options &options, const QString &key, int defaultValue, int minimum)
+{
+    const QString value = options.value(key);
+    return value.isEmpty() ? defaultValue : qMax(minimum, value.toInt());
+}
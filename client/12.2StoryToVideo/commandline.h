@@ -0,0 +1,20 @@
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+// 命令行模式 (基准、同步、浸泡测试等) 共用的参数解析：
+// "--key=value" 拆成 键 -> 值，"--key" 的值为空字符串；同一个键出现多次以最后一次为准，不以 "--" 开头的参数 (程序路径) 忽略
+namespace CommandLine
+{
+    typedef QHash<QString, QString> Options;
+
+    Options parse(const QStringList &arguments);
+
+    // 只给出 --key (没有值) 时返回 defaultValue，否则返回值与 minimum 中较大者
+    int intValue(const Options &options, const QString &key, int defaultValue, int minimum);
+}
+
+#endif // COMMANDLINE_H
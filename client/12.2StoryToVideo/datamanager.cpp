@@ -1,6 +1,8 @@
 #include "DataManager.h"
+#include "orderkey.h"
 #include <QDir>
 #include <QFile>
+#include <QHash>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QDebug>
@@ -14,7 +16,9 @@ DataManager::DataManager(QObject *parent)
 QString DataManager::getStoragePath(const QString &fileName)
 {
     // 使用系统标准的应用程序数据目录 (例如: ~/Library/Application Support/StoryToVideoGenerator/data/)
-    QString dirPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/data/";
+    QString dirPath = m_storageDir.isEmpty()
+            ? QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/data/"
+            : m_storageDir;
 
     QDir dir(dirPath);
     if (!dir.exists())
@@ -23,6 +27,16 @@ QString DataManager::getStoragePath(const QString &fileName)
     return dirPath + fileName;
 }
 
+void DataManager::setStorageDirectory(const QString &dirPath)
+{
+    m_storageDir = dirPath.isEmpty() || dirPath.endsWith('/') ? dirPath : dirPath + "/";
+}
+
+QString DataManager::orderJournalPath(const QString &fileName)
+{
+    return getStoragePath(fileName) + ".order";
+}
+
 bool DataManager::saveData(const QVariantMap &storyData, const QString &fileName)
 {
     QString path = getStoragePath(fileName);
@@ -36,6 +50,8 @@ bool DataManager::saveData(const QVariantMap &storyData, const QString &fileName
 
     file.write(doc.toJson(QJsonDocument::Indented));
     file.close();
+    // [新增] 项目文件已包含最新的排序键，之前的排序日志作废
+    QFile::remove(orderJournalPath(fileName));
 
     qDebug() << "保存成功:" << path;
     emit fileSaved(path);
@@ -58,6 +74,18 @@ QVariantMap DataManager::loadData(const QString &fileName)
     QJsonDocument doc = QJsonDocument::fromJson(data);
     QVariantMap map = doc.object().toVariantMap();
 
+    // [新增] 合并排序日志并按排序键排序；日志过长或旧数据补了排序键时整体保存一次
+    const int journalLines = applyOrderJournal(fileName, &map);
+    bool assignedKeys = false;
+    if (map.contains("shots")) {
+        QVariantList shots = map.value("shots").toList();
+        assignedKeys = OrderKey::normalize(&shots);
+        map["shots"] = shots;
+    }
+    if (journalLines > MaxOrderJournalLines || assignedKeys) {
+        saveData(map, fileName);
+    }
+
     qDebug() << "加载成功:" << path;
     emit fileLoaded(path);
 
@@ -70,6 +98,7 @@ bool DataManager::clearData(const QString &fileName)
 
     if (QFile::exists(path)) {
         QFile::remove(path);
+        QFile::remove(orderJournalPath(fileName));
         qDebug() << "删除成功:" << path;
         emit fileCleared(path);
         return true;
@@ -78,3 +107,56 @@ bool DataManager::clearData(const QString &fileName)
     qDebug() << "删除失败，文件不存在:" << path;
     return false;
 }
+
+// --- 分镜排序日志 ---
+bool DataManager::saveShotOrder(const QString &fileName, const QString &shotId, const QString &orderKey)
+{
+    if (shotId.isEmpty() || orderKey.isEmpty() || !QFile::exists(getStoragePath(fileName))) {
+        return false;
+    }
+
+    QFile journal(orderJournalPath(fileName));
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "保存排序失败:" << journal.fileName();
+        return false;
+    }
+    journal.write((shotId + '\t' + orderKey + '\n').toUtf8());
+    return true;
+}
+
+int DataManager::applyOrderJournal(const QString &fileName, QVariantMap *storyData)
+{
+    QFile journal(orderJournalPath(fileName));
+    if (!journal.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+
+    // 同一分镜可能被移动多次，以最后一行为准
+    QHash<QString, QString> keys;
+    int lines = 0;
+    while (!journal.atEnd()) {
+        const QByteArray raw = journal.readLine();
+        const QString line = QString::fromUtf8(raw).trimmed();
+        const int tab = line.indexOf('\t');
+        if (!raw.endsWith('\n') || tab <= 0) {
+            continue;   // 写到一半的行 (进程在追加时退出)
+        }
+        keys.insert(line.left(tab), line.mid(tab + 1));
+        ++lines;
+    }
+
+    if (!storyData->contains("shots")) {
+        return lines;
+    }
+    QVariantList shots = storyData->value("shots").toList();
+    for (QVariant &varShot : shots) {
+        QVariantMap shot = varShot.toMap();
+        const QString id = shot.value("id", shot.value("shotId")).toString();
+        if (keys.contains(id)) {
+            shot["orderKey"] = keys.value(id);
+            varShot = shot;
+        }
+    }
+    (*storyData)["shots"] = shots;
+    return lines;
+}
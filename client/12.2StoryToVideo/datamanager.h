@@ -14,6 +14,17 @@ public:
     Q_INVOKABLE QVariantMap loadData(const QString &fileName);
     Q_INVOKABLE bool clearData(const QString &fileName);
 
+    // [新增] 分镜排序：移动/插入一个分镜只在 <fileName>.order 追加一行 "分镜ID\t排序键"，
+    // 不重写整个项目文件；loadData 时合并并按排序键排序，saveData 时整体写入后清空。
+    // 项目文件不存在时返回 false
+    Q_INVOKABLE bool saveShotOrder(const QString &fileName, const QString &shotId, const QString &orderKey);
+
+    // 默认为 AppDataLocation/data/；基准测试指向临时目录
+    void setStorageDirectory(const QString &dirPath);
+
+    // 排序日志超过该行数时，loadData 合并后整体保存一次
+    static const int MaxOrderJournalLines = 512;
+
 signals:
     void fileSaved(const QString &filePath);
     void fileLoaded(const QString &filePath);
@@ -21,6 +32,10 @@ signals:
 
 private:
     QString getStoragePath(const QString &fileName);
+    QString orderJournalPath(const QString &fileName);
+    int applyOrderJournal(const QString &fileName, QVariantMap *storyData);
+
+    QString m_storageDir;
 };
 
 #endif // DATAMANAGER_H
@@ -0,0 +1,671 @@
+#include "deltasync.h"
+#include "commandline.h"
+#include "mediacache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QDebug>
+#include <array>
+
+namespace {
+
+const char ManifestFileName[] = ".stv-sync-manifest.json";
+const char TempSuffix[] = ".stv-sync-tmp";
+const int ReadBlockBytes = 1 << 20;
+const int MaxOpenReaders = 64;
+
+// log2(AvgChunkBytes)；归一化分块：未到平均长度时多判 2 位 (更难切)，超过后少判 2 位
+const int AvgBits = 16;
+static_assert((1 << AvgBits) == DeltaSync::AvgChunkBytes, "AvgBits must match AvgChunkBytes");
+
+quint64 splitmix64(quint64 &state)
+{
+    quint64 z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// gear 表用固定种子生成：两端必须得到完全相同的块边界
+const std::array<quint64, 256> &gearTable()
+{
+    static const std::array<quint64, 256> table = []() {
+        std::array<quint64, 256> values;
+        quint64 state = 0x5354562D43444300ULL;
+        for (quint64 &value : values) {
+            value = splitmix64(state);
+        }
+        return values;
+    }();
+    return table;
+}
+
+// gear 哈希左移累加，高位受最近 64 个字节影响，用高位判定边界
+inline bool isBoundary(quint64 hash, int bits)
+{
+    return (hash >> (64 - bits)) == 0;
+}
+
+QByteArray sha256Of(const QByteArray &data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha256);
+}
+
+bool sameContent(const DeltaSync::FileManifest &a, const DeltaSync::FileManifest &b)
+{
+    if (a.size != b.size || a.chunks.size() != b.chunks.size()) {
+        return false;
+    }
+    for (int i = 0; i < a.chunks.size(); ++i) {
+        if (a.chunks[i].sha256 != b.chunks[i].sha256) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 按相对路径打开并缓存读句柄，随机读取块。不缓冲：原地修补会改写仍被读取的文件，不能读到旧的缓冲数据
+class RangeReader
+{
+public:
+    explicit RangeReader(const QString &root) : m_root(root) {}
+    ~RangeReader() { qDeleteAll(m_files); }
+
+    QByteArray read(const QString &relativePath, qint64 offset, qint64 length)
+    {
+        QFile *file = m_files.value(relativePath);
+        if (!file) {
+            if (m_files.size() >= MaxOpenReaders) {
+                qDeleteAll(m_files);
+                m_files.clear();
+            }
+            file = new QFile(QDir(m_root).filePath(relativePath));
+            if (!file->open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+                delete file;
+                return QByteArray();
+            }
+            m_files.insert(relativePath, file);
+        }
+        if (!file->seek(offset)) {
+            return QByteArray();
+        }
+        return file->read(length);
+    }
+
+    void close(const QString &relativePath)
+    {
+        delete m_files.take(relativePath);
+    }
+
+private:
+    QString m_root;
+    QHash<QString, QFile *> m_files;
+};
+
+struct Location {
+    QString path;
+    qint64 offset;
+};
+
+// 基准用的确定性伪随机内容 (不可压缩，接近真实视频)
+bool writePseudoRandom(QFile &file, quint64 seed, qint64 bytes)
+{
+    QByteArray block(ReadBlockBytes, Qt::Uninitialized);
+    quint64 state = seed;
+    while (bytes > 0) {
+        const int n = int(qMin<qint64>(bytes, block.size()));
+        quint64 *words = reinterpret_cast<quint64 *>(block.data());
+        for (int i = 0; i < (n + 7) / 8; ++i) {
+            words[i] = splitmix64(state);
+        }
+        if (file.write(block.constData(), n) != n) {
+            return false;
+        }
+        bytes -= n;
+    }
+    return true;
+}
+
+double toMb(qint64 bytes)
+{
+    return bytes / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+
+// --- 1. 内容定义分块 ---
+QVector<DeltaSync::Chunk> DeltaSync::chunkFile(const QString &path, bool *ok)
+{
+    QVector<Chunk> chunks;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (ok) {
+            *ok = false;
+        }
+        return chunks;
+    }
+
+    const std::array<quint64, 256> &gear = gearTable();
+    QCryptographicHash digest(QCryptographicHash::Sha256);
+    quint64 hash = 0;
+    qint64 offset = 0;
+    qint64 length = 0;
+
+    for (;;) {
+        const QByteArray block = file.read(ReadBlockBytes);
+        if (block.isEmpty()) {
+            break;
+        }
+        const uchar *data = reinterpret_cast<const uchar *>(block.constData());
+        const int n = block.size();
+        int start = 0;
+        for (int i = 0; i < n; ++i) {
+            ++length;
+            // 最小块长度之内不找边界，也不必计算哈希
+            if (length <= MinChunkBytes) {
+                continue;
+            }
+            hash = (hash << 1) + gear[data[i]];
+            const bool cut = length >= MaxChunkBytes
+                    || isBoundary(hash, length < AvgChunkBytes ? AvgBits + 2 : AvgBits - 2);
+            if (!cut) {
+                continue;
+            }
+            digest.addData(QByteArray::fromRawData(block.constData() + start, i + 1 - start));
+            chunks.append(Chunk{offset, length, digest.result()});
+            digest.reset();
+            offset += length;
+            length = 0;
+            hash = 0;
+            start = i + 1;
+        }
+        if (start < n) {
+            digest.addData(QByteArray::fromRawData(block.constData() + start, n - start));
+        }
+    }
+    if (length > 0) {
+        chunks.append(Chunk{offset, length, digest.result()});
+    }
+    if (ok) {
+        *ok = file.error() == QFileDevice::NoError;
+    }
+    return chunks;
+}
+
+
+// --- 2. 目录清单 ---
+DeltaSync::Manifest DeltaSync::scan(const QString &root, qint64 *bytesRead)
+{
+    const Manifest cached = loadManifestCache(root);
+    Manifest manifest;
+    const QDir dir(root);
+    int rechunked = 0;
+
+    QDirIterator it(root, QDir::Files | QDir::Hidden | QDir::NoSymLinks, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        const QString relativePath = dir.relativeFilePath(path);
+        // 清单自身、同步临时文件与下载中的 .part 不参与同步
+        if (relativePath == QLatin1String(ManifestFileName) || relativePath.endsWith(TempSuffix)
+                || relativePath.endsWith(".part")) {
+            continue;
+        }
+        const QFileInfo info = it.fileInfo();
+        FileManifest entry;
+        entry.size = info.size();
+        entry.modified = info.lastModified().toMSecsSinceEpoch();
+
+        auto previous = cached.constFind(relativePath);
+        if (previous != cached.constEnd() && previous->size == entry.size && previous->modified == entry.modified) {
+            entry.chunks = previous->chunks;
+        } else {
+            bool ok = true;
+            entry.chunks = chunkFile(path, &ok);
+            if (!ok) {
+                qDebug() << "DeltaSync: 无法读取" << path;
+                continue;
+            }
+            ++rechunked;
+            if (bytesRead) {
+                *bytesRead += entry.size;
+            }
+        }
+        manifest.insert(relativePath, entry);
+    }
+
+    if (rechunked > 0 || manifest.size() != cached.size()) {
+        saveManifestCache(root, manifest);
+    }
+    return manifest;
+}
+
+DeltaSync::Manifest DeltaSync::loadManifestCache(const QString &root)
+{
+    Manifest manifest;
+    QFile file(QDir(root).filePath(ManifestFileName));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return manifest;
+    }
+    const QJsonObject files = QJsonDocument::fromJson(file.readAll()).object()["files"].toObject();
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        FileManifest entry;
+        entry.size = qint64(obj["size"].toDouble());
+        entry.modified = qint64(obj["modified"].toDouble());
+        qint64 offset = 0;
+        // 每个块存为 [长度, "sha256 十六进制"]，偏移按顺序累加
+        for (const QJsonValue &value : obj["chunks"].toArray()) {
+            const QJsonArray pair = value.toArray();
+            Chunk chunk;
+            chunk.offset = offset;
+            chunk.length = qint64(pair.at(0).toDouble());
+            chunk.sha256 = QByteArray::fromHex(pair.at(1).toString().toLatin1());
+            offset += chunk.length;
+            entry.chunks.append(chunk);
+        }
+        if (offset == entry.size) {
+            manifest.insert(it.key(), entry);
+        }
+    }
+    return manifest;
+}
+
+void DeltaSync::saveManifestCache(const QString &root, const Manifest &manifest)
+{
+    QJsonObject files;
+    for (auto it = manifest.constBegin(); it != manifest.constEnd(); ++it) {
+        QJsonArray chunks;
+        for (const Chunk &chunk : it->chunks) {
+            chunks.append(QJsonArray{double(chunk.length), QString::fromLatin1(chunk.sha256.toHex())});
+        }
+        QJsonObject obj;
+        obj["size"] = double(it->size);
+        obj["modified"] = double(it->modified);
+        obj["chunks"] = chunks;
+        files.insert(it.key(), obj);
+    }
+    QJsonObject document;
+    document["version"] = 1;
+    document["files"] = files;
+
+    // 源端可能是只读挂载，写不了就下次重新分块
+    QFile file(QDir(root).filePath(ManifestFileName));
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QJsonDocument(document).toJson(QJsonDocument::Compact));
+    }
+}
+
+
+// --- 3. 同步 ---
+DeltaSync::Stats DeltaSync::sync(const QString &sourceRoot, const QString &destinationRoot)
+{
+    Stats stats;
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!QFileInfo(sourceRoot).isDir()) {
+        stats.errors << "源目录不存在: " + sourceRoot;
+        return stats;
+    }
+    QDir().mkpath(destinationRoot);
+    const Manifest source = scan(sourceRoot, &stats.bytesScannedSource);
+    Manifest destination = scan(destinationRoot, &stats.bytesScannedDestination);
+
+    // 目标端已有的块：SHA-256 -> 所在文件与偏移 (同一内容只记第一处)
+    QHash<QByteArray, Location> local;
+    auto addLocal = [&local](const QString &relativePath, const FileManifest &entry) {
+        for (const Chunk &chunk : entry.chunks) {
+            if (!local.contains(chunk.sha256)) {
+                local.insert(chunk.sha256, Location{relativePath, chunk.offset});
+            }
+        }
+    };
+    for (auto it = destination.constBegin(); it != destination.constEnd(); ++it) {
+        addLocal(it.key(), it.value());
+    }
+
+    RangeReader sourceReader(sourceRoot);
+    RangeReader localReader(destinationRoot);
+    const QDir destinationDir(destinationRoot);
+
+    for (auto it = source.constBegin(); it != source.constEnd(); ++it) {
+        const QString &relativePath = it.key();
+        const FileManifest &wanted = it.value();
+        ++stats.filesScanned;
+        stats.bytesTotal += wanted.size;
+
+        const FileManifest existing = destination.value(relativePath);
+        const bool hadExisting = destination.contains(relativePath);
+        if (hadExisting && sameContent(existing, wanted)) {
+            ++stats.filesUnchanged;
+            continue;
+        }
+        stats.bytesChangedFiles += wanted.size;
+
+        // 目标端同一偏移上已是相同内容的块保持不动；其余块的来源：目标端已有的块 (本地读回) 或源端
+        QHash<qint64, QByteArray> existingAt;
+        for (const Chunk &chunk : existing.chunks) {
+            existingAt.insert(chunk.offset, chunk.sha256);
+        }
+        QVector<Location> sources(wanted.chunks.size(), Location{QString(), 0});   // 每个块的来源；path 为空表示从源端读取
+        QVector<bool> kept(wanted.chunks.size(), false);
+        bool forward = true;                  // 本文件内的块只向前移动：按顺序写不会覆盖尚未读取的来源
+        bool backward = true;                 // 只向后移动：倒序写
+        for (int i = 0; i < wanted.chunks.size(); ++i) {
+            const Chunk &chunk = wanted.chunks[i];
+            if (hadExisting && existingAt.value(chunk.offset) == chunk.sha256) {
+                kept[i] = true;
+                sources[i] = Location{relativePath, chunk.offset};
+                continue;
+            }
+            auto location = local.constFind(chunk.sha256);
+            if (location != local.constEnd()) {
+                sources[i] = location.value();
+            }
+            if (sources[i].path == relativePath) {
+                forward = forward && sources[i].offset >= chunk.offset;
+                backward = backward && sources[i].offset <= chunk.offset;
+            }
+        }
+        // 文件内的块前后交错移动时无法原地修补，先写临时文件再替换 (旧文件在整个重建过程中仍可作为块来源)
+        const bool inPlace = hadExisting && (forward || backward);
+        QVector<int> pending;                 // 需要写入的块 (wanted.chunks 下标)；临时文件需要全部的块
+        for (int i = 0; i < wanted.chunks.size(); ++i) {
+            if (!inPlace || !kept[i]) {
+                pending.append(i);
+            }
+        }
+
+        // 本文件即将改变：旧内容的块不再作为其他文件的来源，读句柄重新打开
+        localReader.close(relativePath);
+        for (const Chunk &chunk : existing.chunks) {
+            auto location = local.find(chunk.sha256);
+            if (location != local.end() && location->path == relativePath) {
+                local.erase(location);
+            }
+        }
+
+        const QString target = destinationDir.filePath(relativePath);
+        QDir().mkpath(QFileInfo(target).absolutePath());
+        QFile out(inPlace ? target : target + TempSuffix);
+        QString error;
+        qint64 reused = 0;
+        qint64 transferred = 0;
+        qint64 written = 0;
+        if (!out.open(inPlace ? QIODevice::ReadWrite : QIODevice::WriteOnly | QIODevice::Truncate)) {
+            error = "无法写入 " + out.fileName();
+        }
+        for (int n = 0; n < pending.size() && error.isEmpty(); ++n) {
+            const int k = pending[inPlace && !forward ? pending.size() - 1 - n : n];
+            const Chunk &chunk = wanted.chunks[k];
+            QByteArray data;
+            if (!sources[k].path.isEmpty()) {
+                data = localReader.read(sources[k].path, sources[k].offset, chunk.length);
+                reused += data.size();
+                if (sha256Of(data) != chunk.sha256) {
+                    data.clear(); // 目标端文件在扫描后被改动：改从源端读取
+                }
+            }
+            if (data.isEmpty()) {
+                data = sourceReader.read(relativePath, chunk.offset, chunk.length);
+                transferred += data.size();
+                if (data.size() != chunk.length || sha256Of(data) != chunk.sha256) {
+                    error = "源端文件在同步过程中被修改: " + relativePath;
+                    break;
+                }
+            }
+            // 临时文件按顺序写入，原地修补时只写变化的块
+            if ((inPlace && !out.seek(chunk.offset)) || out.write(data) != data.size()) {
+                error = "写入失败: " + out.fileName();
+            }
+            written += data.size();
+        }
+        if (error.isEmpty() && inPlace && !out.resize(wanted.size)) {
+            error = "无法截断 " + target;
+        }
+        if (error.isEmpty()) {
+            out.close();
+            if (!inPlace) {
+                QFile::remove(target);
+                if (!out.rename(target)) {
+                    error = "无法替换 " + target;
+                }
+            }
+        }
+        stats.bytesTransferred += transferred;
+        stats.bytesReused += reused;
+        stats.bytesWritten += written;
+        if (!error.isEmpty()) {
+            if (!inPlace) {
+                out.remove();
+            }
+            // 原地修补中途失败时文件内容不确定，下次扫描重新分块
+            destination.remove(relativePath);
+            ++stats.filesFailed;
+            stats.errors << error;
+            continue;
+        }
+
+        // 保留源端修改时间，并直接记下新文件的分块，下次扫描不必重新计算
+        QFile updated(target);
+        if (updated.open(QIODevice::ReadWrite)) {
+            updated.setFileTime(QDateTime::fromMSecsSinceEpoch(wanted.modified), QFileDevice::FileModificationTime);
+            updated.close();
+        }
+        FileManifest entry = wanted;
+        entry.modified = QFileInfo(target).lastModified().toMSecsSinceEpoch();
+        destination.insert(relativePath, entry);
+        addLocal(relativePath, entry);
+
+        if (inPlace) {
+            ++stats.filesPatched;
+        }
+        ++stats.filesUpdated;
+    }
+
+    saveManifestCache(destinationRoot, destination);
+    stats.elapsedMs = timer.elapsed();
+    return stats;
+}
+
+void DeltaSync::logStats(const QString &title, const Stats &stats)
+{
+    qDebug().noquote() << QString("DeltaSync [%1]: 文件 %2 个 (更新 %3，其中原地修补 %4；未变 %5，失败 %6)，总计 %7 MB，"
+                                  "需更新文件 %8 MB，耗时 %9 s")
+                          .arg(title)
+                          .arg(stats.filesScanned).arg(stats.filesUpdated).arg(stats.filesPatched)
+                          .arg(stats.filesUnchanged).arg(stats.filesFailed)
+                          .arg(toMb(stats.bytesTotal), 0, 'f', 1)
+                          .arg(toMb(stats.bytesChangedFiles), 0, 'f', 1)
+                          .arg(stats.elapsedMs / 1000.0, 0, 'f', 2);
+    qDebug().noquote() << QString("DeltaSync [%1]: 源端读取 %2 MB (扫描 %3 MB)；目标端读取 %4 MB (扫描 %5 MB)，写入 %6 MB")
+                          .arg(title)
+                          .arg(toMb(stats.bytesTransferred + stats.bytesScannedSource), 0, 'f', 2)
+                          .arg(toMb(stats.bytesScannedSource), 0, 'f', 2)
+                          .arg(toMb(stats.bytesReused + stats.bytesScannedDestination), 0, 'f', 2)
+                          .arg(toMb(stats.bytesScannedDestination), 0, 'f', 2)
+                          .arg(toMb(stats.bytesWritten), 0, 'f', 2);
+    for (const QString &error : stats.errors) {
+        qDebug().noquote() << "DeltaSync:" << error;
+    }
+}
+
+
+// --- 4. 命令行 ---
+bool DeltaSync::runFromArguments(const QStringList &arguments, int *exitCode)
+{
+    const CommandLine::Options options = CommandLine::parse(arguments);
+    const QString from = options.value("--sync-from");
+    const QString to = options.value("--sync-to");
+
+    if (options.contains("--sync-bench")) {
+        const qint64 benchMb = CommandLine::intValue(options, "--sync-bench", 1024, 16);
+        *exitCode = runBenchmark(benchMb * 1024 * 1024, options.value("--sync-bench-dir"));
+        return true;
+    }
+    if (from.isEmpty() && to.isEmpty()) {
+        return false;
+    }
+    if (!from.isEmpty() && !to.isEmpty()) {
+        qDebug() << "DeltaSync: --sync-from 与 --sync-to 只能指定一个";
+        *exitCode = 2;
+        return true;
+    }
+
+    // 与 DataManager / MediaCache 使用相同的本地目录；对端目录下分别是 data/ 与 media/
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/data";
+    const QString mediaDir = MediaCache::defaultDirectory();
+    const QString remote = QDir(to.isEmpty() ? from : to).absolutePath();
+
+    Stats data;
+    Stats media;
+    if (!to.isEmpty()) {
+        data = sync(dataDir, remote + "/data");
+        media = sync(mediaDir, remote + "/media");
+    } else {
+        data = sync(remote + "/data", dataDir);
+        media = sync(remote + "/media", mediaDir);
+    }
+    logStats("项目数据", data);
+    logStats("媒体缓存", media);
+    *exitCode = data.filesFailed + media.filesFailed + data.errors.size() + media.errors.size() > 0 ? 1 : 0;
+    return true;
+}
+
+
+// --- 5. 基准 ---
+int DeltaSync::runBenchmark(qint64 projectBytes, const QString &workDir)
+{
+    QTemporaryDir temp;
+    QString base = workDir;
+    if (base.isEmpty()) {
+        if (!temp.isValid()) {
+            qDebug() << "DeltaSync: 无法创建临时目录";
+            return 2;
+        }
+        base = temp.path();
+    }
+    const QString source = base + "/source";
+    const QString destination = base + "/destination";
+    QDir(source).removeRecursively();
+    QDir(destination).removeRecursively();
+    QDir().mkpath(source + "/data");
+    QDir().mkpath(source + "/media");
+
+    // 项目布局：每个分镜一张图 + 一段片段，另有按分镜顺序拼成的整片 (占 40%)
+    const int shotCount = 10;
+    const int editedShot = 3;
+    const qint64 imageBytes = qMin<qint64>(2 * 1024 * 1024, projectBytes / 100);
+    const qint64 segmentBytes = projectBytes * 4 / 10 / shotCount;
+    const qint64 clipBytes = (projectBytes - segmentBytes * shotCount) / shotCount - imageBytes;
+
+    auto writeProject = [&](int revision) -> bool {
+        QJsonArray shots;
+        for (int i = 0; i < shotCount; ++i) {
+            QJsonObject shot;
+            shot["shotId"] = QString("shot_%1").arg(i);
+            shot["prompt"] = QString("cinematic scene %1%2").arg(i).arg(i == editedShot && revision > 0 ? ", rainy night" : "");
+            shot["image"] = QString("media/shot_%1.png").arg(i);
+            shot["clip"] = QString("media/shot_%1.mp4").arg(i);
+            shots.append(shot);
+        }
+        QJsonObject project;
+        project["storyId"] = "bench";
+        project["revision"] = revision;
+        project["shots"] = shots;
+        QFile json(source + "/data/project_bench.json");
+        if (!json.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        json.write(QJsonDocument(project).toJson(QJsonDocument::Indented));
+        return true;
+    };
+    // 分镜内容的种子随版本变化；被修改的分镜长度也略有不同，整片中后续分镜的偏移随之移动
+    auto seedOf = [&](int kind, int shot, int revision) -> quint64 {
+        return (quint64(kind) << 32) | (quint64(shot) << 8) | quint64(shot == editedShot ? revision : 0);
+    };
+    auto writeMedia = [&](int revision, bool onlyEditedShot) -> bool {
+        const qint64 extra = revision > 0 ? 37 * 1024 + 123 : 0;
+        for (int i = 0; i < shotCount; ++i) {
+            if (onlyEditedShot && i != editedShot) {
+                continue;
+            }
+            QFile image(source + QString("/media/shot_%1.png").arg(i));
+            QFile clip(source + QString("/media/shot_%1.mp4").arg(i));
+            if (!image.open(QIODevice::WriteOnly | QIODevice::Truncate) || !clip.open(QIODevice::WriteOnly | QIODevice::Truncate)
+                    || !writePseudoRandom(image, seedOf(1, i, revision), imageBytes)
+                    || !writePseudoRandom(clip, seedOf(2, i, revision), clipBytes + (i == editedShot ? extra : 0))) {
+                return false;
+            }
+        }
+        QFile video(source + "/media/video.mp4");
+        if (!video.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        for (int i = 0; i < shotCount; ++i) {
+            if (!writePseudoRandom(video, seedOf(3, i, revision), segmentBytes + (i == editedShot ? extra : 0))) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    qDebug().noquote() << QString("DeltaSync: 生成约 %1 MB 的基准项目于 %2").arg(toMb(projectBytes), 0, 'f', 0).arg(base);
+    if (!writeProject(0) || !writeMedia(0, false)) {
+        qDebug() << "DeltaSync: 基准数据写入失败";
+        return 2;
+    }
+
+    const Stats initial = sync(source, destination);
+    logStats("首次全量", initial);
+
+    // 修改一个分镜：新提示词、重新生成的图片和片段、整片中对应的一段
+    if (!writeProject(1) || !writeMedia(1, true)) {
+        qDebug() << "DeltaSync: 基准数据写入失败";
+        return 2;
+    }
+    const Stats edited = sync(source, destination);
+    logStats("修改一个分镜后", edited);
+
+    const Stats idle = sync(source, destination);
+    logStats("无变化", idle);
+
+    // 用重新分块的结果核对两端内容一致 (删掉清单缓存，强制重新计算)
+    QFile::remove(QDir(destination).filePath(ManifestFileName));
+    const Manifest expected = scan(source);
+    const Manifest actual = scan(destination);
+    bool identical = expected.size() == actual.size();
+    for (auto it = expected.constBegin(); identical && it != expected.constEnd(); ++it) {
+        identical = actual.contains(it.key()) && sameContent(actual.value(it.key()), it.value());
+    }
+
+    // 整文件复制时两端各有 bytesChangedFiles 的读写；按对端所在的一侧分别比较实际走网络的字节
+    auto savedPercent = [&edited](qint64 bytes) {
+        return edited.bytesChangedFiles > 0 ? 100.0 * (1.0 - double(bytes) / edited.bytesChangedFiles) : 0.0;
+    };
+    const qint64 pullBytes = edited.bytesTransferred + edited.bytesScannedSource;
+    const qint64 pushBytes = edited.bytesReused + edited.bytesScannedDestination + edited.bytesWritten;
+    qDebug().noquote() << QString("DeltaSync: 修改一个分镜后，整文件复制 %1 MB；对端为源端 (拉取) 时读取 %2 MB，少 %3%；"
+                                  "对端为目标端 (推送) 时读写 %4 MB，少 %5%；两端内容%6")
+                          .arg(toMb(edited.bytesChangedFiles), 0, 'f', 1)
+                          .arg(toMb(pullBytes), 0, 'f', 2)
+                          .arg(savedPercent(pullBytes), 0, 'f', 1)
+                          .arg(toMb(pushBytes), 0, 'f', 2)
+                          .arg(savedPercent(pushBytes), 0, 'f', 1)
+                          .arg(identical ? "一致" : "不一致");
+
+    const bool ok = identical && initial.filesFailed == 0 && edited.filesFailed == 0
+            && idle.bytesTransferred == 0 && idle.bytesWritten == 0;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#ifndef DELTASYNC_H
+#define DELTASYNC_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// 块级增量同步 (rsync 思路)：把项目数据与媒体缓存从一个目录同步到另一个目录，只传输变化的块。
+// - 内容定义分块 (FastCDC 式 gear 滚动哈希)：块边界由内容决定，文件中间插入/删除数据只影响附近一两个块
+// - 每个块用 SHA-256 标识；目标端已有的块 (任意文件中) 直接本地复制，其余才从源端读取
+// - 已有文件原地修补：同一偏移内容不变的块不重写，只写变化的块；文件内的块前后交错移动时才经临时文件整体重建
+// - 每个目录的分块清单缓存在 .stv-sync-manifest.json，大小与修改时间不变的文件不再重新分块
+// 任一端都可以是挂载的另一台机器的共享目录。走网络的字节：推送 (--sync-to) 时是目标端的读、写与扫描，
+// 拉取 (--sync-from) 时是源端的读取与扫描，Stats 分别统计；对端清单缓存失效 (被其他程序改动) 时扫描会整文件读取。
+//
+// 用法：
+//   ./StoryToVideoGenerator --sync-to=/mnt/workstation/stv     推送本机项目与缓存
+//   ./StoryToVideoGenerator --sync-from=/mnt/workstation/stv   拉取
+//   ./StoryToVideoGenerator --sync-bench[=MB]                  两个临时目录上的基准 (默认 1024 MB)
+class DeltaSync
+{
+public:
+    struct Chunk {
+        qint64 offset;
+        qint64 length;
+        QByteArray sha256;
+    };
+
+    struct FileManifest {
+        qint64 size = 0;
+        qint64 modified = 0;       // ms since epoch
+        QVector<Chunk> chunks;
+    };
+
+    // 相对路径 -> 分块清单
+    typedef QMap<QString, FileManifest> Manifest;
+
+    struct Stats {
+        int filesScanned = 0;
+        int filesUpdated = 0;
+        int filesUnchanged = 0;
+        int filesFailed = 0;
+        int filesPatched = 0;          // 其中原地修补的文件 (其余经临时文件整体重建)
+        qint64 bytesTotal = 0;         // 源端文件总大小
+        qint64 bytesTransferred = 0;   // 从源端读取的块
+        qint64 bytesReused = 0;        // 从目标端读回复用的块
+        qint64 bytesWritten = 0;       // 写入目标端的字节
+        qint64 bytesScannedSource = 0;       // 扫描时重新分块读取的源端字节
+        qint64 bytesScannedDestination = 0;  // 扫描时重新分块读取的目标端字节
+        qint64 bytesChangedFiles = 0;  // 需要更新的文件总大小 (整文件复制时的传输量)
+        qint64 elapsedMs = 0;
+        QStringList errors;
+    };
+
+    // 块大小：最小 / 目标平均 / 最大
+    static const int MinChunkBytes = 16 * 1024;
+    static const int AvgChunkBytes = 64 * 1024;
+    static const int MaxChunkBytes = 256 * 1024;
+
+    // 对单个文件做内容定义分块
+    static QVector<Chunk> chunkFile(const QString &path, bool *ok = nullptr);
+
+    // 扫描目录得到清单；未变化的文件沿用缓存，并写回 .stv-sync-manifest.json。bytesRead 累加重新分块读取的字节
+    static Manifest scan(const QString &root, qint64 *bytesRead = nullptr);
+
+    // 单向同步 source -> destination；目标端多出的文件保留不删
+    static Stats sync(const QString &sourceRoot, const QString &destinationRoot);
+
+    // 处理 --sync-from / --sync-to / --sync-bench；返回 false 表示不是同步命令
+    static bool runFromArguments(const QStringList &arguments, int *exitCode);
+
+    // 生成约 projectBytes 的项目，全量同步一次，再修改一个分镜后增量同步，打印两端的读写字节数
+    static int runBenchmark(qint64 projectBytes, const QString &workDir = QString());
+
+private:
+    static Manifest loadManifestCache(const QString &root);
+    static void saveManifestCache(const QString &root, const Manifest &manifest);
+    static void logStats(const QString &title, const Stats &stats);
+};
+
+#endif // DELTASYNC_H
@@ -26,6 +26,10 @@ NCPU=$(sysctl -n hw.ncpu)
 make clean
 make -j$NCPU
 
+# Step 3b: Build the media helper process (installed next to the app executable)
+echo "Step 3b: Building stv-mediaworker..."
+(cd mediaworker && /opt/homebrew/bin/qmake mediaworker.pro && make clean && make -j$NCPU)
+
 # Step 4: Run macdeployqt
 echo "Step 4: Bundling frameworks with macdeployqt..."
 /opt/homebrew/bin/macdeployqt "${APP_BUNDLE}/Contents/MacOS/.." -always-overwrite
@@ -0,0 +1,245 @@
+#include "etamodel.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QDebug>
+#include <cmath>
+
+// 单个样本的合理范围，超出的多半是跨睡眠/断网的异常值
+static const double MinSampleSeconds = 0.1;
+static const double MaxSampleSeconds = 6 * 3600;
+// 轮询间隔上下限 (ms)
+static const qint64 MinPollGapMs = 1000;
+static const qint64 MaxPollGapMs = 10000;
+
+EtaModel::EtaModel(QObject *parent)
+    : QObject(parent)
+{
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(2000);
+    connect(m_saveTimer, &QTimer::timeout, this, &EtaModel::save);
+
+    load();
+}
+
+EtaModel::~EtaModel()
+{
+    if (m_saveTimer->isActive()) {
+        save();
+    }
+}
+
+
+// --- 1. 估计 ---
+QString EtaModel::shotBucket(int shotCount)
+{
+    if (shotCount <= 0) return "?";
+    if (shotCount == 1) return "1";
+    if (shotCount <= 3) return "2-3";
+    if (shotCount <= 6) return "4-6";
+    if (shotCount <= 10) return "7-10";
+    return "11+";
+}
+
+QString EtaModel::keyOf(const Features &features)
+{
+    return QString("%1|%2|%3|%4").arg(features.type, shotBucket(features.shotCount),
+                                       features.style, features.resolution);
+}
+
+double EtaModel::defaultSeconds(const QString &type)
+{
+    // 没有任何历史时的保守初值
+    if (type == "video") return 60;
+    if (type == "text_task") return 20;
+    return 15;
+}
+
+double EtaModel::expectedSeconds(const Features &features) const
+{
+    const Stats exact = m_stats.value(keyOf(features));
+    if (exact.samples > 0) {
+        return exact.mean;
+    }
+    const Stats byType = m_stats.value("type:" + features.type);
+    if (byType.samples > 0) {
+        return byType.mean;
+    }
+    return defaultSeconds(features.type);
+}
+
+void EtaModel::update(Stats &stats, double seconds)
+{
+    if (stats.samples == 0) {
+        stats.mean = seconds;
+        stats.variance = 0;
+    } else {
+        // 指数滑动平均及其方差的增量更新
+        const double diff = seconds - stats.mean;
+        stats.mean += SmoothingFactor * diff;
+        stats.variance = (1 - SmoothingFactor) * (stats.variance + SmoothingFactor * diff * diff);
+    }
+    ++stats.samples;
+}
+
+
+// --- 2. 进行中的任务 ---
+void EtaModel::begin(const QString &taskId, const Features &features)
+{
+    const QString key = keyOf(features);
+    Active active;
+    active.key = key;
+    active.type = features.type;
+    active.startedAt = QDateTime::currentMSecsSinceEpoch();
+    active.expected = qMax(1.0, expectedSeconds(features));
+    active.confident = m_stats.value(key).samples >= MinSamplesForScheduling
+            || m_stats.value("type:" + features.type).samples >= MinSamplesForScheduling;
+    active.serverProgress = 0;
+    active.shown = 0;
+    active.nextPollAt = active.startedAt;
+    m_active.insert(taskId, active);
+}
+
+double EtaModel::elapsedSeconds(const Active &active) const
+{
+    return qMax<qint64>(0, QDateTime::currentMSecsSinceEpoch() - active.startedAt) / 1000.0;
+}
+
+int EtaModel::progress(const QString &taskId, int serverProgress)
+{
+    auto it = m_active.find(taskId);
+    if (it == m_active.end()) {
+        return qBound(0, serverProgress, 100);
+    }
+    if (serverProgress >= 0) {
+        it->serverProgress = qMax(it->serverProgress, qMin(serverProgress, 100));
+    }
+
+    // 按时间插值：预计耗时内线性走到 95%，超时后渐近 99%
+    const double t = elapsedSeconds(*it);
+    const double e = it->expected;
+    const double byTime = t <= e ? 95.0 * t / e : 95.0 + 4.0 * (1.0 - std::exp(-(t - e) / e));
+
+    const int value = qBound(0, int(qMax<double>(it->serverProgress, byTime)), 99);
+    it->shown = qMax(it->shown, value);
+    return it->shown;
+}
+
+int EtaModel::remainingSeconds(const QString &taskId) const
+{
+    auto it = m_active.constFind(taskId);
+    if (it == m_active.constEnd()) {
+        return -1;
+    }
+    const double t = elapsedSeconds(*it);
+    double remaining = it->expected - t;
+    if (remaining <= 0) {
+        // 已超出历史耗时：给一个随超时增长的短估计，而不是显示 0
+        remaining = qMax(1.0, 0.1 * t);
+    }
+
+    // 服务端进度越高越相信按进度外推的速率
+    const int p = it->serverProgress;
+    if (p >= 10 && p < 100 && t > 0) {
+        const double byRate = t * (100 - p) / p;
+        const double w = p / 100.0;
+        remaining = w * byRate + (1 - w) * remaining;
+    }
+    return int(std::ceil(remaining));
+}
+
+bool EtaModel::shouldPoll(const QString &taskId, qint64 nowMs)
+{
+    auto it = m_active.find(taskId);
+    if (it == m_active.end() || !it->confident) {
+        return true;
+    }
+    if (nowMs < it->nextPollAt) {
+        return false;
+    }
+
+    // 以 "均值 - 2 倍标准差" 作为最早可能完成的时间，此前按剩余时间的 1/3 拉长间隔
+    const Stats stats = m_stats.value(it->key).samples >= MinSamplesForScheduling
+            ? m_stats.value(it->key) : m_stats.value("type:" + it->type);
+    const double earliest = stats.mean - 2 * std::sqrt(stats.variance);
+    const double untilEarliest = earliest - elapsedSeconds(*it);
+    const qint64 gap = untilEarliest > 0 ? qint64(untilEarliest * 1000 / 3) : 0;
+    it->nextPollAt = nowMs + qBound(MinPollGapMs, gap, MaxPollGapMs);
+    if (gap <= 0) {
+        it->nextPollAt = nowMs; // 接近或超过预计完成时间：每轮都查
+    }
+    return true;
+}
+
+void EtaModel::finish(const QString &taskId, bool succeeded)
+{
+    const Active active = m_active.take(taskId);
+    if (!succeeded || active.key.isEmpty()) {
+        return;
+    }
+    const double seconds = elapsedSeconds(active);
+    if (seconds < MinSampleSeconds || seconds > MaxSampleSeconds) {
+        return;
+    }
+    update(m_stats[active.key], seconds);
+    update(m_stats["type:" + active.type], seconds);
+    qDebug() << "EtaModel:" << active.key << "耗时" << seconds << "s，新估计" << m_stats[active.key].mean << "s";
+    m_saveTimer->start();
+}
+
+
+// --- 3. 持久化 ---
+QString EtaModel::storePath() const
+{
+    const QString dirPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/data/";
+    QDir dir(dirPath);
+    if (!dir.exists()) {
+        dir.mkpath(dirPath);
+    }
+    return dirPath + "eta_history.json";
+}
+
+void EtaModel::load()
+{
+    QFile file(storePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QJsonObject stats = QJsonDocument::fromJson(file.readAll()).object()["stats"].toObject();
+    for (auto it = stats.constBegin(); it != stats.constEnd(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        Stats entry;
+        entry.mean = obj["mean"].toDouble();
+        entry.variance = obj["variance"].toDouble();
+        entry.samples = obj["samples"].toInt();
+        if (entry.samples > 0 && entry.mean > 0) {
+            m_stats.insert(it.key(), entry);
+        }
+    }
+    qDebug() << "EtaModel: 载入" << m_stats.size() << "组耗时历史";
+}
+
+void EtaModel::save()
+{
+    QJsonObject stats;
+    for (auto it = m_stats.constBegin(); it != m_stats.constEnd(); ++it) {
+        QJsonObject obj;
+        obj["mean"] = it->mean;
+        obj["variance"] = it->variance;
+        obj["samples"] = it->samples;
+        stats.insert(it.key(), obj);
+    }
+    QJsonObject root;
+    root["version"] = 1;
+    root["stats"] = stats;
+
+    QFile file(storePath());
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef ETAMODEL_H
+#define ETAMODEL_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+
+class QTimer;
+
+// 任务耗时历史模型：按 任务类型 + 特征 (分镜数区间、风格、分辨率) 记录实际耗时，
+// 用指数滑动平均估计新任务的耗时，据此给出平滑进度、剩余时间和下次轮询的时机。
+// 历史保存在 AppDataLocation/data/eta_history.json，跨会话累积。
+class EtaModel : public QObject
+{
+    Q_OBJECT
+public:
+    struct Features {
+        QString type;        // text_task / shot / video
+        int shotCount = 0;   // 0 表示未知
+        QString style;
+        QString resolution;
+    };
+
+    explicit EtaModel(QObject *parent = nullptr);
+    ~EtaModel();
+
+    // 滑动平均权重：新样本占 30%
+    static constexpr double SmoothingFactor = 0.3;
+    // 同一特征至少有这么多历史样本才用来推迟轮询
+    static const int MinSamplesForScheduling = 3;
+
+    // 预计总耗时 (秒)：精确特征 -> 同类型汇总 -> 内置默认值
+    double expectedSeconds(const Features &features) const;
+
+    // --- 进行中的任务 ---
+    void begin(const QString &taskId, const Features &features);
+    // 根据服务端进度与已用时间给出单调递增的平滑进度 (0..99，完成前不到 100)
+    int progress(const QString &taskId, int serverProgress);
+    // 预计剩余秒数，未跟踪的任务返回 -1
+    int remainingSeconds(const QString &taskId) const;
+    // 本轮是否值得轮询：离预计完成还早时拉长间隔，接近或超时后每轮都查
+    bool shouldPoll(const QString &taskId, qint64 nowMs);
+    // 任务结束；成功时把实际耗时计入历史
+    void finish(const QString &taskId, bool succeeded);
+    bool isTracking(const QString &taskId) const { return m_active.contains(taskId); }
+
+private slots:
+    void save();
+
+private:
+    struct Stats {
+        double mean = 0;       // 秒
+        double variance = 0;
+        int samples = 0;
+    };
+
+    struct Active {
+        QString key;
+        QString type;
+        qint64 startedAt;      // ms
+        double expected;       // 开始时的预计耗时 (秒)
+        bool confident;        // 历史样本足够
+        int serverProgress;
+        int shown;             // 已显示的平滑进度
+        qint64 nextPollAt;     // ms
+    };
+
+    static QString keyOf(const Features &features);
+    static QString shotBucket(int shotCount);
+    static double defaultSeconds(const QString &type);
+    static void update(Stats &stats, double seconds);
+    double elapsedSeconds(const Active &active) const;
+    void load();
+    QString storePath() const;
+
+    QHash<QString, Stats> m_stats;      // 特征 key 与类型汇总 ("type:<type>") -> 统计
+    QHash<QString, Active> m_active;    // taskId -> 进行中的任务
+    QTimer *m_saveTimer;
+};
+
+#endif // ETAMODEL_H
@@ -0,0 +1,361 @@
+#include "exportmanager.h"
+#include "mediacache.h"
+#include "taskexecutor.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QUrl>
+#include <QDebug>
+#include <functional>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+#ifdef Q_OS_MACOS
+#include <sys/clonefile.h>
+#endif
+
+namespace {
+
+struct CopyResult {
+    bool ok;
+    QString method;   // reflink / clonefile / hardlink / copy_file_range / stream
+    QString error;
+};
+
+typedef std::function<void(int)> ProgressFn;
+
+const qint64 CopyChunkBytes = 8 * 1024 * 1024;
+
+CopyResult streamCopy(const QString &source, const QString &destination, qint64 total,
+                      const CancellationToken &token, const ProgressFn &progress)
+{
+    QFile in(source);
+    QFile out(destination);
+    if (!in.open(QIODevice::ReadOnly)) {
+        return {false, QString(), "无法读取缓存文件: " + source};
+    }
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return {false, QString(), "无法写入文件: " + destination};
+    }
+
+    qint64 copied = 0;
+    while (!in.atEnd()) {
+        if (token.isCancelled()) {
+            out.remove();
+            return {false, QString(), "导出已取消"};
+        }
+        const QByteArray block = in.read(CopyChunkBytes);
+        if (block.isEmpty() || out.write(block) != block.size()) {
+            out.remove();
+            return {false, QString(), "写入失败: " + out.errorString()};
+        }
+        copied += block.size();
+        if (total > 0) {
+            progress(int(copied * 100 / total));
+        }
+    }
+    return {true, "stream", QString()};
+}
+
+#ifndef Q_OS_WIN
+// 内核态复制：不经过用户态缓冲；btrfs/XFS 等文件系统上会自动退化为共享数据块
+bool kernelCopy(const QString &source, const QString &destination, qint64 total,
+                const CancellationToken &token, const ProgressFn &progress, bool *unsupported)
+{
+    *unsupported = false;
+#ifdef Q_OS_LINUX
+    const int in = ::open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+    const int out = ::open(QFile::encodeName(destination).constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    qint64 copied = 0;
+    bool ok = true;
+    while (copied < total) {
+        if (token.isCancelled()) {
+            ok = false;
+            break;
+        }
+        const ssize_t n = ::copy_file_range(in, nullptr, out, nullptr, size_t(qMin(CopyChunkBytes, total - copied)), 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // 内核/文件系统不支持 (ENOSYS/EXDEV/EINVAL...)：交给普通复制
+            *unsupported = copied == 0;
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        copied += n;
+        progress(int(copied * 100 / total));
+    }
+    ::close(in);
+    ::close(out);
+    if (!ok || copied != total) {
+        ::unlink(QFile::encodeName(destination).constData());
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(destination);
+    Q_UNUSED(total);
+    Q_UNUSED(token);
+    Q_UNUSED(progress);
+    *unsupported = true;
+    return false;
+#endif
+}
+#endif
+
+bool cloneFile(const QString &source, const QString &destination)
+{
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+    const int in = ::open(QFile::encodeName(source).constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        return false;
+    }
+    const int out = ::open(QFile::encodeName(destination).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+    const bool ok = ::ioctl(out, FICLONE, in) == 0;
+    ::close(in);
+    ::close(out);
+    if (!ok) {
+        ::unlink(QFile::encodeName(destination).constData());
+    }
+    return ok;
+#elif defined(Q_OS_MACOS)
+    return ::clonefile(QFile::encodeName(source).constData(), QFile::encodeName(destination).constData(), 0) == 0;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(destination);
+    return false;
+#endif
+}
+
+bool hardLink(const QString &source, const QString &destination)
+{
+#ifdef Q_OS_WIN
+    return CreateHardLinkW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(destination).utf16()),
+                           reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(source).utf16()),
+                           nullptr);
+#else
+    return ::link(QFile::encodeName(source).constData(), QFile::encodeName(destination).constData()) == 0;
+#endif
+}
+
+// 依次尝试：写时复制克隆 -> 硬链接 -> copy_file_range -> 分块读写
+// 前两种只在同一文件系统上成功，与文件大小无关，耗时为毫秒级。
+// 硬链接与缓存共享 inode：缓存淘汰只删除自己的目录项，导出文件不受影响。
+CopyResult exportFile(const QString &source, const QString &destination,
+                      const CancellationToken &token, const ProgressFn &progress)
+{
+    const qint64 total = QFileInfo(source).size();
+
+    if (cloneFile(source, destination)) {
+        return {true, "reflink", QString()};
+    }
+    if (hardLink(source, destination)) {
+        return {true, "hardlink", QString()};
+    }
+#ifndef Q_OS_WIN
+    bool unsupported = false;
+    if (kernelCopy(source, destination, total, token, progress, &unsupported)) {
+        return {true, "copy_file_range", QString()};
+    }
+    if (!unsupported) {
+        return {false, QString(), token.isCancelled() ? QString("导出已取消") : "复制失败: " + destination};
+    }
+#endif
+    return streamCopy(source, destination, total, token, progress);
+}
+
+} // namespace
+
+
+ExportManager::ExportManager(MediaCache *cache, QObject *parent)
+    : QObject(parent), m_cache(cache)
+{
+    // 未缓存的来源：等待 MediaCache 下载完成后再复制 (下载占 0-90%)
+    connect(m_cache, &MediaCache::downloadProgress,
+            this, [this](const QString &url, qint64 received, qint64 total) {
+        if (url == m_current.source && total > 0) {
+            emit exportProgress(m_current.id, int(received * 90 / total));
+        }
+    });
+    connect(m_cache, &MediaCache::cached, this, [this](const QString &url, const QString &localPath) {
+        if (url == m_current.source) {
+            m_current.downloaded = true;
+            copyFromCache(localPath);
+        }
+    });
+    connect(m_cache, &MediaCache::downloadFailed, this, [this](const QString &url, const QString &errorMsg) {
+        if (url == m_current.source) {
+            finishCurrent(false, "下载失败: " + errorMsg);
+        }
+    });
+}
+
+
+// --- 1. 队列 ---
+QString ExportManager::enqueue(const QString &exportId, const QString &source, const QString &destinationDir)
+{
+    QString dir = destinationDir;
+    if (dir.isEmpty()) {
+        dir = QStandardPaths::writableLocation(QStandardPaths::DownloadLocation);
+    }
+    QDir().mkpath(dir);
+
+    const QUrl url(source);
+    QString suffix = QFileInfo(url.isLocalFile() ? url.toLocalFile() : url.path()).suffix();
+    if (suffix.isEmpty()) {
+        suffix = "mp4";
+    }
+
+    Request request;
+    request.id = exportId;
+    request.source = source;
+    request.destination = uniqueDestination(dir, exportId, suffix);
+    m_queue.append(request);
+
+    qDebug() << "ExportManager: 加入导出队列" << exportId << "->" << request.destination << "排队数:" << queuedCount();
+    startNext();
+    return request.destination;
+}
+
+bool ExportManager::isQueued(const QString &exportId) const
+{
+    if (m_current.id == exportId) {
+        return true;
+    }
+    for (const Request &request : m_queue) {
+        if (request.id == exportId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString ExportManager::uniqueDestination(const QString &dir, const QString &baseName, const QString &suffix) const
+{
+    auto taken = [this](const QString &path) {
+        if (QFile::exists(path) || m_current.destination == path) {
+            return true;
+        }
+        for (const Request &request : m_queue) {
+            if (request.destination == path) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    QString path = QDir(dir).filePath(baseName + "." + suffix);
+    for (int i = 1; taken(path); ++i) {
+        path = QDir(dir).filePath(QString("%1 (%2).%3").arg(baseName).arg(i).arg(suffix));
+    }
+    return path;
+}
+
+void ExportManager::startNext()
+{
+    if (!m_current.id.isEmpty() || m_queue.isEmpty()) {
+        return;
+    }
+    m_current = m_queue.takeFirst();
+    emit exportProgress(m_current.id, 0);
+
+    const QUrl url(m_current.source);
+    if (url.isLocalFile() || url.scheme().isEmpty()) {
+        copyFromCache(url.isLocalFile() ? url.toLocalFile() : m_current.source);
+        return;
+    }
+
+    const QString localPath = m_cache->localPath(m_current.source);
+    if (!localPath.isEmpty()) {
+        copyFromCache(localPath);
+        return;
+    }
+
+    // 预览页通常已经在预取；这里只是确保下载存在，不会发起第二个请求
+    qDebug() << "ExportManager: 缓存未命中，等待下载" << m_current.source;
+    m_cache->prefetch(m_current.source);
+    if (!m_current.id.isEmpty() && !m_cache->isDownloading(m_current.source) && !m_cache->isCached(m_current.source)) {
+        finishCurrent(false, "无法下载视频: " + m_current.source);
+    }
+}
+
+
+// --- 2. 复制 ---
+void ExportManager::copyFromCache(const QString &localPath)
+{
+    if (!QFile::exists(localPath)) {
+        finishCurrent(false, "源文件不存在: " + localPath);
+        return;
+    }
+
+    const QString id = m_current.id;
+    const QString destination = m_current.destination;
+    const int base = m_current.downloaded ? 90 : 0;
+
+    // 复制在后台线程执行；进度经事件循环回到本线程
+    TaskExecutor::instance()->run(this,
+        [this, id, localPath, destination, base](const CancellationToken &token) {
+            QElapsedTimer timer;
+            timer.start();
+            int lastPercent = -1;
+            CopyResult result = exportFile(localPath, destination, token, [&](int percent) {
+                const int overall = base + percent * (100 - base) / 100;
+                if (overall != lastPercent) {
+                    lastPercent = overall;
+                    QMetaObject::invokeMethod(this, [this, id, overall]() {
+                        emit exportProgress(id, overall);
+                    }, Qt::QueuedConnection);
+                }
+            });
+            if (result.ok) {
+                qDebug() << "ExportManager:" << result.method << "完成，耗时" << timer.elapsed() << "ms";
+            }
+            return result;
+        },
+        [this](const CopyResult &result) {
+            finishCurrent(result.ok, result.ok ? result.method : result.error);
+        });
+}
+
+void ExportManager::finishCurrent(bool ok, const QString &methodOrError)
+{
+    const Request request = m_current;
+    m_current = Request();
+
+    if (ok) {
+        emit exportProgress(request.id, 100);
+        emit exportFinished(request.id, request.destination, methodOrError);
+    } else {
+        qDebug() << "ExportManager: 导出失败" << request.id << methodOrError;
+        emit exportFailed(request.id, methodOrError);
+    }
+    startNext();
+}
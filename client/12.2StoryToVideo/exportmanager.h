@@ -0,0 +1,49 @@
+#ifndef EXPORTMANAGER_H
+#define EXPORTMANAGER_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+
+class MediaCache;
+
+// 视频导出队列：优先从本地媒体缓存取文件，不重复下载。
+// 同一文件系统上依次尝试 reflink (写时复制克隆) / 硬链接，几乎瞬间完成；
+// 否则用 copy_file_range 在内核中复制，最后才退回到普通的分块读写。
+// 导出按提交顺序逐个执行，复制在 TaskExecutor 后台线程完成。
+class ExportManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ExportManager(MediaCache *cache, QObject *parent = nullptr);
+
+    // 返回导出目标路径 (默认 ~/Downloads/<exportId>.<ext>，重名时追加序号)
+    QString enqueue(const QString &exportId, const QString &source, const QString &destinationDir = QString());
+
+    bool isQueued(const QString &exportId) const;
+    int queuedCount() const { return m_queue.size() + (m_current.id.isEmpty() ? 0 : 1); }
+
+signals:
+    void exportProgress(const QString &exportId, int percent);
+    void exportFinished(const QString &exportId, const QString &filePath, const QString &method);
+    void exportFailed(const QString &exportId, const QString &errorMsg);
+
+private:
+    struct Request {
+        QString id;
+        QString source;          // file:// / 本地路径 / http(s) URL
+        QString destination;
+        bool downloaded = false; // 是否经过了下载 (决定复制阶段的进度区间)
+    };
+
+    void startNext();
+    void copyFromCache(const QString &localPath);
+    void finishCurrent(bool ok, const QString &methodOrError);
+    QString uniqueDestination(const QString &dir, const QString &baseName, const QString &suffix) const;
+
+    MediaCache *m_cache;
+    QList<Request> m_queue;
+    Request m_current;
+};
+
+#endif // EXPORTMANAGER_H
@@ -0,0 +1,125 @@
+#include "imagehash.h"
+#include "imagescaler.h"
+#include <QString>
+#include <algorithm>
+
+// --- 1. dHash ---
+quint64 ImageHash::dHash(const QImage &image)
+{
+    if (image.isNull()) {
+        return 0;
+    }
+
+    // 大图先用 Area 滤波缩小到 9x8 (向量化路径)，再转灰度
+    QImage source = image;
+    if (source.format() != QImage::Format_RGB32 &&
+        source.format() != QImage::Format_ARGB32_Premultiplied &&
+        source.format() != QImage::Format_ARGB32) {
+        source = source.convertToFormat(QImage::Format_RGB32);
+    }
+    const QImage small = ImageScaler::downscale(source, QSize(9, 8), ImageScaler::Area);
+
+    quint64 hash = 0;
+    int bit = 0;
+    for (int y = 0; y < 8; ++y) {
+        const QRgb *row = reinterpret_cast<const QRgb *>(small.constScanLine(y));
+        int previous = qGray(row[0]);
+        for (int x = 1; x < 9; ++x) {
+            const int current = qGray(row[x]);
+            if (current > previous) {
+                hash |= (quint64(1) << bit);
+            }
+            previous = current;
+            ++bit;
+        }
+    }
+    return hash;
+}
+
+QString ImageHash::toHex(quint64 hash)
+{
+    return QString("%1").arg(hash, 16, 16, QChar('0'));
+}
+
+quint64 ImageHash::fromHex(const QString &hex, bool *ok)
+{
+    return hex.toULongLong(ok, 16);
+}
+
+
+// --- 2. BK-tree ---
+void BkTree::clear()
+{
+    m_nodes.clear();
+}
+
+void BkTree::insert(quint64 hash, int value)
+{
+    Node node;
+    node.hash = hash;
+    node.value = value;
+
+    if (m_nodes.isEmpty()) {
+        m_nodes.append(node);
+        return;
+    }
+
+    int current = 0;
+    forever {
+        const int d = ImageHash::distance(hash, m_nodes[current].hash);
+        int next = -1;
+        for (const QPair<int, int> &child : m_nodes[current].children) {
+            if (child.first == d) {
+                next = child.second;
+                break;
+            }
+        }
+        if (next < 0) {
+            m_nodes.append(node);
+            m_nodes[current].children.append(qMakePair(d, m_nodes.size() - 1));
+            return;
+        }
+        current = next;
+    }
+}
+
+QVector<QPair<int, int>> BkTree::query(quint64 hash, int maxDistance) const
+{
+    QVector<QPair<int, int>> matches;
+    if (m_nodes.isEmpty()) {
+        return matches;
+    }
+
+    QVector<int> stack;
+    stack.append(0);
+    while (!stack.isEmpty()) {
+        const Node &node = m_nodes[stack.takeLast()];
+        const int d = ImageHash::distance(hash, node.hash);
+        if (d <= maxDistance) {
+            matches.append(qMakePair(node.value, d));
+        }
+        // 三角不等式：只有边距离落在 [d - r, d + r] 内的子树可能命中
+        for (const QPair<int, int> &child : node.children) {
+            if (child.first >= d - maxDistance && child.first <= d + maxDistance) {
+                stack.append(child.second);
+            }
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const QPair<int, int> &a, const QPair<int, int> &b) {
+        return a.second < b.second;
+    });
+    return matches;
+}
+
+int BkTree::nearest(quint64 hash, int maxDistance, int *outDistance) const
+{
+    const QVector<QPair<int, int>> matches = query(hash, maxDistance);
+    if (matches.isEmpty()) {
+        return -1;
+    }
+    if (outDistance) {
+        *outDistance = matches.first().second;
+    }
+    return matches.first().first;
+}
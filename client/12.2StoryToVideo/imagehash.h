@@ -0,0 +1,53 @@
+#ifndef IMAGEHASH_H
+#define IMAGEHASH_H
+
+#include <QImage>
+#include <QVector>
+#include <QPair>
+#include <QtGlobal>
+
+// 感知哈希 (dHash, 64 位)：缩小到 9x8 灰度后比较相邻像素亮度
+// 重新生成的同一分镜图片通常汉明距离 <= 6，而不同画面一般 > 20
+namespace ImageHash
+{
+    quint64 dHash(const QImage &image);
+
+    inline int distance(quint64 a, quint64 b)
+    {
+        return qPopulationCount(a ^ b);
+    }
+
+    QString toHex(quint64 hash);
+    quint64 fromHex(const QString &hex, bool *ok = nullptr);
+}
+
+// BK-tree：按汉明距离组织哈希，半径查询只访问满足三角不等式的子树
+// 数万条记录、半径 6 的查询通常只触达几百个节点 (亚毫秒级)
+class BkTree
+{
+public:
+    BkTree() {}
+
+    void clear();
+    int size() const { return m_nodes.size(); }
+
+    // value 为调用方自定义的记录下标
+    void insert(quint64 hash, int value);
+
+    // 返回 (value, distance) 列表，按距离升序
+    QVector<QPair<int, int>> query(quint64 hash, int maxDistance) const;
+
+    // 最近的一条记录；未找到返回 -1
+    int nearest(quint64 hash, int maxDistance, int *outDistance = nullptr) const;
+
+private:
+    struct Node {
+        quint64 hash;
+        int value;
+        QVector<QPair<int, int>> children; // (距离, 子节点下标)
+    };
+
+    QVector<Node> m_nodes;
+};
+
+#endif // IMAGEHASH_H
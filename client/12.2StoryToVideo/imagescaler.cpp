@@ -0,0 +1,550 @@
+#include "imagescaler.h"
+#include "commandline.h"
+#include "taskexecutor.h"
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QThread>
+#include <QVector>
+#include <QtGlobal>
+#include <QDebug>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define IMAGESCALER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace {
+
+// 一个输出坐标由 [start, start + weights.size()) 区间的源坐标加权得到
+struct Contribution {
+    int start;
+    QVector<float> weights;
+};
+
+// --- 1. 权重表 ---
+QVector<Contribution> areaContributions(int srcLength, int dstLength)
+{
+    QVector<Contribution> table(dstLength);
+    const double scale = double(srcLength) / dstLength;
+
+    for (int i = 0; i < dstLength; ++i) {
+        const double begin = i * scale;
+        const double end = qMin(double(srcLength), begin + scale);
+        const int first = int(std::floor(begin));
+        const int last = qMin(srcLength - 1, int(std::ceil(end)) - 1);
+
+        Contribution &c = table[i];
+        c.start = first;
+        c.weights.resize(last - first + 1);
+        for (int s = first; s <= last; ++s) {
+            // 源像素 [s, s+1) 与目标区间 [begin, end) 的重叠长度
+            const double overlap = qMin(end, double(s + 1)) - qMax(begin, double(s));
+            c.weights[s - first] = float(overlap / scale);
+        }
+    }
+    return table;
+}
+
+QVector<Contribution> bilinearContributions(int srcLength, int dstLength)
+{
+    QVector<Contribution> table(dstLength);
+    const double scale = double(srcLength) / dstLength;
+
+    for (int i = 0; i < dstLength; ++i) {
+        // 像素中心对齐，与 QImage 的 FastTransformation 采样位置一致
+        double center = (i + 0.5) * scale - 0.5;
+        center = qBound(0.0, center, double(srcLength - 1));
+        const int first = int(std::floor(center));
+        const float frac = float(center - first);
+
+        Contribution &c = table[i];
+        c.start = first;
+        if (first + 1 < srcLength && frac > 0.0f) {
+            c.weights << (1.0f - frac) << frac;
+        } else {
+            c.weights << 1.0f;
+        }
+    }
+    return table;
+}
+
+
+// --- 2. 纵向累加：acc[i] += weight * row[i] ---
+void accumulateRowScalar(float *acc, const uchar *row, int count, float weight)
+{
+    for (int i = 0; i < count; ++i) {
+        acc[i] += weight * row[i];
+    }
+}
+
+#ifdef IMAGESCALER_X86
+void accumulateRowSse2(float *acc, const uchar *row, int count, float weight)
+{
+    const __m128 w = _mm_set1_ps(weight);
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        const __m128i lo16 = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i hi16 = _mm_unpackhi_epi8(bytes, zero);
+
+        const __m128 f0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo16, zero));
+        const __m128 f1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo16, zero));
+        const __m128 f2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi16, zero));
+        const __m128 f3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi16, zero));
+
+        _mm_storeu_ps(acc + i,      _mm_add_ps(_mm_loadu_ps(acc + i),      _mm_mul_ps(f0, w)));
+        _mm_storeu_ps(acc + i + 4,  _mm_add_ps(_mm_loadu_ps(acc + i + 4),  _mm_mul_ps(f1, w)));
+        _mm_storeu_ps(acc + i + 8,  _mm_add_ps(_mm_loadu_ps(acc + i + 8),  _mm_mul_ps(f2, w)));
+        _mm_storeu_ps(acc + i + 12, _mm_add_ps(_mm_loadu_ps(acc + i + 12), _mm_mul_ps(f3, w)));
+    }
+    accumulateRowScalar(acc + i, row + i, count - i, weight);
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+void accumulateRowAvx2(float *acc, const uchar *row, int count, float weight)
+{
+    const __m256 w = _mm256_set1_ps(weight);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        const __m256 f0 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        const __m256 f1 = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+
+        _mm256_storeu_ps(acc + i,     _mm256_add_ps(_mm256_loadu_ps(acc + i),     _mm256_mul_ps(f0, w)));
+        _mm256_storeu_ps(acc + i + 8, _mm256_add_ps(_mm256_loadu_ps(acc + i + 8), _mm256_mul_ps(f1, w)));
+    }
+    accumulateRowScalar(acc + i, row + i, count - i, weight);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+typedef void (*AccumulateFn)(float *, const uchar *, int, float);
+
+AccumulateFn selectAccumulate()
+{
+#ifdef IMAGESCALER_X86
+    static const AccumulateFn fn = cpuHasAvx2() ? accumulateRowAvx2 : accumulateRowSse2;
+    return fn;
+#else
+    return accumulateRowScalar;
+#endif
+}
+
+
+// --- 3. 横向滤波：把一行累加结果按列权重收敛成输出像素 ---
+inline uchar clampToByte(float v)
+{
+    const int rounded = int(v + 0.5f);
+    return uchar(rounded < 0 ? 0 : (rounded > 255 ? 255 : rounded));
+}
+
+void horizontalPass4(const float *acc, uchar *out, const QVector<Contribution> &columns)
+{
+    const int dstWidth = columns.size();
+    for (int x = 0; x < dstWidth; ++x) {
+        const Contribution &c = columns[x];
+        const float *src = acc + c.start * 4;
+        const int taps = c.weights.size();
+#ifdef IMAGESCALER_X86
+        // 32 位像素的 4 个通道正好是一个 __m128
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < taps; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + k * 4), _mm_set1_ps(c.weights[k])));
+        }
+        const __m128i i32 = _mm_cvtps_epi32(sum);
+        const __m128i i16 = _mm_packs_epi32(i32, i32);
+        const __m128i u8 = _mm_packus_epi16(i16, i16);
+        const int packed = _mm_cvtsi128_si32(u8);
+        std::memcpy(out + x * 4, &packed, 4);
+#else
+        float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int k = 0; k < taps; ++k) {
+            const float w = c.weights[k];
+            sum[0] += w * src[k * 4];
+            sum[1] += w * src[k * 4 + 1];
+            sum[2] += w * src[k * 4 + 2];
+            sum[3] += w * src[k * 4 + 3];
+        }
+        for (int ch = 0; ch < 4; ++ch) {
+            out[x * 4 + ch] = clampToByte(sum[ch]);
+        }
+#endif
+    }
+}
+
+void horizontalPass3(const float *acc, uchar *out, const QVector<Contribution> &columns)
+{
+    const int dstWidth = columns.size();
+    for (int x = 0; x < dstWidth; ++x) {
+        const Contribution &c = columns[x];
+        const float *src = acc + c.start * 3;
+        float r = 0.0f, g = 0.0f, b = 0.0f;
+        for (int k = 0; k < c.weights.size(); ++k) {
+            const float w = c.weights[k];
+            r += w * src[k * 3];
+            g += w * src[k * 3 + 1];
+            b += w * src[k * 3 + 2];
+        }
+        out[x * 3] = clampToByte(r);
+        out[x * 3 + 1] = clampToByte(g);
+        out[x * 3 + 2] = clampToByte(b);
+    }
+}
+
+QImage scaleSeparable(const QImage &src, const QSize &size, ImageScaler::Filter filter)
+{
+    const int bpp = src.format() == QImage::Format_RGB888 ? 3 : 4;
+    const QVector<Contribution> rows = filter == ImageScaler::Area
+            ? areaContributions(src.height(), size.height())
+            : bilinearContributions(src.height(), size.height());
+    const QVector<Contribution> columns = filter == ImageScaler::Area
+            ? areaContributions(src.width(), size.width())
+            : bilinearContributions(src.width(), size.width());
+
+    QImage dst(size, src.format());
+    const int rowElements = src.width() * bpp;
+    QVector<float> acc(rowElements);
+    const AccumulateFn accumulate = selectAccumulate();
+
+    for (int y = 0; y < size.height(); ++y) {
+        std::fill(acc.begin(), acc.end(), 0.0f);
+        const Contribution &c = rows[y];
+        for (int k = 0; k < c.weights.size(); ++k) {
+            accumulate(acc.data(), src.constScanLine(c.start + k), rowElements, c.weights[k]);
+        }
+        if (bpp == 4) {
+            horizontalPass4(acc.constData(), dst.scanLine(y), columns);
+        } else {
+            horizontalPass3(acc.constData(), dst.scanLine(y), columns);
+        }
+    }
+    return dst;
+}
+
+} // namespace
+
+
+QImage ImageScaler::downscale(const QImage &source, const QSize &targetSize, Filter filter)
+{
+    if (source.isNull() || targetSize.isEmpty()) {
+        return QImage();
+    }
+    if (targetSize.width() > source.width() || targetSize.height() > source.height()) {
+        return source.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    if (targetSize == source.size()) {
+        return source;
+    }
+
+    switch (source.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+    case QImage::Format_RGB888:
+        return scaleSeparable(source, targetSize, filter);
+    case QImage::Format_ARGB32:
+        // 非预乘 alpha 直接平均会让透明像素的颜色渗出，先预乘再缩放
+        return scaleSeparable(source.convertToFormat(QImage::Format_ARGB32_Premultiplied), targetSize, filter)
+                .convertToFormat(QImage::Format_ARGB32);
+    default:
+        return scaleSeparable(source.convertToFormat(source.hasAlphaChannel()
+                                                     ? QImage::Format_ARGB32_Premultiplied
+                                                     : QImage::Format_RGB32),
+                              targetSize, filter);
+    }
+}
+
+QImage ImageScaler::fitWithin(const QImage &source, int maxEdge, Filter filter)
+{
+    if (source.isNull() || maxEdge <= 0) {
+        return source;
+    }
+    const int longest = qMax(source.width(), source.height());
+    if (longest <= maxEdge) {
+        return source;
+    }
+    const QSize target = source.size().scaled(maxEdge, maxEdge, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+    return downscale(source, target, filter);
+}
+
+const char *ImageScaler::activeInstructionSet()
+{
+#ifdef IMAGESCALER_X86
+    return cpuHasAvx2() ? "avx2" : "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+
+// --- 4. 校验与基准 ---
+namespace {
+
+// 确定性的测试图：横向渐变 + 棋盘格 + 噪声，覆盖平滑区域与高频边缘；withAlpha 时 alpha 纵向渐变到接近透明
+QImage makeTestImage(const QSize &size, QImage::Format format, bool withAlpha, quint32 seed)
+{
+    QImage image(size, QImage::Format_ARGB32);
+    QRandomGenerator random(seed);
+    const int w = qMax(1, size.width() - 1);
+    const int h = qMax(1, size.height() - 1);
+    for (int y = 0; y < size.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            const int checker = ((x / 7) + (y / 5)) % 2 ? 64 : 0;
+            const int r = qMin(255, x * 191 / w + checker);
+            const int g = qMin(255, y * 191 / h + int(random.bounded(64)));
+            const int b = qMin(255, (x + y) % 256 / 2 + checker + int(random.bounded(32)));
+            const int a = withAlpha ? qMax(8, 255 - y * 247 / h) : 255;
+            line[x] = qRgba(r, g, b, a);
+        }
+    }
+    return image.convertToFormat(format);
+}
+
+// 与被测代码相互独立的二维参考实现 (双精度，直接按定义计算)，在预乘空间输出
+QVector<double> referenceScale(const QImage &source, const QSize &size, ImageScaler::Filter filter)
+{
+    const QImage src = source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const int sw = src.width();
+    const int sh = src.height();
+    const double sx = double(sw) / size.width();
+    const double sy = double(sh) / size.height();
+    QVector<double> out(size.width() * size.height() * 4, 0.0);
+
+    auto channels = [&src](int x, int y, double weight, double *sum) {
+        const QRgb p = reinterpret_cast<const QRgb *>(src.constScanLine(y))[x];
+        sum[0] += weight * qRed(p);
+        sum[1] += weight * qGreen(p);
+        sum[2] += weight * qBlue(p);
+        sum[3] += weight * qAlpha(p);
+    };
+
+    for (int y = 0; y < size.height(); ++y) {
+        for (int x = 0; x < size.width(); ++x) {
+            double *sum = out.data() + (y * size.width() + x) * 4;
+            if (filter == ImageScaler::Area) {
+                // 目标像素覆盖的源矩形，与每个源像素的重叠面积即权重
+                const double top = y * sy, bottom = qMin(double(sh), top + sy);
+                const double left = x * sx, right = qMin(double(sw), left + sx);
+                for (int v = int(std::floor(top)); v < bottom; ++v) {
+                    const double wy = qMin(bottom, v + 1.0) - qMax(top, double(v));
+                    for (int u = int(std::floor(left)); u < right; ++u) {
+                        const double wx = qMin(right, u + 1.0) - qMax(left, double(u));
+                        if (wx > 0.0 && wy > 0.0) {
+                            channels(u, v, wx * wy / (sx * sy), sum);
+                        }
+                    }
+                }
+            } else {
+                const double fy = qBound(0.0, (y + 0.5) * sy - 0.5, double(sh - 1));
+                const double fx = qBound(0.0, (x + 0.5) * sx - 0.5, double(sw - 1));
+                const int y0 = int(std::floor(fy)), x0 = int(std::floor(fx));
+                const int y1 = qMin(y0 + 1, sh - 1), x1 = qMin(x0 + 1, sw - 1);
+                const double ty = fy - y0, tx = fx - x0;
+                channels(x0, y0, (1 - tx) * (1 - ty), sum);
+                channels(x1, y0, tx * (1 - ty), sum);
+                channels(x0, y1, (1 - tx) * ty, sum);
+                channels(x1, y1, tx * ty, sum);
+            }
+        }
+    }
+    return out;
+}
+
+struct Deviation {
+    int maxError = 0;
+    double meanError = 0.0;
+};
+
+// 两者都在预乘空间比较：反预乘后的颜色在 alpha 很小时会把 1 级误差放大几十倍，没有可比性
+Deviation compare(const QImage &result, const QVector<double> &reference)
+{
+    const QImage img = result.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    Deviation d;
+    double total = 0.0;
+    for (int y = 0; y < img.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(img.constScanLine(y));
+        for (int x = 0; x < img.width(); ++x) {
+            const double *ref = reference.constData() + (y * img.width() + x) * 4;
+            const int got[4] = { qRed(line[x]), qGreen(line[x]), qBlue(line[x]), qAlpha(line[x]) };
+            for (int ch = 0; ch < 4; ++ch) {
+                const int error = qAbs(got[ch] - int(std::lround(ref[ch])));
+                d.maxError = qMax(d.maxError, error);
+                total += error;
+            }
+        }
+    }
+    d.meanError = total / qMax(1, img.width() * img.height() * 4);
+    return d;
+}
+
+Deviation compare(const QImage &result, const QImage &expected)
+{
+    const QImage img = expected.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QVector<double> values(img.width() * img.height() * 4);
+    for (int y = 0; y < img.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(img.constScanLine(y));
+        for (int x = 0; x < img.width(); ++x) {
+            double *v = values.data() + (y * img.width() + x) * 4;
+            v[0] = qRed(line[x]);
+            v[1] = qGreen(line[x]);
+            v[2] = qBlue(line[x]);
+            v[3] = qAlpha(line[x]);
+        }
+    }
+    return compare(result, values);
+}
+
+} // namespace
+
+bool ImageScaler::runFromArguments(const QStringList &arguments, int *exitCode)
+{
+    const CommandLine::Options options = CommandLine::parse(arguments);
+    if (options.contains("--scaler-check")) {
+        *exitCode = runCorrectnessCheck();
+        return true;
+    }
+    if (options.contains("--scaler-bench")) {
+        *exitCode = runBenchmark(CommandLine::intValue(options, "--scaler-bench", 64, 1));
+        return true;
+    }
+    return false;
+}
+
+int ImageScaler::runCorrectnessCheck()
+{
+    // 参考实现：浮点累加 + 一次舍入，允许 ±1；ARGB32 多一次预乘/反预乘的舍入，允许 ±2。
+    // QImage::scaled (SmoothTransformation 的缩小路径同样是面积平均，但用 14 位定点且截断取整)：
+    // 只比 Area，允许单通道 ±3、平均误差 1 以内
+    const int QtMaxError = 3;
+    const double QtMeanError = 1.0;
+
+    struct Case { QSize from; QSize to; };
+    const QVector<Case> cases = {
+        { QSize(640, 480), QSize(160, 120) },     // 整数倍
+        { QSize(1000, 750), QSize(333, 250) },    // 约 3.003 倍
+        { QSize(1919, 1081), QSize(256, 144) },   // 约 7.5 倍，奇数尺寸
+        { QSize(300, 200), QSize(299, 199) },     // 略小于 1 倍
+        { QSize(97, 61), QSize(13, 7) },
+        { QSize(64, 48), QSize(1, 1) },
+    };
+    const QVector<QImage::Format> formats = {
+        QImage::Format_RGB32, QImage::Format_ARGB32_Premultiplied, QImage::Format_ARGB32, QImage::Format_RGB888
+    };
+
+    qDebug().noquote() << QString("ImageScaler: 校验 (%1)").arg(activeInstructionSet());
+    int failures = 0;
+    quint32 seed = 1;
+    for (const Case &c : cases) {
+        for (QImage::Format format : formats) {
+            const bool withAlpha = format == QImage::Format_ARGB32 || format == QImage::Format_ARGB32_Premultiplied;
+            const QImage source = makeTestImage(c.from, format, withAlpha, seed++);
+            const int refTolerance = format == QImage::Format_ARGB32 ? 2 : 1;
+
+            for (Filter filter : { Area, Bilinear }) {
+                const QImage result = downscale(source, c.to, filter);
+                const Deviation ref = compare(result, referenceScale(source, c.to, filter));
+                QString line = QString("ImageScaler: %1x%2 -> %3x%4 format %5 %6  参考 max %7 mean %8")
+                        .arg(c.from.width()).arg(c.from.height()).arg(c.to.width()).arg(c.to.height())
+                        .arg(int(format)).arg(filter == Area ? "area    " : "bilinear")
+                        .arg(ref.maxError).arg(ref.meanError, 0, 'f', 3);
+                bool ok = result.size() == c.to && result.format() == source.format() && ref.maxError <= refTolerance;
+
+                if (filter == Area) {
+                    const QImage expected = source.scaled(c.to, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                    const Deviation qt = compare(result, expected);
+                    line += QString("  QImage max %1 mean %2").arg(qt.maxError).arg(qt.meanError, 0, 'f', 3);
+                    ok = ok && qt.maxError <= QtMaxError && qt.meanError <= QtMeanError;
+                }
+                if (!ok) {
+                    ++failures;
+                    line += "  不通过";
+                }
+                qDebug().noquote() << line;
+            }
+        }
+    }
+    qDebug().noquote() << QString("ImageScaler: %1").arg(failures == 0 ? "全部通过" : QString("%1 项不通过").arg(failures));
+    return failures == 0 ? 0 : 1;
+}
+
+int ImageScaler::runBenchmark(int imageCount)
+{
+    // 典型的分镜图：1920x1080 缩到 320 宽的缩略图
+    const int distinct = qMin(imageCount, 8);
+    QVector<QImage> sources;
+    for (int i = 0; i < distinct; ++i) {
+        sources.append(makeTestImage(QSize(1920, 1080), QImage::Format_RGB32, false, 100 + i));
+    }
+    const double sourceMPix = 1920.0 * 1080.0 * imageCount / 1e6;
+    qDebug().noquote() << QString("ImageScaler: %1 张 1920x1080 -> 320x180 (%2)").arg(imageCount).arg(activeInstructionSet());
+
+    // 单线程：与 QImage::scaled 对比
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < imageCount; ++i) {
+        sources[i % distinct].scaled(320, 180, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    const double qtMs = timer.nsecsElapsed() / 1e6;
+    for (Filter filter : { Area, Bilinear }) {
+        timer.start();
+        for (int i = 0; i < imageCount; ++i) {
+            fitWithin(sources[i % distinct], 320, filter);
+        }
+        const double ms = timer.nsecsElapsed() / 1e6;
+        qDebug().noquote() << QString("ImageScaler: 单线程 %1  %2 ms (%3 张/秒)，QImage::scaled %4 ms，快 %5 倍")
+                              .arg(filter == Area ? "area    " : "bilinear")
+                              .arg(ms, 0, 'f', 1).arg(imageCount * 1000.0 / ms, 0, 'f', 1)
+                              .arg(qtMs, 0, 'f', 1).arg(qtMs / ms, 0, 'f', 2);
+    }
+
+    // 多线程：每个工作线程数单独建执行器，整批提交后等待清空
+    QVector<int> workerCounts;
+    const int cores = qMax(1, QThread::idealThreadCount());
+    for (int n = 1; n < cores; n *= 2) {
+        workerCounts.append(n);
+    }
+    workerCounts.append(cores);
+
+    double singleRate = 0.0;
+    for (int workers : workerCounts) {
+        TaskExecutor executor(workers);
+        timer.start();
+        for (int i = 0; i < imageCount; ++i) {
+            const QImage source = sources[i % distinct];
+            executor.submit([source](const CancellationToken &) {
+                ImageScaler::fitWithin(source, 320, ImageScaler::Area);
+            });
+        }
+        executor.waitForDone();
+        const double ms = timer.nsecsElapsed() / 1e6;
+        const double rate = imageCount * 1000.0 / ms;
+        if (workers == 1) {
+            singleRate = rate;
+        }
+        qDebug().noquote() << QString("ImageScaler: %1 线程  %2 ms，%3 张/秒，%4 MPix/s，每核 %5 MPix/s，加速 %6 倍 (效率 %7%)")
+                              .arg(workers, 2).arg(ms, 0, 'f', 1).arg(rate, 0, 'f', 1)
+                              .arg(sourceMPix * 1000.0 / ms, 0, 'f', 1)
+                              .arg(sourceMPix * 1000.0 / ms / workers, 0, 'f', 1)
+                              .arg(rate / singleRate, 0, 'f', 2)
+                              .arg(rate / singleRate / workers * 100.0, 0, 'f', 0);
+    }
+    return 0;
+}
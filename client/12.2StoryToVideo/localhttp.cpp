@@ -0,0 +1,62 @@
+#include "localhttp.h"
+#include <QList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVariant>
+
+void LocalHttp::serve(QTcpServer *server, QObject *context, int timeoutMs, const Handler &handler)
+{
+    QObject::connect(server, &QTcpServer::newConnection, context, [server, context, timeoutMs, handler]() {
+        while (QTcpSocket *socket = server->nextPendingConnection()) {
+            QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+            // 客户端迟迟不发完请求头时主动断开；已应答的连接 (例如正在发送大文件) 不受影响
+            QTimer::singleShot(timeoutMs, socket, [socket]() {
+                if (!socket->property("stv_answered").toBool()) {
+                    socket->abort();
+                }
+            });
+
+            QObject::connect(socket, &QTcpSocket::readyRead, context, [socket, handler]() {
+                if (socket->property("stv_answered").toBool()) {
+                    socket->readAll();
+                    return;
+                }
+                QByteArray request = socket->property("stv_request").toByteArray() + socket->readAll();
+                if (request.size() > MaxRequestHeaderBytes) {
+                    socket->abort();
+                    return;
+                }
+                if (!request.contains("\r\n\r\n")) {
+                    socket->setProperty("stv_request", request);
+                    return;
+                }
+                socket->setProperty("stv_answered", true);
+                socket->setProperty("stv_request", QVariant());
+
+                // 只解析请求行: GET /path?query HTTP/1.1
+                const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+                QByteArray path = requestLine.value(1);
+                const int query = path.indexOf('?');
+                if (query >= 0) {
+                    path.truncate(query);
+                }
+                handler(socket, requestLine.value(0), path);
+            });
+        }
+    });
+}
+
+void LocalHttp::respond(QTcpSocket *socket, const QByteArray &method, const QByteArray &status,
+                        const QByteArray &contentType, const QByteArray &body)
+{
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+            + "Content-Type: " + contentType + "\r\n"
+            + "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+            + "Connection: close\r\n\r\n";
+    if (method != "HEAD") {
+        response += body;
+    }
+    socket->write(response);
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,29 @@
+#ifndef LOCALHTTP_H
+#define LOCALHTTP_H
+
+#include <QByteArray>
+#include <functional>
+
+class QObject;
+class QTcpServer;
+class QTcpSocket;
+
+// 内置的极简 HTTP/1.1 服务端 (指标端点、局域网对等缓存共用)：每个连接只处理一个请求，
+// 读到完整请求头后解析请求行交给 handler，由 handler 写响应并关闭连接。
+namespace LocalHttp
+{
+    const int MaxRequestHeaderBytes = 8192;
+
+    // method 如 "GET"；path 已去掉查询串
+    typedef std::function<void(QTcpSocket *socket, const QByteArray &method, const QByteArray &path)> Handler;
+
+    // 接管 server 的新连接；请求头超过上限时断开，timeoutMs 内仍未收到完整请求头时断开 (已应答的连接不受影响)。
+    // handler 在 context 所在线程调用
+    void serve(QTcpServer *server, QObject *context, int timeoutMs, const Handler &handler);
+
+    // 写出完整响应 (HEAD 请求不带正文) 并关闭连接
+    void respond(QTcpSocket *socket, const QByteArray &method, const QByteArray &status,
+                 const QByteArray &contentType, const QByteArray &body);
+}
+
+#endif // LOCALHTTP_H
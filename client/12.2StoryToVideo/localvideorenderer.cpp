@@ -0,0 +1,642 @@
+#include "localvideorenderer.h"
+#include "commandline.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QLinearGradient>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QThread>
+#include <QUrl>
+#include <QDebug>
+#include <cmath>
+
+// 每个 ffmpeg 进程使用的编码线程数；进程池大小 = 核心数 / 该值
+static const int ThreadsPerEncoder = 2;
+
+// 渐变类转场的帧数 (片段之间没有重叠，以"经黑场淡入淡出"近似)
+static int fadeFramesFor(const LocalVideoRenderer::Segment &segment, int shotFrames, int fps)
+{
+    const QString transition = segment.transition.toLower();
+    if (transition == "fade" || transition == "dissolve" || transition == "crossfade") {
+        return qMax(1, qMin(fps / 2, shotFrames / 4));
+    }
+    return 0;
+}
+
+LocalVideoRenderer::LocalVideoRenderer(QObject *parent)
+    : QObject(parent), m_runningProcesses(0)
+{
+    m_ffmpeg = ffmpegPath();
+    m_network = new QNetworkAccessManager(this);
+    m_maxProcesses = qMax(1, QThread::idealThreadCount() / ThreadsPerEncoder);
+
+    bool ok = false;
+    const int overrideProcesses = qEnvironmentVariableIntValue("STV_RENDER_PROCESSES", &ok);
+    if (ok && overrideProcesses > 0) {
+        m_maxProcesses = overrideProcesses;
+    }
+
+    if (m_ffmpeg.isEmpty()) {
+        qDebug() << "LocalVideoRenderer: 未找到 ffmpeg，本地草稿导出不可用。";
+    } else {
+        qDebug() << "LocalVideoRenderer: 使用" << m_ffmpeg << "，并发进程数:" << m_maxProcesses;
+    }
+}
+
+LocalVideoRenderer::~LocalVideoRenderer()
+{
+    m_queue.clear();
+    m_jobs.clear();
+}
+
+QString LocalVideoRenderer::ffmpegPath()
+{
+    const QString appDir = QCoreApplication::applicationDirPath();
+    const QStringList bundled = {
+        appDir + "/ffmpeg",
+        appDir + "/ffmpeg.exe",
+        appDir + "/../Resources/ffmpeg"   // macOS .app 包内
+    };
+    for (const QString &candidate : bundled) {
+        if (QFileInfo(candidate).isExecutable()) {
+            return QFileInfo(candidate).absoluteFilePath();
+        }
+    }
+    return QStandardPaths::findExecutable("ffmpeg");
+}
+
+
+// --- 1. 提交 / 取消渲染任务 ---
+void LocalVideoRenderer::render(const QString &jobId, const QVector<Segment> &segments, const QString &outputPath,
+                                const QSize &resolution, int fps)
+{
+    if (!isAvailable()) {
+        emit renderFailed(jobId, "未找到 ffmpeg，无法在本地导出。");
+        return;
+    }
+    if (segments.isEmpty()) {
+        emit renderFailed(jobId, "没有可导出的分镜。");
+        return;
+    }
+    if (m_jobs.contains(jobId)) {
+        cancel(jobId); // 同一项目重新导出时替换旧任务
+    }
+
+    JobPtr job = createJob(jobId, outputPath);
+    if (!job) {
+        return;
+    }
+    job->segments = segments;
+    job->resolution = resolution;
+    job->fps = fps;
+
+    qDebug() << "LocalVideoRenderer: 开始本地渲染" << jobId << "分镜数:" << segments.size();
+    fetchImages(job);
+}
+
+void LocalVideoRenderer::concatFiles(const QString &jobId, const QStringList &inputs, const QString &outputPath)
+{
+    if (!isAvailable()) {
+        emit renderFailed(jobId, "未找到 ffmpeg，无法拼接视频。");
+        return;
+    }
+    if (inputs.isEmpty()) {
+        emit renderFailed(jobId, "没有可拼接的视频。");
+        return;
+    }
+    if (m_jobs.contains(jobId)) {
+        cancel(jobId);
+    }
+
+    JobPtr job = createJob(jobId, outputPath);
+    if (!job) {
+        return;
+    }
+    qDebug() << "LocalVideoRenderer: 拼接视频" << jobId << "文件数:" << inputs.size();
+    concatenate(job, inputs);
+}
+
+LocalVideoRenderer::JobPtr LocalVideoRenderer::createJob(const QString &jobId, const QString &outputPath)
+{
+    JobPtr job(new Job);
+    job->id = jobId;
+    job->outputPath = outputPath;
+    job->resolution = QSize();
+    job->fps = 0;
+    job->totalFrames = 0;
+    job->lastPercent = -1;
+    job->workDir.reset(new QTemporaryDir(QDir::tempPath() + "/storytovideo-render-XXXXXX"));
+    job->pendingDownloads = 0;
+    job->finishedChunks = 0;
+    job->failed = false;
+    job->cancelled = false;
+    job->timer.start();
+
+    if (!job->workDir->isValid()) {
+        emit renderFailed(jobId, "无法创建临时目录。");
+        return JobPtr();
+    }
+
+    m_jobs.insert(jobId, job);
+    return job;
+}
+
+void LocalVideoRenderer::cancel(const QString &jobId)
+{
+    JobPtr job = m_jobs.take(jobId);
+    if (!job || !isActive(job)) {
+        return;
+    }
+
+    job->cancelled = true;
+    // 排队中的片段在 startQueued 中被跳过；下载中的图片和正在运行的进程直接终止
+    abortDownloads(job);
+    for (QProcess *process : job->running) {
+        process->kill();
+    }
+    qDebug() << "LocalVideoRenderer: 已取消" << jobId;
+    emit renderCancelled(jobId);
+}
+
+
+// --- 2. 准备图片：远程图片先下载到临时目录 ---
+void LocalVideoRenderer::fetchImages(const JobPtr &job)
+{
+    job->localImages.clear();
+    for (int i = 0; i < job->segments.size(); ++i) {
+        const QString source = job->segments[i].imageSource;
+        const QUrl url(source);
+
+        if (url.scheme().startsWith("http", Qt::CaseInsensitive)) {
+            job->localImages.append(QString());
+            ++job->pendingDownloads;
+
+            QNetworkRequest request(url);
+            QNetworkReply *reply = m_network->get(request);
+            job->downloads.append(reply);
+            connect(reply, &QNetworkReply::finished, this, [this, job, i, reply]() {
+                onImageDownloaded(job, i, reply);
+            });
+        } else if (url.isLocalFile()) {
+            job->localImages.append(url.toLocalFile());
+        } else {
+            job->localImages.append(source);
+        }
+    }
+
+    if (job->pendingDownloads == 0) {
+        enqueueChunks(job);
+    }
+}
+
+void LocalVideoRenderer::onImageDownloaded(const JobPtr &job, int index, QNetworkReply *reply)
+{
+    reply->deleteLater();
+    job->downloads.removeOne(reply);
+    if (!isActive(job)) {
+        return;
+    }
+
+    if (reply->error() != QNetworkReply::NoError) {
+        fail(job, QString("分镜 %1 图片下载失败: %2").arg(index + 1).arg(reply->errorString()));
+        return;
+    }
+
+    const QString path = job->workDir->filePath(QString("image_%1").arg(index));
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        fail(job, "无法写入临时图片: " + path);
+        return;
+    }
+    const QByteArray data = reply->readAll();
+    if (file.write(data) != data.size()) {
+        fail(job, "无法写入临时图片: " + path);
+        return;
+    }
+    file.close();
+    job->localImages[index] = path;
+
+    if (--job->pendingDownloads == 0) {
+        enqueueChunks(job);
+    }
+}
+
+
+// --- 3. 时间线切分 ---
+// 以帧为单位切片，保证各片段帧数精确、拼接后时长不漂移。
+// 切点落在转场淡入淡出窗口内时吸附到分镜边界，使每个淡入/淡出完整地属于一个片段。
+void LocalVideoRenderer::planChunks(const JobPtr &job)
+{
+    const int fps = job->fps;
+    job->shotFrames.clear();
+    QVector<int> shotStarts;
+    int total = 0;
+    for (const Segment &segment : job->segments) {
+        const int frames = qMax(1, int(std::lround(qMax(0.5, segment.duration) * fps)));
+        shotStarts.append(total);
+        job->shotFrames.append(frames);
+        total += frames;
+    }
+    job->totalFrames = total;
+
+    // 每个进程约分到两个片段以平衡负载；片段不短于 5 秒 (进程启动 + 关键帧开销)，不长于 60 秒
+    const int target = qBound(fps * 5, total / (m_maxProcesses * 2), fps * 60);
+
+    QVector<int> boundaries;
+    boundaries.append(0);
+    int next = target;
+    while (next < total) {
+        int snapped = next;
+        for (int start : shotStarts) {
+            if (qAbs(start - next) <= fps / 2) {
+                snapped = start;
+                break;
+            }
+        }
+        if (snapped > boundaries.last() && snapped < total) {
+            boundaries.append(snapped);
+        }
+        next += target;
+    }
+    boundaries.append(total);
+
+    job->chunks.clear();
+    for (int c = 0; c + 1 < boundaries.size(); ++c) {
+        const int chunkStart = boundaries[c];
+        const int chunkEnd = boundaries[c + 1];
+
+        Chunk chunk;
+        chunk.frameCount = chunkEnd - chunkStart;
+        for (int s = 0; s < job->segments.size(); ++s) {
+            const int shotStart = shotStarts[s];
+            const int shotEnd = shotStart + job->shotFrames[s];
+            const int from = qMax(chunkStart, shotStart);
+            const int to = qMin(chunkEnd, shotEnd);
+            if (from >= to) {
+                continue;
+            }
+            Piece piece;
+            piece.shot = s;
+            piece.frames = to - from;
+            piece.fadeIn = (from == shotStart);
+            piece.fadeOut = (to == shotEnd);
+            chunk.pieces.append(piece);
+        }
+        job->chunks.append(chunk);
+    }
+
+    job->chunkProgress.fill(0, job->chunks.size());
+}
+
+
+// --- 4. 进程池：按时间片段并发编码 ---
+void LocalVideoRenderer::enqueueChunks(const JobPtr &job)
+{
+    planChunks(job);
+    qDebug() << "LocalVideoRenderer:" << job->id << "总帧数" << job->totalFrames
+             << "切分为" << job->chunks.size() << "个片段";
+
+    for (int i = 0; i < job->chunks.size(); ++i) {
+        m_queue.append(qMakePair(job, i));
+    }
+    startQueued();
+}
+
+void LocalVideoRenderer::startQueued()
+{
+    while (m_runningProcesses < m_maxProcesses && !m_queue.isEmpty()) {
+        const QPair<JobPtr, int> next = m_queue.takeFirst();
+        const JobPtr job = next.first;
+        const int index = next.second;
+        if (!isActive(job)) {
+            continue;
+        }
+
+        QProcess *process = new QProcess(this);
+        connect(process, &QProcess::readyReadStandardOutput, this, [this, job, index, process]() {
+            onChunkOutput(job, index, process);
+        });
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this, job, index, process](int exitCode, QProcess::ExitStatus status) {
+            onChunkFinished(job, index, process, exitCode, status);
+        });
+        // 可执行文件无法启动时不会有 finished 信号
+        connect(process, &QProcess::errorOccurred, this, [this, job, index, process](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                onChunkFinished(job, index, process, -1, QProcess::CrashExit);
+            }
+        });
+
+        ++m_runningProcesses;
+        job->running.append(process);
+        process->start(m_ffmpeg, chunkArguments(job, index));
+    }
+}
+
+QString LocalVideoRenderer::chunkPath(const JobPtr &job, int index) const
+{
+    return job->workDir->filePath(QString("chunk_%1.mp4").arg(index, 4, 10, QChar('0')));
+}
+
+QStringList LocalVideoRenderer::chunkArguments(const JobPtr &job, int index) const
+{
+    const Chunk &chunk = job->chunks[index];
+    const int w = job->resolution.width();
+    const int h = job->resolution.height();
+
+    QStringList args;
+    args << "-y" << "-hide_banner" << "-loglevel" << "error"
+         << "-nostats" << "-progress" << "pipe:1";
+
+    for (const Piece &piece : chunk.pieces) {
+        args << "-loop" << "1" << "-framerate" << QString::number(job->fps)
+             << "-i" << job->localImages[piece.shot];
+    }
+
+    // 每段统一缩放 + 补边到目标分辨率，按帧截取，再用 concat 滤镜串成一个流；
+    // 所有片段编码参数相同，保证最终可以 -c copy 拼接
+    QString graph;
+    QString labels;
+    for (int k = 0; k < chunk.pieces.size(); ++k) {
+        const Piece &piece = chunk.pieces[k];
+        const int fade = fadeFramesFor(job->segments[piece.shot], job->shotFrames[piece.shot], job->fps);
+
+        graph += QString("[%1:v]scale=%2:%3:force_original_aspect_ratio=decrease,"
+                         "pad=%2:%3:(ow-iw)/2:(oh-ih)/2,setsar=1,"
+                         "trim=end_frame=%4,setpts=PTS-STARTPTS")
+                .arg(k).arg(w).arg(h).arg(piece.frames);
+        if (fade > 0 && piece.fadeIn) {
+            graph += QString(",fade=t=in:s=0:n=%1").arg(fade);
+        }
+        if (fade > 0 && piece.fadeOut) {
+            graph += QString(",fade=t=out:s=%1:n=%2").arg(qMax(0, piece.frames - fade)).arg(fade);
+        }
+        graph += QString(",format=yuv420p[v%1];").arg(k);
+        labels += QString("[v%1]").arg(k);
+    }
+    graph += QString("%1concat=n=%2:v=1:a=0[out]").arg(labels).arg(chunk.pieces.size());
+
+    args << "-filter_complex" << graph
+         << "-map" << "[out]"
+         << "-frames:v" << QString::number(chunk.frameCount)
+         << "-r" << QString::number(job->fps)
+         << "-c:v" << "libx264" << "-preset" << "veryfast" << "-crf" << "28"
+         << "-threads" << QString::number(ThreadsPerEncoder)
+         << "-an"
+         << chunkPath(job, index);
+    return args;
+}
+
+void LocalVideoRenderer::onChunkOutput(const JobPtr &job, int index, QProcess *process)
+{
+    // -progress 输出形如 "frame=123" 的键值行
+    while (process->canReadLine()) {
+        const QByteArray line = process->readLine().trimmed();
+        if (line.startsWith("frame=")) {
+            job->chunkProgress[index] = qMin(job->chunks[index].frameCount, line.mid(6).toInt());
+            reportProgress(job);
+        }
+    }
+}
+
+void LocalVideoRenderer::onChunkFinished(const JobPtr &job, int index, QProcess *process, int exitCode, QProcess::ExitStatus status)
+{
+    if (!job->running.removeOne(process)) {
+        return; // FailedToStart 之后可能还会收到 finished，避免重复计数
+    }
+    --m_runningProcesses;
+    const QByteArray log = process->readAllStandardError();
+    process->deleteLater();
+
+    if (isActive(job)) {
+        if (status != QProcess::NormalExit || exitCode != 0) {
+            fail(job, QString("片段 %1 编码失败: %2").arg(index + 1).arg(QString::fromUtf8(log).trimmed()));
+        } else {
+            job->chunkProgress[index] = job->chunks[index].frameCount;
+            ++job->finishedChunks;
+            reportProgress(job);
+            if (job->finishedChunks == job->chunks.size()) {
+                QStringList inputs;
+                for (int i = 0; i < job->chunks.size(); ++i) {
+                    inputs.append(chunkPath(job, i));
+                }
+                concatenate(job, inputs);
+            }
+        }
+    }
+
+    startQueued();
+}
+
+void LocalVideoRenderer::reportProgress(const JobPtr &job)
+{
+    qint64 done = 0;
+    for (int frames : job->chunkProgress) {
+        done += frames;
+    }
+    // 片段编码占 95%，拼接占最后 5%
+    const int percent = job->totalFrames > 0 ? int(done * 95 / job->totalFrames) : 0;
+    if (percent != job->lastPercent) {
+        job->lastPercent = percent;
+        emit renderProgress(job->id, percent);
+    }
+}
+
+
+// --- 5. 无损拼接 ---
+void LocalVideoRenderer::concatenate(const JobPtr &job, const QStringList &inputs)
+{
+    const QString listPath = job->workDir->filePath("chunks.txt");
+    QFile list(listPath);
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        fail(job, "无法写入拼接列表。");
+        return;
+    }
+    for (QString path : inputs) {
+        path.replace("'", "'\\''");
+        list.write(QString("file '%1'\n").arg(path).toUtf8());
+    }
+    list.close();
+
+    QDir().mkpath(QFileInfo(job->outputPath).absolutePath());
+
+    QProcess *process = new QProcess(this);
+    job->running.append(process);
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, job, process](int exitCode, QProcess::ExitStatus status) {
+        if (!job->running.removeOne(process)) {
+            return;
+        }
+        const QByteArray log = process->readAllStandardError();
+        process->deleteLater();
+        if (!isActive(job)) {
+            return;
+        }
+        if (status != QProcess::NormalExit || exitCode != 0) {
+            fail(job, "视频拼接失败: " + QString::fromUtf8(log).trimmed());
+            return;
+        }
+        m_jobs.remove(job->id);
+        qDebug() << "LocalVideoRenderer: 本地渲染完成" << job->id << job->outputPath
+                 << "耗时" << job->timer.elapsed() << "ms，进程数" << m_maxProcesses;
+        emit renderProgress(job->id, 100);
+        emit renderFinished(job->id, job->outputPath);
+    });
+    // 与片段编码相同：可执行文件无法启动时不会有 finished 信号，否则任务会一直停在 95%
+    connect(process, &QProcess::errorOccurred, this, [this, job, process](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart || !job->running.removeOne(process)) {
+            return;
+        }
+        process->deleteLater();
+        fail(job, "无法启动 ffmpeg 拼接视频: " + process->errorString());
+    });
+
+    process->start(m_ffmpeg, QStringList()
+                   << "-y" << "-hide_banner" << "-loglevel" << "error"
+                   << "-f" << "concat" << "-safe" << "0" << "-i" << listPath
+                   << "-c" << "copy" << "-movflags" << "+faststart"
+                   << job->outputPath);
+}
+
+void LocalVideoRenderer::fail(const JobPtr &job, const QString &errorMsg)
+{
+    if (!isActive(job)) {
+        return;
+    }
+    job->failed = true;
+    abortDownloads(job);
+    for (QProcess *process : job->running) {
+        process->kill();
+    }
+    m_jobs.remove(job->id);
+    qDebug() << "LocalVideoRenderer: 渲染失败" << job->id << errorMsg;
+    emit renderFailed(job->id, errorMsg);
+}
+
+void LocalVideoRenderer::abortDownloads(const JobPtr &job)
+{
+    // abort() 会同步触发 finished -> onImageDownloaded 修改列表，先取出副本
+    const QList<QNetworkReply *> downloads = job->downloads;
+    job->downloads.clear();
+    for (QNetworkReply *reply : downloads) {
+        reply->abort();
+    }
+}
+
+
+// --- 6. 基准 ---
+bool LocalVideoRenderer::runFromArguments(const QStringList &arguments, int *exitCode)
+{
+    const CommandLine::Options options = CommandLine::parse(arguments);
+    if (!options.contains("--render-bench")) {
+        return false;
+    }
+    *exitCode = runBenchmark(CommandLine::intValue(options, "--render-bench", 300, 10));
+    return true;
+}
+
+int LocalVideoRenderer::runBenchmark(int storySeconds)
+{
+    LocalVideoRenderer renderer;
+    if (!renderer.isAvailable()) {
+        qDebug() << "LocalVideoRenderer: 未找到 ffmpeg，无法运行基准";
+        return 2;
+    }
+    QTemporaryDir temp;
+    if (!temp.isValid()) {
+        qDebug() << "LocalVideoRenderer: 无法创建临时目录";
+        return 2;
+    }
+
+    // 合成故事板：每 5 秒一个分镜，1280x720 渐变图各不相同，转场轮流 cut / fade / dissolve
+    const int shotSeconds = 5;
+    const int shotCount = qMax(1, storySeconds / shotSeconds);
+    const QStringList transitions = { "cut", "fade", "dissolve" };
+    QVector<Segment> segments;
+    for (int i = 0; i < shotCount; ++i) {
+        QImage image(1280, 720, QImage::Format_RGB32);
+        QPainter painter(&image);
+        QLinearGradient gradient(0, 0, image.width(), image.height());
+        gradient.setColorAt(0.0, QColor::fromHsv((i * 37) % 360, 180, 220));
+        gradient.setColorAt(1.0, QColor::fromHsv((i * 37 + 150) % 360, 200, 90));
+        painter.fillRect(image.rect(), gradient);
+        painter.setPen(Qt::white);
+        painter.setFont(QFont("sans", 96));
+        painter.drawText(image.rect(), Qt::AlignCenter, QString::number(i + 1));
+        painter.end();
+
+        const QString path = temp.filePath(QString("shot_%1.png").arg(i, 3, 10, QChar('0')));
+        if (!image.save(path)) {
+            qDebug() << "LocalVideoRenderer: 基准图片写入失败" << path;
+            return 2;
+        }
+        segments.append({ path, double(shotSeconds), transitions[i % transitions.size()] });
+    }
+
+    QVector<int> processCounts;
+    const int maxProcesses = qMax(1, QThread::idealThreadCount() / ThreadsPerEncoder);
+    for (int n = 1; n < maxProcesses; n *= 2) {
+        processCounts.append(n);
+    }
+    processCounts.append(maxProcesses);
+
+    qDebug().noquote() << QString("LocalVideoRenderer: 合成故事板 %1 秒，%2 个分镜，640x360@24，每个 ffmpeg 进程 %3 个编码线程")
+                          .arg(shotCount * shotSeconds).arg(shotCount).arg(ThreadsPerEncoder);
+    double singleMs = 0.0;
+    for (int processes : processCounts) {
+        renderer.m_maxProcesses = processes;
+        const QString jobId = QString("bench_%1").arg(processes);
+        const QString output = temp.filePath(jobId + ".mp4");
+
+        QEventLoop loop;
+        bool done = false;
+        QString error;
+        const QMetaObject::Connection finished = connect(&renderer, &LocalVideoRenderer::renderFinished, &loop,
+                                                         [&](const QString &id, const QString &) {
+            if (id == jobId) {
+                done = true;
+                loop.quit();
+            }
+        });
+        const QMetaObject::Connection failed = connect(&renderer, &LocalVideoRenderer::renderFailed, &loop,
+                                                       [&](const QString &id, const QString &message) {
+            if (id == jobId) {
+                done = true;
+                error = message;
+                loop.quit();
+            }
+        });
+
+        QElapsedTimer timer;
+        timer.start();
+        renderer.render(jobId, segments, output);
+        if (!done) {
+            loop.exec();
+        }
+        const double ms = timer.nsecsElapsed() / 1e6;
+        disconnect(finished);
+        disconnect(failed);
+
+        if (!error.isEmpty()) {
+            qDebug().noquote() << QString("LocalVideoRenderer: %1 进程渲染失败: %2").arg(processes).arg(error);
+            return 1;
+        }
+        if (processes == 1) {
+            singleMs = ms;
+        }
+        qDebug().noquote() << QString("LocalVideoRenderer: %1 进程 (%2 核)  %3 s，%4 倍实时，加速 %5 倍 (效率 %6%)，输出 %7 KB")
+                              .arg(processes, 2).arg(processes * ThreadsPerEncoder, 2)
+                              .arg(ms / 1000.0, 0, 'f', 2)
+                              .arg(shotCount * shotSeconds * 1000.0 / ms, 0, 'f', 1)
+                              .arg(singleMs / ms, 0, 'f', 2)
+                              .arg(singleMs / ms / processes * 100.0, 0, 'f', 0)
+                              .arg(QFileInfo(output).size() / 1024);
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+#ifndef LOCALVIDEORENDERER_H
+#define LOCALVIDEORENDERER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QProcess>
+#include <QSize>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+#include <QVector>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+// 本地草稿视频渲染：把分镜图片 (+ 转场) 用 ffmpeg 编码成低分辨率 MP4，
+// 不经过服务端 GPU 队列。
+// 整条时间线按帧切成若干独立的时间片段，由 ffmpeg 进程池并发编码，
+// 各片段进度 (ffmpeg -progress) 汇总为整体进度，最后用 concat demuxer 无损拼接 (-c copy)。
+//
+// 基准：
+//   ./StoryToVideoGenerator --render-bench[=秒]   合成故事板 (默认 300 秒，每 5 秒一个分镜) 按 1..N 个并发进程渲染，报告耗时与加速比
+class LocalVideoRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    struct Segment {
+        QString imageSource;   // 本地路径、file:// 或 http(s) URL
+        double duration;       // 秒
+        QString transition;    // cut / fade / dissolve / crossfade ...
+    };
+
+    explicit LocalVideoRenderer(QObject *parent = nullptr);
+    ~LocalVideoRenderer();
+
+    // 优先使用随应用分发的 ffmpeg，其次是 PATH 中的 ffmpeg
+    static QString ffmpegPath();
+    bool isAvailable() const { return !m_ffmpeg.isEmpty(); }
+
+    // 并发 ffmpeg 进程数 (默认 核心数 / 每进程线程数；环境变量 STV_RENDER_PROCESSES 可覆盖，便于对比 1..N 核耗时)
+    int maxProcesses() const { return m_maxProcesses; }
+
+    void render(const QString &jobId, const QVector<Segment> &segments, const QString &outputPath,
+                const QSize &resolution = QSize(640, 360), int fps = 24);
+
+    // 直接无损拼接已有的视频文件 (编码参数一致，例如分章节生成的成片)，不重新编码
+    void concatFiles(const QString &jobId, const QStringList &inputs, const QString &outputPath);
+
+    // 协作式取消：丢弃排队片段、中止图片下载、终止正在运行的 ffmpeg 进程
+    void cancel(const QString &jobId);
+
+    // 处理 --render-bench；返回 false 表示不是该命令
+    static bool runFromArguments(const QStringList &arguments, int *exitCode);
+
+    // 生成 storySeconds 秒的合成故事板，依次用 1, 2, 4 … 核心数/每进程线程数 个进程渲染同一时间线
+    static int runBenchmark(int storySeconds);
+
+signals:
+    void renderProgress(const QString &jobId, int percent);
+    void renderFinished(const QString &jobId, const QString &outputPath);
+    void renderFailed(const QString &jobId, const QString &errorMsg);
+    void renderCancelled(const QString &jobId);
+
+private:
+    // 时间片段中属于某个分镜的一段
+    struct Piece {
+        int shot;
+        int frames;
+        bool fadeIn;
+        bool fadeOut;
+    };
+
+    struct Chunk {
+        int frameCount;
+        QVector<Piece> pieces;
+    };
+
+    struct Job {
+        QString id;
+        QVector<Segment> segments;
+        QStringList localImages;     // 与 segments 一一对应
+        QVector<int> shotFrames;     // 每个分镜的帧数
+        QVector<Chunk> chunks;
+        QVector<int> chunkProgress;  // 每个片段已编码帧数
+        QList<QProcess *> running;
+        QList<QNetworkReply *> downloads;   // 尚未完成的图片下载，取消/失败时中止
+        QString outputPath;
+        QSize resolution;
+        int fps;
+        int totalFrames;
+        int lastPercent;
+        QSharedPointer<QTemporaryDir> workDir;
+        int pendingDownloads;
+        int finishedChunks;
+        bool failed;
+        bool cancelled;
+        QElapsedTimer timer;
+    };
+    typedef QSharedPointer<Job> JobPtr;
+
+    JobPtr createJob(const QString &jobId, const QString &outputPath);
+    void fetchImages(const JobPtr &job);
+    void onImageDownloaded(const JobPtr &job, int index, QNetworkReply *reply);
+    void planChunks(const JobPtr &job);
+    void enqueueChunks(const JobPtr &job);
+    void startQueued();
+    void onChunkOutput(const JobPtr &job, int index, QProcess *process);
+    void onChunkFinished(const JobPtr &job, int index, QProcess *process, int exitCode, QProcess::ExitStatus status);
+    void reportProgress(const JobPtr &job);
+    void concatenate(const JobPtr &job, const QStringList &inputs);
+    void fail(const JobPtr &job, const QString &errorMsg);
+    void abortDownloads(const JobPtr &job);
+    bool isActive(const JobPtr &job) const { return !job->failed && !job->cancelled; }
+
+    QStringList chunkArguments(const JobPtr &job, int index) const;
+    QString chunkPath(const JobPtr &job, int index) const;
+
+    QString m_ffmpeg;
+    QNetworkAccessManager *m_network;
+    int m_maxProcesses;
+    int m_runningProcesses;
+    QHash<QString, JobPtr> m_jobs;
+    QList<QPair<JobPtr, int>> m_queue;   // 待编码片段 (job, 片段下标)
+};
+
+#endif // LOCALVIDEORENDERER_H
@@ -4,9 +4,24 @@
 #include <QQmlContext> // 必须
 #include <QDir>
 #include <QQuickStyle>
+#include <QWindow>
+#include <QQuickWindow>
 #include "ViewModel.h"
 #include "DataManager.h" // 引入你的本地存储管理类
 #include "videoexporter.h"
+#include "taskexecutor.h"
+#include "thumbnailprovider.h"
+#include "assetindex.h"
+#include "mediaworkerclient.h"
+#include "metrics.h"
+#include "soaktest.h"
+#include "deltasync.h"
+#include "sessionsnapshot.h"
+#include "pagepreloader.h"
+#include "blurhash.h"
+#include "orderkey.h"
+#include "imagescaler.h"
+#include "localvideorenderer.h"
 
 int main(int argc, char *argv[])
 {
@@ -15,7 +30,48 @@ int main(int argc, char *argv[])
     // 设置 QML 控件样式为 Basic（跨平台兼容）
     QQuickStyle::setStyle("Basic");
     
+    // 在 GUI 线程创建共享后台执行器与资产索引 (缩略图工作线程会访问它们)
+    TaskExecutor::instance();
+    AssetIndex *assetIndex = AssetIndex::instance();
+    // 媒体辅助进程池 (QProcess 需要 GUI 线程的事件循环)
+    MediaWorkerClient::instance();
+    // 指标注册表；设置 STV_METRICS_PORT 时在 127.0.0.1 上提供 /metrics
+    Metrics::instance()->startServerFromEnvironment();
+
+    // 命令行模式：不加载界面，执行完即退出；按顺序匹配，第一个认领参数的模式生效
+    typedef bool (*CommandMode)(const QStringList &arguments, int *exitCode);
+    static const CommandMode commandModes[] = {
+        &DeltaSync::runFromArguments,          // 增量同步 (--sync-from / --sync-to / --sync-bench)
+        &OrderKey::runFromArguments,           // 分镜排序基准 (--order-bench[=N])：重新编号与排序键的移动开销
+        &TaskExecutor::runFromArguments,       // 执行器扩展性基准 (--executor-bench[=N])：N 次缩略图解码在 1..核数个工作线程上的耗时
+        &LocalVideoRenderer::runFromArguments, // 本地渲染扩展性基准 (--render-bench[=秒])：合成故事板在 1..N 个 ffmpeg 进程上的耗时
+        &ImageScaler::runFromArguments,        // 缩略图缩放器校验/基准 (--scaler-check / --scaler-bench[=N])
+    };
+    for (CommandMode runMode : commandModes) {
+        int modeExitCode = 0;
+        if (runMode(app.arguments(), &modeExitCode)) {
+            return modeExitCode;
+        }
+    }
+
+    // 浸泡测试模式 (--soak[=N])：不加载界面，反复跑完整流程并检查内存增长
+    SoakTest::Options soakOptions;
+    if (SoakTest::parseArguments(app.arguments(), &soakOptions)) {
+        ViewModel *soakViewModel = new ViewModel(&app);
+        SoakTest *soak = new SoakTest(soakViewModel, soakOptions, &app);
+        QObject::connect(soak, &SoakTest::finished, &app, [](int exitCode) {
+            QCoreApplication::exit(exitCode);
+        });
+        QMetaObject::invokeMethod(soak, &SoakTest::start, Qt::QueuedConnection);
+        return app.exec();
+    }
+
     QQmlApplicationEngine engine;
+    engine.addImageProvider("thumbnail", new ThumbnailProvider());
+    engine.addImageProvider("placeholder", new BlurHashProvider());
+    // 页面预创建 (栈对象，先于 engine 析构)
+    PagePreloader pagePreloader(&engine);
+    engine.rootContext()->setContextProperty("pagePreloader", &pagePreloader);
     
     // 添加 QML 导入路径（用于打包后的应用）
     QString appDir = QCoreApplication::applicationDirPath();
@@ -33,6 +89,16 @@ int main(int argc, char *argv[])
     // 注册 VideoExporter
     VideoExporter *videoExporter = new VideoExporter();
     engine.rootContext()->setContextProperty("videoExporter", videoExporter);
+    engine.rootContext()->setContextProperty("assetIndex", assetIndex);
+
+    // 热启动：QML 加载前同步读出上次会话的快照，main.qml 第一帧就直接进入上次的项目；
+    // 退出时保存当前项目与分镜行
+    SessionSnapshot *sessionSnapshot = new SessionSnapshot(&app);
+    sessionSnapshot->load();
+    engine.rootContext()->setContextProperty("sessionSnapshot", sessionSnapshot);
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, sessionSnapshot, [sessionSnapshot, viewModel]() {
+        sessionSnapshot->save(viewModel->sessionState());
+    });
 
     // 4️⃣ 加载主 QML
     const QUrl url(QStringLiteral("qrc:/main.qml"));
@@ -43,5 +109,11 @@ int main(int argc, char *argv[])
     }, Qt::QueuedConnection);
     engine.load(url);
 
+    // 主窗口可见性决定轮询节奏 (最小化/隐藏时放慢)
+    if (!engine.rootObjects().isEmpty()) {
+        viewModel->watchWindow(qobject_cast<QWindow *>(engine.rootObjects().first()));
+        pagePreloader.setWindow(qobject_cast<QQuickWindow *>(engine.rootObjects().first()));
+    }
+
     return app.exec();
 }
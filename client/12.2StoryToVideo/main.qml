@@ -32,6 +32,18 @@ ApplicationWindow {
 
         Component.onCompleted: {
             console.log("StackView created, depth:", pageStack.depth)
+
+            // [新增] 热启动：上次会话的项目不带动画直接压栈，先显示快照内容，再由 StoryboardPage 后台刷新
+            if (sessionSnapshot.hasProject) {
+                var project = sessionSnapshot.project;
+                pageStack.push(Qt.resolvedUrl("StoryboardPage.qml"), {
+                    storyId: project.id,
+                    storyTitle: project.title,
+                    shotsData: project.shots,
+                    stackViewRef: pageStack,
+                    restoredFromSnapshot: project.refreshable
+                }, StackView.Immediate);
+            }
         }
 
         // 配置页面的默认属性，让子页面可以访问 StackView
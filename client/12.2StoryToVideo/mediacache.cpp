@@ -0,0 +1,430 @@
+#include "mediacache.h"
+#include "assetindex.h"
+#include "imagehash.h"
+#include "streamdigest.h"
+#include "taskexecutor.h"
+#include "metrics.h"
+#include "peercache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QUrl>
+#include <QDebug>
+#include <algorithm>
+
+MediaCache::MediaCache(QObject *parent)
+    : QObject(parent), m_capacity(DefaultCapacityBytes)
+{
+    m_network = new QNetworkAccessManager(this);
+
+    m_cacheDir = defaultDirectory() + "/";
+    QDir dir(m_cacheDir);
+    if (!dir.exists())
+        dir.mkpath(m_cacheDir);
+
+    m_saveTimer = new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(1000);
+    connect(m_saveTimer, &QTimer::timeout, this, &MediaCache::saveIndex);
+
+    loadIndex();
+
+    // [新增] 局域网对等缓存 (STV_PEER_CACHE 未设置时不启用)
+    m_peers = new PeerCache(this, this);
+    m_peers->startFromEnvironment();
+
+    // 缓存占用只在被抓取时统计
+    Metrics::instance()->gauge("stv_media_cache_entries", "Files currently held in the media cache.",
+                               this, [this]() { return double(m_entries.size()); });
+    Metrics::instance()->gauge("stv_media_cache_bytes", "Bytes currently held in the media cache.",
+                               this, [this]() {
+        qint64 total = 0;
+        for (const Entry &entry : m_entries) {
+            total += entry.size;
+        }
+        return double(total);
+    });
+    Metrics::instance()->gauge("stv_downloads_in_flight", "Media downloads currently running.",
+                               this, [this]() { return double(m_downloads.size()); });
+}
+
+MediaCache::~MediaCache()
+{
+    // 未完成的下载丢弃 .part 文件
+    for (auto it = m_downloads.begin(); it != m_downloads.end(); ++it) {
+        it->reply->disconnect(this);
+        it->reply->abort();
+        it->file->remove();
+        delete it->file;
+        delete it->digest;
+    }
+    if (m_saveTimer->isActive()) {
+        saveIndex();
+    }
+}
+
+
+QString MediaCache::defaultDirectory()
+{
+    const QString overrideDir = qEnvironmentVariable("STV_CACHE_DIR");
+    if (!overrideDir.isEmpty()) {
+        return QDir(overrideDir).absolutePath();
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/media";
+}
+
+
+// --- 1. 查询 ---
+QString MediaCache::fileNameFor(const QString &url) const
+{
+    // 文件名 = URL 的 SHA-1 + 原扩展名 (MediaPlayer 依赖扩展名识别容器)
+    const QString suffix = QFileInfo(QUrl(url).path()).suffix();
+    const QString hash = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return suffix.isEmpty() ? hash : hash + "." + suffix;
+}
+
+bool MediaCache::isCached(const QString &url) const
+{
+    auto it = m_entries.constFind(url);
+    return it != m_entries.constEnd() && QFile::exists(m_cacheDir + it->fileName);
+}
+
+QString MediaCache::digestOf(const QString &url) const
+{
+    auto it = m_entries.constFind(url);
+    return it == m_entries.constEnd() ? QString() : QString::fromLatin1(it->sha256.toHex());
+}
+
+QHash<QString, QByteArray> MediaCache::digestIndex() const
+{
+    QHash<QString, QByteArray> index;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        if (!it->sha256.isEmpty()) {
+            index.insert(PeerCache::urlKey(it.key()), it->sha256);
+        }
+    }
+    return index;
+}
+
+QString MediaCache::pathForDigest(const QByteArray &sha256) const
+{
+    for (const Entry &entry : m_entries) {
+        if (entry.sha256 == sha256 && QFile::exists(m_cacheDir + entry.fileName)) {
+            return m_cacheDir + entry.fileName;
+        }
+    }
+    return QString();
+}
+
+QString MediaCache::localPath(const QString &url)
+{
+    static MetricCounter *hits = Metrics::instance()->counter(
+                "stv_media_cache_lookups_total", "Media cache lookups by result.", Metrics::label("result", "hit"));
+    static MetricCounter *misses = Metrics::instance()->counter(
+                "stv_media_cache_lookups_total", "Media cache lookups by result.", Metrics::label("result", "miss"));
+
+    auto it = m_entries.find(url);
+    if (it == m_entries.end()) {
+        misses->inc();
+        return QString();
+    }
+    const QString path = m_cacheDir + it->fileName;
+    if (!QFile::exists(path)) {
+        m_entries.erase(it);
+        m_saveTimer->start();
+        misses->inc();
+        return QString();
+    }
+    hits->inc();
+    it->lastAccess = QDateTime::currentDateTimeUtc();
+    m_saveTimer->start();
+    return path;
+}
+
+
+// --- 2. 流式下载 ---
+void MediaCache::prefetch(const QString &url)
+{
+    if (url.isEmpty() || isCached(url) || m_downloads.contains(url)) {
+        return;
+    }
+    const QUrl qurl(url);
+    if (qurl.isLocalFile() || !qurl.scheme().startsWith("http", Qt::CaseInsensitive)) {
+        return;
+    }
+
+    // [新增] 局域网内有 peer 持有同一内容时先从 peer 取
+    QByteArray expectedSha256;
+    const QUrl peerSource = m_peers->locate(url, &expectedSha256);
+    if (peerSource.isValid()) {
+        qDebug() << "MediaCache: 从局域网 peer 获取" << url << "<-" << peerSource.toString();
+        startDownload(url, peerSource, expectedSha256);
+    } else {
+        startDownload(url, qurl, QByteArray());
+    }
+}
+
+void MediaCache::startDownload(const QString &url, const QUrl &source, const QByteArray &expectedSha256)
+{
+    QFile *file = new QFile(m_cacheDir + fileNameFor(url) + ".part");
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        emit downloadFailed(url, "无法写入缓存文件: " + file->fileName());
+        delete file;
+        return;
+    }
+
+    QNetworkRequest request(source);
+    request.setAttribute(QNetworkRequest::RedirectPolicyAttribute, QNetworkRequest::NoLessSafeRedirectPolicy);
+    QNetworkReply *reply = m_network->get(request);
+
+    Download download;
+    download.reply = reply;
+    download.file = file;
+    download.digest = new StreamDigest;
+    download.startedAt = QDateTime::currentMSecsSinceEpoch();
+    download.source = source;
+    download.expectedSha256 = expectedSha256;
+    m_downloads.insert(url, download);
+
+    qDebug() << "MediaCache: 开始预取" << url;
+
+    // 每个数据块到达时立即写盘并送入 SHA-256，不在内存中积累整个文件
+    connect(reply, &QNetworkReply::readyRead, this, [this, url]() { onReadyRead(url); });
+    connect(reply, &QNetworkReply::downloadProgress, this, [this, url](qint64 received, qint64 total) {
+        emit downloadProgress(url, received, total);
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, url]() { onFinished(url); });
+}
+
+void MediaCache::onReadyRead(const QString &url)
+{
+    auto it = m_downloads.find(url);
+    if (it == m_downloads.end()) {
+        return;
+    }
+    const QByteArray data = it->reply->readAll();
+    if (it->file->write(data) != data.size()) {
+        // abort() 会同步触发 finished -> onFinished，之后 it 失效
+        it->writeError = "缓存文件写入失败: " + it->file->errorString();
+        it->reply->abort();
+        return;
+    }
+    it->digest->addData(data);
+}
+
+void MediaCache::onFinished(const QString &url)
+{
+    auto it = m_downloads.find(url);
+    if (it == m_downloads.end()) {
+        return;
+    }
+    const Download download = it.value();
+    m_downloads.erase(it);
+    download.reply->deleteLater();
+    const bool fromPeer = !download.expectedSha256.isEmpty();
+
+    // 本地写盘失败与网络无关，不回源重试
+    QString writeError = download.writeError;
+    if (writeError.isEmpty() && download.reply->error() == QNetworkReply::NoError) {
+        const QByteArray tail = download.reply->readAll();
+        if (download.file->write(tail) != tail.size() || !download.file->flush()) {
+            writeError = "缓存文件写入失败: " + download.file->errorString();
+        }
+        download.digest->addData(tail);
+    }
+    if (!writeError.isEmpty()) {
+        download.file->remove();
+        delete download.file;
+        delete download.digest;
+        qDebug() << "MediaCache: 预取失败" << url << writeError;
+        recordDownload(download, "error", 0);
+        emit downloadFailed(url, writeError);
+        return;
+    }
+
+    if (download.reply->error() != QNetworkReply::NoError) {
+        download.file->remove();
+        delete download.file;
+        delete download.digest;
+        if (fromPeer) {
+            fallBackToOrigin(url, download, download.reply->errorString());
+            return;
+        }
+        qDebug() << "MediaCache: 预取失败" << url << download.reply->errorString();
+        recordDownload(download, "error", 0);
+        emit downloadFailed(url, download.reply->errorString());
+        return;
+    }
+
+    download.file->close();
+    const QByteArray sha256 = download.digest->result();
+    delete download.digest;
+
+    QString verifyError;
+    if (fromPeer && sha256 != download.expectedSha256) {
+        download.file->remove();
+        delete download.file;
+        fallBackToOrigin(url, download, "peer 内容摘要不符");
+        return;
+    }
+    if (!StreamDigest::verify(download.reply, sha256, &verifyError)) {
+        download.file->remove();
+        delete download.file;
+        qDebug() << "MediaCache:" << url << verifyError;
+        recordDownload(download, "digest_mismatch", 0);
+        emit downloadFailed(url, verifyError);
+        return;
+    }
+
+    const QString fileName = fileNameFor(url);
+    const QString finalPath = m_cacheDir + fileName;
+    QFile::remove(finalPath);
+    if (!download.file->rename(finalPath)) {
+        download.file->remove();
+        delete download.file;
+        emit downloadFailed(url, "缓存文件重命名失败: " + finalPath);
+        return;
+    }
+    delete download.file;
+
+    Entry entry;
+    entry.fileName = fileName;
+    entry.size = QFileInfo(finalPath).size();
+    entry.lastAccess = QDateTime::currentDateTimeUtc();
+    entry.sha256 = sha256;
+    m_entries.insert(url, entry);
+    recordDownload(download, "ok", entry.size);
+    if (fromPeer) {
+        Metrics::instance()->counter("stv_peer_downloads_total", "Media fetched from LAN peers, by result.",
+                                     Metrics::label("result", "ok"))->inc();
+    }
+    evictIfNeeded(url);
+    m_saveTimer->start();
+
+    // 图片进入缓存时在后台计算感知哈希，写入资产索引
+    TaskExecutor::instance()->submit([finalPath, sha256](const CancellationToken &) {
+        if (QImageReader::imageFormat(finalPath).isEmpty()) {
+            return; // 视频等非图片资源
+        }
+        const QImage image(finalPath);
+        if (!image.isNull()) {
+            AssetIndex::instance()->recordImage(finalPath, ImageHash::dHash(image));
+            AssetIndex::instance()->recordContentDigest(finalPath, sha256);
+        }
+    });
+
+    qDebug() << "MediaCache: 已缓存" << url << "->" << finalPath << entry.size << "bytes sha256:" << sha256.toHex();
+    emit cached(url, finalPath);
+}
+
+
+void MediaCache::fallBackToOrigin(const QString &url, const Download &download, const QString &reason)
+{
+    // 调用方已删除 .part 文件；换回 Gateway 重新下载
+    qDebug() << "MediaCache: peer 获取失败，回源" << url << reason;
+    m_peers->reportBadSource(download.source, download.expectedSha256);
+    Metrics::instance()->counter("stv_peer_downloads_total", "Media fetched from LAN peers, by result.",
+                                 Metrics::label("result", "fallback"))->inc();
+    startDownload(url, QUrl(url), QByteArray());
+}
+
+void MediaCache::recordDownload(const Download &download, const QString &result, qint64 bytes)
+{
+    Metrics *metrics = Metrics::instance();
+    metrics->counter("stv_downloads_total", "Media downloads finished, by result.",
+                     Metrics::label("result", result))->inc();
+    if (bytes > 0) {
+        metrics->counter("stv_download_bytes_total", "Bytes downloaded into the media cache.")->inc(quint64(bytes));
+        metrics->histogram("stv_download_duration_seconds", "Duration of successful media downloads.",
+                           Metrics::downloadBuckets())
+                ->observe((QDateTime::currentMSecsSinceEpoch() - download.startedAt) / 1000.0);
+    }
+}
+
+
+// --- 3. 淘汰与持久化 ---
+void MediaCache::evictIfNeeded(const QString &keepUrl)
+{
+    qint64 total = 0;
+    for (const Entry &entry : m_entries) {
+        total += entry.size;
+    }
+    if (total <= m_capacity) {
+        return;
+    }
+
+    QList<QString> urls = m_entries.keys();
+    std::sort(urls.begin(), urls.end(), [this](const QString &a, const QString &b) {
+        return m_entries[a].lastAccess < m_entries[b].lastAccess;
+    });
+    for (const QString &url : urls) {
+        if (total <= m_capacity) {
+            break;
+        }
+        // [修改] 刚写入的条目 (访问时间最新，但同一时刻可能有多个) 不参与淘汰，否则会在 cached 信号发出前删掉它
+        if (url == keepUrl) {
+            continue;
+        }
+        const Entry entry = m_entries.take(url);
+        QFile::remove(m_cacheDir + entry.fileName);
+        total -= entry.size;
+        qDebug() << "MediaCache: 淘汰" << url;
+    }
+}
+
+void MediaCache::loadIndex()
+{
+    QFile file(m_cacheDir + "media_index.json");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    const QJsonObject entries = root["entries"].toObject();
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        const QJsonObject obj = it.value().toObject();
+        Entry entry;
+        entry.fileName = obj["file"].toString();
+        entry.size = qint64(obj["size"].toDouble());
+        entry.lastAccess = QDateTime::fromString(obj["lastAccess"].toString(), Qt::ISODate);
+        entry.sha256 = QByteArray::fromHex(obj["sha256"].toString().toLatin1());
+        if (QFile::exists(m_cacheDir + entry.fileName)) {
+            m_entries.insert(it.key(), entry);
+        }
+    }
+    qDebug() << "MediaCache 索引加载完成，条目数:" << m_entries.size();
+}
+
+void MediaCache::saveIndex()
+{
+    QJsonObject entries;
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        QJsonObject obj;
+        obj["file"] = it->fileName;
+        obj["size"] = double(it->size);
+        obj["lastAccess"] = it->lastAccess.toString(Qt::ISODate);
+        if (!it->sha256.isEmpty()) {
+            obj["sha256"] = QString::fromLatin1(it->sha256.toHex());
+        }
+        entries.insert(it.key(), obj);
+    }
+    QJsonObject root;
+    root["version"] = 1;
+    root["entries"] = entries;
+
+    // [修改] 先写临时文件再替换，写入失败时保留旧索引
+    QSaveFile file(m_cacheDir + "media_index.json");
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Compact);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        qDebug() << "MediaCache: 索引保存失败" << file.fileName() << file.errorString();
+    }
+}
@@ -0,0 +1,93 @@
+#ifndef MEDIACACHE_H
+#define MEDIACACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QDateTime>
+#include <QTimer>
+#include <QUrl>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QFile;
+class StreamDigest;
+class PeerCache;
+
+// 本地媒体缓存：把服务端生成的视频/图片流式下载到 CacheLocation/media，
+// 之后预览、导出直接读本地文件。索引保存在 media_index.json (URL -> 文件)。
+// 启用局域网对等缓存时先向 peer 取同一内容，校验失败再回源。
+// STV_CACHE_DIR 可覆盖缓存目录 (同一台机器上跑多个实例测试对等缓存时使用)。
+class MediaCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MediaCache(QObject *parent = nullptr);
+    ~MediaCache();
+
+    // 缓存上限，超出后按最近访问时间淘汰
+    static const qint64 DefaultCapacityBytes = 2LL * 1024 * 1024 * 1024;
+
+    // 已缓存返回本地路径 (并刷新访问时间)，否则返回空
+    QString localPath(const QString &url);
+    bool isCached(const QString &url) const;
+    bool isDownloading(const QString &url) const { return m_downloads.contains(url); }
+
+    // 后台下载到缓存；已缓存或正在下载时不会重复请求
+    void prefetch(const QString &url);
+
+    // 下载时增量计算的 SHA-256 (十六进制)，未缓存返回空
+    QString digestOf(const QString &url) const;
+
+    QString cacheDirectory() const { return m_cacheDir; }
+    // [新增] CacheLocation/media，或 STV_CACHE_DIR 指定的目录 (不带结尾的 '/')
+    static QString defaultDirectory();
+
+    // [新增] 对等缓存使用：URL 摘要 -> SHA-256，以及按内容摘要找本地文件 (没有时返回空)
+    QHash<QString, QByteArray> digestIndex() const;
+    QString pathForDigest(const QByteArray &sha256) const;
+
+signals:
+    void downloadProgress(const QString &url, qint64 received, qint64 total);
+    void cached(const QString &url, const QString &localPath);
+    void downloadFailed(const QString &url, const QString &errorMsg);
+
+private slots:
+    void saveIndex();
+
+private:
+    struct Entry {
+        QString fileName;
+        qint64 size;
+        QDateTime lastAccess;
+        QByteArray sha256;
+    };
+
+    struct Download {
+        QNetworkReply *reply;
+        QFile *file;
+        StreamDigest *digest;
+        qint64 startedAt;      // 开始下载的时间 (ms)，用于耗时指标
+        QUrl source;           // 实际下载地址：Gateway 或局域网 peer
+        QByteArray expectedSha256;  // 来自 peer 时必须匹配的内容摘要
+        QString writeError;    // [新增] 写盘失败 (磁盘满等) 时的错误，下载随即中止
+    };
+
+    void startDownload(const QString &url, const QUrl &source, const QByteArray &expectedSha256);
+    void onReadyRead(const QString &url);
+    void onFinished(const QString &url);
+    void evictIfNeeded(const QString &keepUrl);
+    void loadIndex();
+    QString fileNameFor(const QString &url) const;
+    void recordDownload(const Download &download, const QString &result, qint64 bytes);
+    void fallBackToOrigin(const QString &url, const Download &download, const QString &reason);
+
+    QNetworkAccessManager *m_network;
+    QString m_cacheDir;
+    qint64 m_capacity;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, Download> m_downloads;
+    QTimer *m_saveTimer;
+    PeerCache *m_peers;
+};
+
+#endif // MEDIACACHE_H
@@ -0,0 +1,173 @@
+// stv-mediaworker：主程序的媒体辅助进程
+// 所有可能因坏文件崩溃或占用大量内存的解码工作都在这里完成，主进程只接收缩小后的像素。
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSharedMemory>
+#include <QStandardPaths>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "imagescaler.h"
+#include "imagehash.h"
+#include "mediaworkerprotocol.h"
+
+static const int FfmpegTimeoutMs = 15000;
+
+static bool isVideoFile(const QString &path)
+{
+    static const QStringList suffixes = {"mp4", "mov", "m4v", "mkv", "webm", "avi"};
+    return suffixes.contains(QFileInfo(path).suffix().toLower());
+}
+
+static QString ffmpegPath()
+{
+    // 与主程序 LocalVideoRenderer::ffmpegPath() 的查找顺序一致
+    const QString appDir = QCoreApplication::applicationDirPath();
+    const QStringList bundled = {appDir + "/ffmpeg", appDir + "/ffmpeg.exe", appDir + "/../Resources/ffmpeg"};
+    for (const QString &candidate : bundled) {
+        if (QFileInfo(candidate).isExecutable()) {
+            return QFileInfo(candidate).absoluteFilePath();
+        }
+    }
+    return QStandardPaths::findExecutable("ffmpeg");
+}
+
+// 用 ffmpeg 抽取视频某一时刻的一帧，缩放在 ffmpeg 内完成，只传回小图
+static QImage decodeVideoFrame(const QString &path, double time, const QSize &maxSize, QString *error)
+{
+    const QString ffmpeg = ffmpegPath();
+    if (ffmpeg.isEmpty()) {
+        *error = "未找到 ffmpeg，无法解码视频帧";
+        return QImage();
+    }
+
+    QStringList args;
+    args << "-hide_banner" << "-loglevel" << "error"
+         << "-ss" << QString::number(qMax(0.0, time), 'f', 3)
+         << "-i" << path << "-frames:v" << "1";
+    if (maxSize.isValid() && !maxSize.isEmpty()) {
+        args << "-vf" << QString("scale=w=%1:h=%2:force_original_aspect_ratio=decrease")
+                             .arg(maxSize.width()).arg(maxSize.height());
+    }
+    args << "-f" << "image2pipe" << "-vcodec" << "bmp" << "-";
+
+    QProcess process;
+    process.start(ffmpeg, args);
+    if (!process.waitForFinished(FfmpegTimeoutMs)) {
+        process.kill();
+        process.waitForFinished();
+        *error = "ffmpeg 解码超时";
+        return QImage();
+    }
+    QImage frame = QImage::fromData(process.readAllStandardOutput(), "BMP");
+    if (frame.isNull()) {
+        *error = "视频帧解码失败: " + QString::fromUtf8(process.readAllStandardError()).trimmed();
+    }
+    return frame;
+}
+
+static QJsonObject handleThumbnail(const QJsonObject &request)
+{
+    QJsonObject reply;
+    const QString path = request["path"].toString();
+    const QSize maxSize(request["maxWidth"].toInt(), request["maxHeight"].toInt());
+    QString error;
+    QImage image;
+
+    if (isVideoFile(path)) {
+        image = decodeVideoFrame(path, request["time"].toDouble(), maxSize, &error);
+    } else {
+        QImageReader reader(path);
+        reader.setAutoTransform(true);
+        const QImage decoded = reader.read();
+        if (decoded.isNull()) {
+            error = QString("缩略图解码失败 %1: %2").arg(path, reader.errorString());
+        } else {
+            // 原图只在本进程出现一次：顺便计算感知哈希，主程序写入资产索引
+            reply["dhash"] = ImageHash::toHex(ImageHash::dHash(decoded));
+            image = decoded;
+        }
+    }
+
+    if (!image.isNull()) {
+        if (maxSize.isValid() && !maxSize.isEmpty()) {
+            if (image.width() > maxSize.width() || image.height() > maxSize.height()) {
+                const QSize target = image.size().scaled(maxSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+                image = ImageScaler::downscale(image, target, ImageScaler::Area);
+            }
+        }
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+    if (image.isNull()) {
+        reply["ok"] = false;
+        reply["error"] = error;
+        return reply;
+    }
+
+    // 写入主程序提供的共享内存段 (紧密排列，不带行对齐填充)
+    const int bytesPerLine = image.width() * MediaWorkerProtocol::BytesPerPixel;
+    const qint64 needed = qint64(bytesPerLine) * image.height();
+    QSharedMemory shm;
+    shm.setKey(request["shm"].toString());
+    if (!shm.attach(QSharedMemory::ReadWrite)) {
+        reply["ok"] = false;
+        reply["error"] = "共享内存连接失败: " + shm.errorString();
+        return reply;
+    }
+    if (shm.size() < needed) {
+        shm.detach();
+        reply["ok"] = false;
+        reply["error"] = QString("共享内存不足: 需要 %1 字节").arg(needed);
+        return reply;
+    }
+    shm.lock();
+    char *dst = static_cast<char *>(shm.data());
+    for (int y = 0; y < image.height(); ++y) {
+        memcpy(dst + qint64(y) * bytesPerLine, image.constScanLine(y), size_t(bytesPerLine));
+    }
+    shm.unlock();
+    shm.detach();
+
+    reply["ok"] = true;
+    reply["width"] = image.width();
+    reply["height"] = image.height();
+    reply["bytesPerLine"] = bytesPerLine;
+    reply["format"] = int(QImage::Format_ARGB32_Premultiplied);
+    return reply;
+}
+
+int main(int argc, char *argv[])
+{
+    // 不需要窗口系统，QCoreApplication 足以加载图片格式插件
+    QCoreApplication app(argc, argv);
+
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        const QJsonObject request = QJsonDocument::fromJson(QByteArray::fromStdString(line)).object();
+        const QString cmd = request["cmd"].toString();
+
+        QJsonObject reply;
+        if (cmd == MediaWorkerProtocol::CmdThumbnail) {
+            reply = handleThumbnail(request);
+        } else if (cmd == MediaWorkerProtocol::CmdPing) {
+            reply["ok"] = true;
+            reply["pid"] = QCoreApplication::applicationPid();
+        } else {
+            reply["ok"] = false;
+            reply["error"] = "未知命令: " + cmd;
+        }
+        reply["id"] = request["id"];
+
+        const QByteArray out = QJsonDocument(reply).toJson(QJsonDocument::Compact) + '\n';
+        fwrite(out.constData(), 1, size_t(out.size()), stdout);
+        fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+# 媒体辅助进程：图片/视频帧解码 + 缩小，结果经共享内存交给主程序
+# 与主程序分开构建 (qmake mediaworker/mediaworker.pro && make)，可执行文件输出到主程序旁边
+
+TEMPLATE = app
+TARGET = stv-mediaworker
+
+QT += core gui
+QT -= widgets
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += main.cpp \
+    ../imagescaler.cpp \
+    ../imagehash.cpp
+
+HEADERS += ../mediaworkerprotocol.h \
+    ../imagescaler.h \
+    ../imagehash.h
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# 主程序在 applicationDirPath() 下查找 stv-mediaworker
+macx: DESTDIR = $$PWD/../StoryToVideoGenerator.app/Contents/MacOS
+else: DESTDIR = $$PWD/..
@@ -0,0 +1,304 @@
+#include "mediaworkerclient.h"
+#include "mediaworkerprotocol.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSharedMemory>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+
+MediaWorkerClient::MediaWorkerClient(QObject *parent)
+    : QObject(parent), m_nextId(1)
+{
+    m_executable = executablePath();
+
+    // 子进程数默认 核心数/2 (1..4)；环境变量 STV_MEDIA_WORKERS 可覆盖，0 表示禁用
+    int count = qBound(1, QThread::idealThreadCount() / 2, 4);
+    bool ok = false;
+    const int override = qEnvironmentVariableIntValue("STV_MEDIA_WORKERS", &ok);
+    if (ok) {
+        count = qMax(0, override);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        Worker *worker = new Worker;
+        worker->process = nullptr;
+        worker->shm = nullptr;
+        worker->shmGeneration = 0;
+        worker->busy = false;
+        worker->timeout = new QTimer(this);
+        worker->timeout->setSingleShot(true);
+        worker->timeout->setInterval(RequestTimeoutMs);
+        connect(worker->timeout, &QTimer::timeout, this, [this, i]() {
+            // 超时视同崩溃：杀掉子进程，finished 中统一处理
+            qDebug() << "MediaWorkerClient: 请求超时，终止子进程" << i;
+            if (m_workers[i]->process) {
+                m_workers[i]->process->kill();
+            }
+        });
+        m_workers.append(worker);
+    }
+
+    m_available.storeRelease(!m_executable.isEmpty() && count > 0);
+    qDebug() << "MediaWorkerClient:" << (isAvailable() ? m_executable : QString("未启用，使用进程内解码"))
+             << "子进程数:" << count;
+}
+
+MediaWorkerClient::~MediaWorkerClient()
+{
+    for (Worker *worker : m_workers) {
+        if (worker->process) {
+            worker->process->disconnect(this);
+            // 关闭 stdin 后子进程读到 EOF 自行退出
+            worker->process->closeWriteChannel();
+            if (!worker->process->waitForFinished(1000)) {
+                worker->process->kill();
+                worker->process->waitForFinished(1000);
+            }
+        }
+        delete worker->shm;
+        delete worker;
+    }
+}
+
+MediaWorkerClient *MediaWorkerClient::instance()
+{
+    static MediaWorkerClient *s_instance = new MediaWorkerClient(QCoreApplication::instance());
+    return s_instance;
+}
+
+QString MediaWorkerClient::executablePath()
+{
+    const QString appDir = QCoreApplication::applicationDirPath();
+    const QString name = QString::fromLatin1(MediaWorkerProtocol::ExecutableName);
+    const QStringList candidates = {appDir + "/" + name, appDir + "/" + name + ".exe"};
+    for (const QString &candidate : candidates) {
+        if (QFileInfo(candidate).isExecutable()) {
+            return QFileInfo(candidate).absoluteFilePath();
+        }
+    }
+    return QString();
+}
+
+
+// --- 1. 请求排队与分发 ---
+void MediaWorkerClient::requestThumbnail(const QString &path, const QSize &maxSize, double time, Callback done)
+{
+    QMetaObject::invokeMethod(this, [this, path, maxSize, time, done]() {
+        Request request;
+        request.id = m_nextId++;
+        request.path = path;
+        request.maxSize = maxSize;
+        request.time = time;
+        request.done = done;
+
+        if (!isAvailable()) {
+            fail(request, "媒体辅助进程不可用", true);
+            return;
+        }
+        if (m_poisoned.contains(path)) {
+            fail(request, "该文件曾导致媒体辅助进程崩溃，已跳过: " + path);
+            return;
+        }
+        m_queue.append(request);
+        dispatch();
+    }, Qt::AutoConnection);
+}
+
+void MediaWorkerClient::dispatch()
+{
+    for (int i = 0; i < m_workers.size() && !m_queue.isEmpty(); ++i) {
+        Worker *worker = m_workers[i];
+        if (worker->busy) {
+            continue;
+        }
+
+        const Request request = m_queue.takeFirst();
+        const qint64 bytes = qint64(request.maxSize.width()) * request.maxSize.height()
+                * MediaWorkerProtocol::BytesPerPixel;
+        if (!ensureProcess(i) || !ensureSegment(i, bytes)) {
+            fail(request, "无法启动媒体辅助进程");
+            continue;
+        }
+
+        QJsonObject json;
+        json["id"] = double(request.id);
+        json["cmd"] = MediaWorkerProtocol::CmdThumbnail;
+        json["path"] = request.path;
+        json["maxWidth"] = request.maxSize.width();
+        json["maxHeight"] = request.maxSize.height();
+        json["time"] = request.time;
+        json["shm"] = worker->shm->key();
+        json["shmSize"] = double(worker->shm->size());
+
+        worker->current = request;
+        worker->busy = true;
+        worker->timeout->start();
+        worker->process->write(QJsonDocument(json).toJson(QJsonDocument::Compact) + '\n');
+    }
+}
+
+bool MediaWorkerClient::ensureProcess(int index)
+{
+    Worker *worker = m_workers[index];
+    if (worker->process) {
+        return true;
+    }
+
+    QProcess *process = new QProcess(this);
+    // 子进程的日志直接输出到本进程 stderr
+    process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    connect(process, &QProcess::readyReadStandardOutput, this, [this, index]() { onReadyRead(index); });
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+            [this, index](int exitCode, QProcess::ExitStatus status) {
+        onProcessExit(index, status == QProcess::CrashExit ? QString("崩溃")
+                                                            : QString("退出码 %1").arg(exitCode));
+    });
+    connect(process, &QProcess::errorOccurred, this, [this, index](QProcess::ProcessError error) {
+        // FailedToStart 不会触发 finished
+        if (error == QProcess::FailedToStart) {
+            onProcessExit(index, "启动失败");
+        }
+    });
+
+    worker->process = process;
+    worker->buffer.clear();
+    process->start(m_executable, QStringList());
+    return true;
+}
+
+bool MediaWorkerClient::ensureSegment(int index, qint64 bytes)
+{
+    Worker *worker = m_workers[index];
+    if (worker->shm && worker->shm->size() >= bytes) {
+        return true;
+    }
+
+    delete worker->shm;
+    worker->shm = new QSharedMemory(this);
+    // 每次扩容换一个新 key，避免与子进程中仍未 detach 的旧段混淆
+    worker->shm->setKey(QString("stv-media-%1-%2-%3")
+                        .arg(QCoreApplication::applicationPid()).arg(index).arg(++worker->shmGeneration));
+    const qint64 size = qMax<qint64>(bytes, 256 * 256 * MediaWorkerProtocol::BytesPerPixel);
+    if (!worker->shm->create(int(size))) {
+        qDebug() << "MediaWorkerClient: 共享内存创建失败" << worker->shm->errorString();
+        delete worker->shm;
+        worker->shm = nullptr;
+        return false;
+    }
+    return true;
+}
+
+
+// --- 2. 应答 ---
+void MediaWorkerClient::onReadyRead(int index)
+{
+    Worker *worker = m_workers[index];
+    worker->buffer += worker->process->readAllStandardOutput();
+    int newline;
+    while ((newline = worker->buffer.indexOf('\n')) >= 0) {
+        const QByteArray line = worker->buffer.left(newline);
+        worker->buffer.remove(0, newline + 1);
+        onReply(index, line);
+    }
+}
+
+void MediaWorkerClient::onReply(int index, const QByteArray &line)
+{
+    Worker *worker = m_workers[index];
+    const QJsonObject reply = QJsonDocument::fromJson(line).object();
+    if (!worker->busy || quint64(reply["id"].toDouble()) != worker->current.id) {
+        return;
+    }
+
+    Result result;
+    result.unavailable = false;
+    if (!reply["ok"].toBool()) {
+        result.error = reply["error"].toString();
+        finishCurrent(index, result);
+        return;
+    }
+
+    const int width = reply["width"].toInt();
+    const int height = reply["height"].toInt();
+    const int bytesPerLine = reply["bytesPerLine"].toInt();
+    const QImage::Format format = QImage::Format(reply["format"].toInt());
+    if (width <= 0 || height <= 0 || qint64(bytesPerLine) * height > worker->shm->size()) {
+        result.error = "媒体辅助进程返回了无效的图像尺寸";
+        finishCurrent(index, result);
+        return;
+    }
+
+    // 从共享内存复制出来，之后该段可以给下一个请求复用
+    worker->shm->lock();
+    result.image = QImage(static_cast<const uchar *>(worker->shm->constData()),
+                          width, height, bytesPerLine, format).copy();
+    worker->shm->unlock();
+    result.dhash = reply["dhash"].toString();
+    finishCurrent(index, result);
+}
+
+void MediaWorkerClient::finishCurrent(int index, const Result &result)
+{
+    Worker *worker = m_workers[index];
+    worker->timeout->stop();
+    worker->busy = false;
+    const Request request = worker->current;
+    worker->current = Request();
+    if (request.done) {
+        request.done(result);
+    }
+    dispatch();
+}
+
+void MediaWorkerClient::onProcessExit(int index, const QString &reason)
+{
+    Worker *worker = m_workers[index];
+    if (!worker->process) {
+        return; // FailedToStart 之后可能还会收到 finished
+    }
+    worker->process->deleteLater();
+    worker->process = nullptr;
+    worker->timeout->stop();
+
+    qDebug() << "MediaWorkerClient: 子进程" << index << reason
+             << (worker->busy ? worker->current.path : QString());
+
+    // 正在处理的文件记为有害，不再重试
+    if (worker->busy) {
+        m_poisoned.insert(worker->current.path);
+        Result result;
+        result.unavailable = false;
+        result.error = QString("媒体辅助进程%1，文件已跳过: %2").arg(reason, worker->current.path);
+        finishCurrent(index, result);
+    }
+
+    // 短时间内反复崩溃 (例如可执行文件损坏) 时停用，排队请求回退到进程内解码
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    m_crashTimes.append(now);
+    while (!m_crashTimes.isEmpty() && now - m_crashTimes.first() > 60000) {
+        m_crashTimes.removeFirst();
+    }
+    if (m_crashTimes.size() > MaxCrashesPerMinute && isAvailable()) {
+        qDebug() << "MediaWorkerClient: 子进程频繁退出，停用媒体辅助进程";
+        m_available.storeRelease(0);
+        const QList<Request> pending = m_queue;
+        m_queue.clear();
+        for (const Request &request : pending) {
+            fail(request, "媒体辅助进程不可用", true);
+        }
+    }
+}
+
+void MediaWorkerClient::fail(const Request &request, const QString &error, bool unavailable)
+{
+    Result result;
+    result.error = error;
+    result.unavailable = unavailable;
+    if (request.done) {
+        request.done(result);
+    }
+}
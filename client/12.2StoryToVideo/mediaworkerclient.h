@@ -0,0 +1,88 @@
+#ifndef MEDIAWORKERCLIENT_H
+#define MEDIAWORKERCLIENT_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QImage>
+#include <QList>
+#include <QProcess>
+#include <QSet>
+#include <QSize>
+#include <QVector>
+#include <functional>
+
+class QSharedMemory;
+class QTimer;
+
+// 媒体辅助进程池：图片/视频帧解码与缩小交给 stv-mediaworker 子进程，
+// 像素经共享内存返回。坏文件导致的崩溃或内存膨胀只影响子进程，主进程保持精简。
+// 导致崩溃/超时的文件会被记住，之后直接报错而不再交给子进程。
+class MediaWorkerClient : public QObject
+{
+    Q_OBJECT
+public:
+    struct Result {
+        QImage image;
+        QString dhash;        // 静态图片的感知哈希 (十六进制)，视频帧为空
+        QString error;
+        bool unavailable;     // 辅助进程不可用，调用方应改用进程内解码
+    };
+    typedef std::function<void(const Result &)> Callback;
+
+    explicit MediaWorkerClient(QObject *parent = nullptr);
+    ~MediaWorkerClient();
+
+    // 进程级共享实例，需在 GUI 线程首次调用
+    static MediaWorkerClient *instance();
+
+    // 主程序目录下的 stv-mediaworker，不存在时返回空
+    static QString executablePath();
+
+    static const int RequestTimeoutMs = 20000;
+    // 一分钟内崩溃超过该次数则停用辅助进程
+    static const int MaxCrashesPerMinute = 5;
+
+    bool isAvailable() const { return m_available.loadAcquire() != 0; }
+
+    // 可在任意线程调用；done 在本对象所在线程 (GUI 线程) 执行
+    // time 仅对视频有效 (秒)
+    void requestThumbnail(const QString &path, const QSize &maxSize, double time, Callback done);
+
+private:
+    struct Request {
+        quint64 id;
+        QString path;
+        QSize maxSize;
+        double time;
+        Callback done;
+    };
+
+    struct Worker {
+        QProcess *process;
+        QSharedMemory *shm;
+        int shmGeneration;
+        QByteArray buffer;     // 未成行的 stdout 数据
+        Request current;
+        bool busy;
+        QTimer *timeout;
+    };
+
+    void dispatch();
+    bool ensureProcess(int index);
+    bool ensureSegment(int index, qint64 bytes);
+    void onReadyRead(int index);
+    void onReply(int index, const QByteArray &line);
+    void onProcessExit(int index, const QString &reason);
+    void finishCurrent(int index, const Result &result);
+    static void fail(const Request &request, const QString &error, bool unavailable = false);
+
+    QString m_executable;
+    QVector<Worker *> m_workers;
+    QList<Request> m_queue;
+    QSet<QString> m_poisoned;      // 曾导致子进程崩溃/超时的文件
+    QList<qint64> m_crashTimes;
+    QAtomicInt m_available;
+    quint64 m_nextId;
+};
+
+#endif // MEDIAWORKERCLIENT_H
@@ -0,0 +1,27 @@
+#ifndef MEDIAWORKERPROTOCOL_H
+#define MEDIAWORKERPROTOCOL_H
+
+// 主程序与 stv-mediaworker 之间的命令协议 (两端共用)
+//
+// 通过 stdin/stdout 传输，每行一个紧凑 JSON 对象：
+//   请求  {"id":1,"cmd":"thumbnail","path":"/a/b.jpg","maxWidth":240,"maxHeight":110,
+//          "time":1.5,"shm":"<key>","shmSize":105600}
+//   应答  {"id":1,"ok":true,"width":240,"height":96,"bytesPerLine":960,"format":6,"dhash":"..."}
+//         {"id":1,"ok":false,"error":"..."}
+//   请求  {"id":2,"cmd":"ping"}           应答 {"id":2,"ok":true,"pid":1234}
+//
+// 像素不走管道：主程序预先创建共享内存段 (QSharedMemory::setKey)，
+// 辅助进程 attach 后写入紧密排列的 ARGB32_Premultiplied 像素，主程序读取后复用该段。
+// "time" 仅对视频有效 (秒)，辅助进程调用 ffmpeg 抽取该时刻的一帧。
+namespace MediaWorkerProtocol
+{
+    const char *const ExecutableName = "stv-mediaworker";
+
+    const char *const CmdThumbnail = "thumbnail";
+    const char *const CmdPing = "ping";
+
+    // 每像素字节数 (ARGB32_Premultiplied)
+    const int BytesPerPixel = 4;
+}
+
+#endif // MEDIAWORKERPROTOCOL_H
@@ -0,0 +1,250 @@
+#include "metrics.h"
+#include "localhttp.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QHostAddress>
+#include <QMutexLocker>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QDebug>
+#include <cmath>
+
+static const int ConnectionTimeoutMs = 5000;
+
+static QString formatValue(double value)
+{
+    if (std::isinf(value)) {
+        return value > 0 ? QStringLiteral("+Inf") : QStringLiteral("-Inf");
+    }
+    if (std::isnan(value)) {
+        return QStringLiteral("NaN");
+    }
+    return QString::number(value, 'g', 12);
+}
+
+// {a="x",le="0.5"} 形式的标签块；labels 为空时省略花括号
+static QString labelBlock(const QString &labels, const QString &extra = QString())
+{
+    QString joined = labels;
+    if (!extra.isEmpty()) {
+        joined = joined.isEmpty() ? extra : joined + "," + extra;
+    }
+    return joined.isEmpty() ? QString() : "{" + joined + "}";
+}
+
+
+// --- 1. 直方图 ---
+MetricHistogram::MetricHistogram(const QVector<double> &bounds)
+    : m_bounds(bounds)
+{
+    m_buckets = new std::atomic<quint64>[m_bounds.size() + 1];
+    for (int i = 0; i <= m_bounds.size(); ++i) {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricHistogram::~MetricHistogram()
+{
+    delete[] m_buckets;
+}
+
+void MetricHistogram::observe(double value)
+{
+    int i = 0;
+    while (i < m_bounds.size() && value > m_bounds[i]) {
+        ++i;
+    }
+    m_buckets[i].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    // C++20 之前没有 atomic<double>::fetch_add，用 CAS 循环
+    double sum = m_sum.load(std::memory_order_relaxed);
+    while (!m_sum.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {
+    }
+}
+
+quint64 MetricHistogram::cumulativeCount(int i) const
+{
+    quint64 total = 0;
+    for (int k = 0; k <= i && k <= m_bounds.size(); ++k) {
+        total += m_buckets[k].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+
+// --- 2. 注册表 ---
+Metrics::Metrics(QObject *parent)
+    : QObject(parent), m_server(nullptr)
+{
+    const qint64 startedAt = QDateTime::currentSecsSinceEpoch();
+    gauge("stv_process_start_time_seconds", "Unix time the client process started.", this,
+          [startedAt]() { return double(startedAt); });
+}
+
+Metrics::~Metrics()
+{
+    for (Family &family : m_families) {
+        qDeleteAll(family.counters);
+        qDeleteAll(family.histograms);
+    }
+}
+
+Metrics *Metrics::instance()
+{
+    static Metrics *s_instance = new Metrics(QCoreApplication::instance());
+    return s_instance;
+}
+
+QVector<double> Metrics::requestBuckets()
+{
+    return {0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+}
+
+QVector<double> Metrics::taskBuckets()
+{
+    return {1, 2, 5, 10, 20, 30, 60, 120, 300, 600, 1800};
+}
+
+QVector<double> Metrics::downloadBuckets()
+{
+    return {0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 120};
+}
+
+QString Metrics::label(const QString &key, const QString &value)
+{
+    QString escaped = value;
+    escaped.replace("\\", "\\\\").replace("\"", "\\\"").replace("\n", "\\n");
+    return QString("%1=\"%2\"").arg(key, escaped);
+}
+
+Metrics::Family &Metrics::family(const QString &name, const QString &help, const QString &type)
+{
+    auto it = m_families.find(name);
+    if (it == m_families.end()) {
+        Family family;
+        family.help = help;
+        family.type = type;
+        it = m_families.insert(name, family);
+    } else if (it->type != type) {
+        qDebug() << "Metrics: 指标" << name << "重复注册为不同类型" << it->type << type;
+    }
+    return it.value();
+}
+
+MetricCounter *Metrics::counter(const QString &name, const QString &help, const QString &labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Family &f = family(name, help, "counter");
+    MetricCounter *&counter = f.counters[labels];
+    if (!counter) {
+        counter = new MetricCounter;
+    }
+    return counter;
+}
+
+MetricHistogram *Metrics::histogram(const QString &name, const QString &help, const QVector<double> &bounds,
+                                    const QString &labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Family &f = family(name, help, "histogram");
+    MetricHistogram *&histogram = f.histograms[labels];
+    if (!histogram) {
+        histogram = new MetricHistogram(bounds);
+    }
+    return histogram;
+}
+
+void Metrics::gauge(const QString &name, const QString &help, QObject *context, std::function<double()> read,
+                    const QString &labels)
+{
+    QMutexLocker locker(&m_mutex);
+    Family &f = family(name, help, "gauge");
+    Gauge gauge;
+    gauge.context = context;
+    gauge.read = read;
+    f.gauges.insert(labels, gauge);
+}
+
+
+// --- 3. 文本格式输出 ---
+QByteArray Metrics::exposition()
+{
+    // gauge 回调可能访问 GUI 对象，先在锁外复制出来再求值
+    QMap<QString, Family> families;
+    {
+        QMutexLocker locker(&m_mutex);
+        families = m_families;
+    }
+
+    QString out;
+    for (auto it = families.constBegin(); it != families.constEnd(); ++it) {
+        const QString &name = it.key();
+        const Family &f = it.value();
+
+        QString samples;
+        for (auto c = f.counters.constBegin(); c != f.counters.constEnd(); ++c) {
+            samples += name + labelBlock(c.key()) + " " + QString::number(c.value()->value()) + "\n";
+        }
+        for (auto h = f.histograms.constBegin(); h != f.histograms.constEnd(); ++h) {
+            const MetricHistogram *histogram = h.value();
+            const QVector<double> &bounds = histogram->bounds();
+            for (int i = 0; i <= bounds.size(); ++i) {
+                const QString le = i < bounds.size() ? formatValue(bounds[i]) : QStringLiteral("+Inf");
+                samples += name + "_bucket" + labelBlock(h.key(), label("le", le)) + " "
+                        + QString::number(histogram->cumulativeCount(i)) + "\n";
+            }
+            samples += name + "_sum" + labelBlock(h.key()) + " " + formatValue(histogram->sum()) + "\n";
+            samples += name + "_count" + labelBlock(h.key()) + " " + QString::number(histogram->count()) + "\n";
+        }
+        for (auto g = f.gauges.constBegin(); g != f.gauges.constEnd(); ++g) {
+            if (!g.value().context) {
+                continue;
+            }
+            samples += name + labelBlock(g.key()) + " " + formatValue(g.value().read()) + "\n";
+        }
+        if (samples.isEmpty()) {
+            continue;
+        }
+
+        out += "# HELP " + name + " " + f.help + "\n";
+        out += "# TYPE " + name + " " + f.type + "\n";
+        out += samples;
+    }
+    return out.toUtf8();
+}
+
+
+// --- 4. 本机 HTTP 端点 ---
+bool Metrics::startServerFromEnvironment()
+{
+    bool ok = false;
+    const int port = qEnvironmentVariableIntValue("STV_METRICS_PORT", &ok);
+    if (!ok || port <= 0 || port > 65535 || m_server) {
+        return false;
+    }
+
+    QTcpServer *server = new QTcpServer(this);
+    // 只监听回环地址，不对局域网暴露
+    if (!server->listen(QHostAddress::LocalHost, quint16(port))) {
+        qDebug() << "Metrics: 无法监听端口" << port << server->errorString();
+        delete server;
+        return false;
+    }
+    LocalHttp::serve(server, this, ConnectionTimeoutMs, [this](QTcpSocket *socket, const QByteArray &method, const QByteArray &path) {
+        handleRequest(socket, method, path);
+    });
+    m_server = server;
+    qDebug() << "Metrics: 指标端点 http://127.0.0.1:" << port << "/metrics";
+    return true;
+}
+
+void Metrics::handleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &path)
+{
+    if (method != "GET" && method != "HEAD") {
+        LocalHttp::respond(socket, method, "405 Method Not Allowed", "text/plain; charset=utf-8", "method not allowed\n");
+    } else if (path != "/metrics") {
+        LocalHttp::respond(socket, method, "404 Not Found", "text/plain; charset=utf-8", "see /metrics\n");
+    } else {
+        LocalHttp::respond(socket, method, "200 OK", "text/plain; version=0.0.4; charset=utf-8", exposition());
+    }
+}
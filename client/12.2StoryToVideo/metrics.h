@@ -0,0 +1,108 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QObject>
+#include <QMap>
+#include <QMutex>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <functional>
+
+class QTcpServer;
+class QTcpSocket;
+
+// 单调递增计数器；inc() 只是一次 relaxed 原子加，可在任意线程调用
+class MetricCounter
+{
+public:
+    void inc(quint64 n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    quint64 value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<quint64> m_value{0};
+};
+
+// 固定桶直方图 (单位秒)；observe() 可在任意线程调用
+class MetricHistogram
+{
+public:
+    explicit MetricHistogram(const QVector<double> &bounds);
+    ~MetricHistogram();
+
+    void observe(double value);
+
+    const QVector<double> &bounds() const { return m_bounds; }
+    // 累计到第 i 个上界 (含) 的样本数；i == bounds().size() 表示 +Inf
+    quint64 cumulativeCount(int i) const;
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    double sum() const { return m_sum.load(std::memory_order_relaxed); }
+
+private:
+    QVector<double> m_bounds;
+    std::atomic<quint64> *m_buckets;   // bounds().size() + 1 个，非累计
+    std::atomic<quint64> m_count{0};
+    std::atomic<double> m_sum{0};
+};
+
+// 进程内指标注册表 + 可选的本机 HTTP 导出端点 (Prometheus 文本格式)
+// - 计数器/直方图在第一次使用时注册，之后调用方缓存返回的指针，记录时只有原子操作
+// - gauge 只注册读取回调，抓取时才在 GUI 线程求值；没人抓取时没有任何开销
+// - 设置环境变量 STV_METRICS_PORT 后才会监听 127.0.0.1:<port>/metrics
+class Metrics : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Metrics(QObject *parent = nullptr);
+    ~Metrics();
+
+    // 进程级共享实例，需在 GUI 线程首次调用
+    static Metrics *instance();
+
+    // 常用的桶上界 (秒)
+    static QVector<double> requestBuckets();   // HTTP 请求: 5ms .. 10s
+    static QVector<double> taskBuckets();      // 生成任务: 1s .. 30min
+    static QVector<double> downloadBuckets();  // 媒体下载: 100ms .. 2min
+
+    // 生成一个转义后的 key="value" 标签；多个标签用 ',' 连接后传入
+    static QString label(const QString &key, const QString &value);
+
+    // 同名同标签重复调用返回同一对象，指针在进程生命周期内有效
+    MetricCounter *counter(const QString &name, const QString &help, const QString &labels = QString());
+    MetricHistogram *histogram(const QString &name, const QString &help, const QVector<double> &bounds,
+                               const QString &labels = QString());
+    // read 在抓取时于 GUI 线程调用；context 销毁后该 gauge 不再输出
+    void gauge(const QString &name, const QString &help, QObject *context, std::function<double()> read,
+               const QString &labels = QString());
+
+    // 当前所有指标的文本格式输出 (需在 GUI 线程调用)
+    QByteArray exposition();
+
+    // 读取 STV_METRICS_PORT 并开始监听；未设置时什么也不做
+    bool startServerFromEnvironment();
+    bool isServing() const { return m_server != nullptr; }
+
+private:
+    struct Gauge {
+        QPointer<QObject> context;
+        std::function<double()> read;
+    };
+
+    struct Family {
+        QString help;
+        QString type;                              // counter / histogram / gauge
+        QMap<QString, MetricCounter *> counters;   // labels -> 指标
+        QMap<QString, MetricHistogram *> histograms;
+        QMap<QString, Gauge> gauges;
+    };
+
+    Family &family(const QString &name, const QString &help, const QString &type);
+    void handleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &path);
+
+    QMutex m_mutex;
+    QMap<QString, Family> m_families;
+    QTcpServer *m_server;
+};
+
+#endif // METRICS_H
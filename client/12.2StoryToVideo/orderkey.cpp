@@ -0,0 +1,309 @@
+#include "orderkey.h"
+#include "commandline.h"
+#include "datamanager.h"
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QVariantMap>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char Digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+const int Base = 62;
+
+int digitOf(QChar c)
+{
+    const char *p = c.unicode() < 128 ? std::strchr(Digits, char(c.unicode())) : nullptr;
+    return (p && *p) ? int(p - Digits) : -1;
+}
+
+bool isValidKey(const QString &key)
+{
+    if (key.isEmpty() || key.endsWith('0')) {
+        return false;
+    }
+    for (const QChar c : key) {
+        if (digitOf(c) < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a < 结果 < b；a 为空表示下界 (视为全 '0')，b 为空表示上界
+QString midpoint(const QString &a, const QString &b)
+{
+    if (!b.isEmpty()) {
+        // 公共前缀 (a 较短时按 '0' 补齐) 原样保留，在其后继续取中点
+        int n = 0;
+        while (n < b.size() && (n < a.size() ? a.at(n) : QChar('0')) == b.at(n)) {
+            ++n;
+        }
+        if (n > 0) {
+            return b.left(n) + midpoint(a.mid(n), b.mid(n));
+        }
+    }
+
+    const int digitA = a.isEmpty() ? 0 : digitOf(a.at(0));
+    const int digitB = b.isEmpty() ? Base : digitOf(b.at(0));
+    if (digitB - digitA > 1) {
+        return QString(QChar(Digits[(digitA + digitB + 1) / 2]));
+    }
+    // 首位相邻：b 更长时它的首位本身就在两者之间 (b 不以 '0' 结尾)；否则沿用 a 的首位，在下一位上取中点
+    if (b.size() > 1) {
+        return b.left(1);
+    }
+    return QChar(Digits[digitA]) + midpoint(a.mid(1), QString());
+}
+
+} // namespace
+
+
+// --- 1. 生成键 ---
+QString OrderKey::between(const QString &before, const QString &after)
+{
+    if ((!before.isEmpty() && !isValidKey(before)) || (!after.isEmpty() && !isValidKey(after))
+            || (!before.isEmpty() && !after.isEmpty() && before >= after)) {
+        qDebug() << "OrderKey: 无效的区间" << before << after;
+        return QString();
+    }
+    return midpoint(before, after);
+}
+
+QStringList OrderKey::spread(int count)
+{
+    QStringList keys;
+    if (count <= 0) {
+        return keys;
+    }
+    // 选最短的等长键，使相邻键之间至少留出 Base 个空位
+    int length = 1;
+    qint64 capacity = Base;
+    while (capacity < qint64(count + 1) * Base) {
+        capacity *= Base;
+        ++length;
+    }
+
+    keys.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        qint64 value = capacity * (i + 1) / (count + 1);
+        QString key(length, QChar('0'));
+        for (int pos = length - 1; pos >= 0; --pos) {
+            key[pos] = QChar(Digits[value % Base]);
+            value /= Base;
+        }
+        // 去掉末尾的 '0' 不改变与其他等长键的先后顺序
+        while (key.endsWith('0')) {
+            key.chop(1);
+        }
+        keys.append(key);
+    }
+    return keys;
+}
+
+bool OrderKey::normalize(QVariantList *shots)
+{
+    bool missing = false;
+    QVector<QPair<QString, int>> keyed;
+    QVector<QPair<int, int>> numbered;
+    keyed.reserve(shots->size());
+    numbered.reserve(shots->size());
+    for (int i = 0; i < shots->size(); ++i) {
+        const QVariantMap shot = shots->at(i).toMap();
+        const QString key = shot.value("orderKey").toString();
+        missing = missing || key.isEmpty();
+        keyed.append(qMakePair(key, i));
+        numbered.append(qMakePair(shot.value("order", shot.value("shotOrder")).toInt(), i));
+    }
+
+    QVector<int> sorted;
+    sorted.reserve(shots->size());
+    if (missing) {
+        std::stable_sort(numbered.begin(), numbered.end(), [](const QPair<int, int> &a, const QPair<int, int> &b) {
+            return a.first < b.first;
+        });
+        for (const auto &entry : numbered) {
+            sorted.append(entry.second);
+        }
+    } else {
+        std::stable_sort(keyed.begin(), keyed.end(), [](const QPair<QString, int> &a, const QPair<QString, int> &b) {
+            return a.first < b.first;
+        });
+        for (const auto &entry : keyed) {
+            sorted.append(entry.second);
+        }
+    }
+
+    const QStringList keys = missing ? spread(shots->size()) : QStringList();
+    QVariantList result;
+    result.reserve(shots->size());
+    for (int i = 0; i < sorted.size(); ++i) {
+        if (missing) {
+            QVariantMap shot = shots->at(sorted[i]).toMap();
+            shot["orderKey"] = keys[i];
+            result.append(shot);
+        } else {
+            result.append(shots->at(sorted[i]));
+        }
+    }
+    *shots = result;
+    return missing;
+}
+
+
+// --- 2. 基准 ---
+bool OrderKey::runFromArguments(const QStringList &arguments, int *exitCode)
+{
+    const CommandLine::Options options = CommandLine::parse(arguments);
+    if (!options.contains("--order-bench")) {
+        return false;
+    }
+    *exitCode = runBenchmark(CommandLine::intValue(options, "--order-bench", 1000, 10), 500);
+    return true;
+}
+
+int OrderKey::runBenchmark(int shotCount, int moves)
+{
+    QTemporaryDir temp;
+    if (!temp.isValid()) {
+        qDebug() << "OrderKey: 无法创建临时目录";
+        return 2;
+    }
+    DataManager dataManager;
+    dataManager.setStorageDirectory(temp.path());
+    const QString numberedFile = "project_numbered.json";
+    const QString keyedFile = "project_keyed.json";
+
+    QVariantList shots;
+    for (int i = 0; i < shotCount; ++i) {
+        QVariantMap shot;
+        shot["id"] = QString("shot_%1").arg(i);
+        shot["order"] = i + 1;
+        shot["title"] = QString("分镜 %1").arg(i + 1);
+        shot["description"] = QString("A cinematic wide shot of scene %1, golden hour, soft rim light").arg(i);
+        shot["prompt"] = QString("cinematic scene %1, 35mm, shallow depth of field, volumetric light").arg(i);
+        shot["imageUrl"] = QString("http://localhost:8000/static/shots/shot_%1.png").arg(i);
+        shots.append(shot);
+    }
+    QVariantMap project;
+    project["id"] = "bench";
+    project["shots"] = shots;
+    if (!dataManager.saveData(project, numberedFile)) {
+        qDebug() << "OrderKey: 基准数据写入失败";
+        return 2;
+    }
+
+    QHash<QString, QVariantMap> shotById;
+    for (const QVariant &varShot : shots) {
+        shotById.insert(varShot.toMap().value("id").toString(), varShot.toMap());
+    }
+    QVariantList keyedShots = shots;
+    normalize(&keyedShots);
+    QVariantMap keyedProject = project;
+    keyedProject["shots"] = keyedShots;
+    dataManager.saveData(keyedProject, keyedFile);
+
+    // 两种方式共用同一串移动：一半随机，一半总是移到第 2 位 (同一位置反复插入，键增长最快)
+    QStringList ids;
+    QStringList keys;
+    for (const QVariant &varShot : keyedShots) {
+        ids.append(varShot.toMap().value("id").toString());
+        keys.append(varShot.toMap().value("orderKey").toString());
+    }
+    QStringList numberedIds = ids;
+    QRandomGenerator random(20240601);
+
+    qint64 numberedNs = 0;
+    qint64 keyedNs = 0;
+    qint64 numberedRecords = 0;
+    qint64 keyedRecords = 0;
+    int rebalances = 0;
+    int longestKey = 0;
+    QElapsedTimer timer;
+
+    for (int move = 0; move < moves; ++move) {
+        const int from = random.bounded(shotCount);
+        int to = move % 2 == 0 ? random.bounded(shotCount) : 1;
+        if (to == from) {
+            to = (from + 1) % shotCount;
+        }
+
+        // (a) 整数编号：移动后区间内的分镜全部重新编号，整个项目文件重写
+        timer.start();
+        numberedIds.move(from, to);
+        QHash<QString, int> numberedById;
+        for (int i = qMin(from, to); i <= qMax(from, to); ++i) {
+            numberedById.insert(numberedIds[i], i + 1);
+        }
+        for (QVariant &varShot : shots) {
+            QVariantMap shot = varShot.toMap();
+            const QString id = shot.value("id").toString();
+            if (numberedById.contains(id)) {
+                shot["order"] = numberedById.value(id);
+                varShot = shot;
+            }
+        }
+        project["shots"] = shots;
+        dataManager.saveData(project, numberedFile);
+        numberedNs += timer.nsecsElapsed();
+        numberedRecords += numberedById.size();
+
+        // (b) 排序键：只为被移动的分镜取一个新键，追加一行日志；键过长时整体重排并保存
+        timer.start();
+        const QString id = ids.takeAt(from);
+        keys.removeAt(from);
+        const QString key = between(to > 0 ? keys[to - 1] : QString(), to < keys.size() ? keys[to] : QString());
+        ids.insert(to, id);
+        keys.insert(to, key);
+        if (needsRebalance(key)) {
+            keys = spread(shotCount);
+            QVariantList rebalanced;
+            for (int i = 0; i < shotCount; ++i) {
+                QVariantMap shot = shotById.value(ids[i]);
+                shot["orderKey"] = keys[i];
+                rebalanced.append(shot);
+            }
+            keyedProject["shots"] = rebalanced;
+            dataManager.saveData(keyedProject, keyedFile);
+            keyedRecords += shotCount;
+            ++rebalances;
+        } else {
+            longestKey = qMax(longestKey, key.size());
+            dataManager.saveShotOrder(keyedFile, id, key);
+            keyedRecords += 1;
+        }
+        keyedNs += timer.nsecsElapsed();
+    }
+
+    // 重新加载两份文件，核对最终顺序
+    timer.start();
+    const QVariantList loadedKeyed = dataManager.loadData(keyedFile).value("shots").toList();
+    const qint64 loadNs = timer.nsecsElapsed();
+    QVariantList loadedNumbered = dataManager.loadData(numberedFile).value("shots").toList();
+    bool identical = loadedKeyed.size() == shotCount && loadedNumbered.size() == shotCount;
+    for (int i = 0; identical && i < shotCount; ++i) {
+        identical = loadedKeyed[i].toMap().value("id") == numberedIds[i]
+                && loadedNumbered[i].toMap().value("id") == numberedIds[i];
+    }
+
+    const qint64 journalBytes = QFileInfo(temp.path() + "/" + keyedFile + ".order").size();
+    qDebug().noquote() << QString("OrderKey: %1 个分镜，移动 %2 次 (一半集中在同一位置)").arg(shotCount).arg(moves);
+    qDebug().noquote() << QString("OrderKey: 整数编号  每次移动平均改写 %1 条记录，%2 ms")
+                          .arg(double(numberedRecords) / moves, 0, 'f', 1)
+                          .arg(numberedNs / 1e6 / moves, 0, 'f', 3);
+    qDebug().noquote() << QString("OrderKey: 排序键    每次移动平均改写 %1 条记录，%2 ms；重排 %3 次，最长键 %4 字符，日志 %5 字节，加载合并 %6 ms")
+                          .arg(double(keyedRecords) / moves, 0, 'f', 1)
+                          .arg(keyedNs / 1e6 / moves, 0, 'f', 3)
+                          .arg(rebalances)
+                          .arg(longestKey)
+                          .arg(journalBytes)
+                          .arg(loadNs / 1e6, 0, 'f', 2);
+    qDebug().noquote() << QString("OrderKey: 两种方式的最终顺序%1").arg(identical ? "一致" : "不一致");
+    return identical ? 0 : 1;
+}
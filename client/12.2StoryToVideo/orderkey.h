@@ -0,0 +1,42 @@
+#ifndef ORDERKEY_H
+#define ORDERKEY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+
+// 分镜排序键 (分数索引)：用可比较的字符串代替整数 order。
+// 在两个键之间总能生成新键，移动/插入一个分镜只需要改写这一条记录，不必给后面的分镜重新编号。
+// 键由 base62 字符组成 ('0'-'9' < 'A'-'Z' < 'a'-'z'，与 QString 比较顺序一致)，且不以 '0' 结尾，
+// 因此任何键的下方都还有空间。反复在同一位置插入时键会逐渐变长，超过 MaxLength 后由调用方整体重排 (很少发生)。
+//
+// 基准：
+//   ./StoryToVideoGenerator --order-bench[=N]     N 个分镜的项目上比较 "重新编号" 与 "排序键" 的移动开销 (默认 1000)
+class OrderKey
+{
+public:
+    // 超过该长度即应重排 (spread)。1000 个分镜重排后键长 3；同一位置反复插入约每 6 次增长 1 个字符
+    static const int MaxLength = 32;
+
+    // before < 结果 < after；空字符串表示开区间 (列表头/尾)
+    static QString between(const QString &before, const QString &after);
+
+    // count 个等长、均匀分布的键，相邻键之间约留 62 个空位
+    static QStringList spread(int count);
+
+    // between() 对无效区间返回空字符串，同样需要重排
+    static bool needsRebalance(const QString &key) { return key.isEmpty() || key.size() > MaxLength; }
+
+    // 分镜列表 (QVariantMap，键 "orderKey") 按排序键排序；有分镜缺少排序键 (旧数据/服务端只给整数 order) 时
+    // 按整数 order 排好后整体分配。返回 true 表示分配了新键，调用方需要整体保存一次
+    static bool normalize(QVariantList *shots);
+
+    // 处理 --order-bench；返回 false 表示不是该命令
+    static bool runFromArguments(const QStringList &arguments, int *exitCode);
+
+    // 在 shotCount 个分镜的项目上随机移动 moves 次，分别用整数编号 (每次整体保存) 与排序键 (只追加一条记录)，
+    // 打印每次移动改写的记录数与耗时，并核对两种方式得到的最终顺序一致
+    static int runBenchmark(int shotCount, int moves);
+};
+
+#endif // ORDERKEY_H
@@ -0,0 +1,234 @@
+#include "pagepreloader.h"
+#include "metrics.h"
+#include <QFileInfo>
+#include <QQmlComponent>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QQmlIncubator>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QTimer>
+#include <QDebug>
+
+// 在每帧剩余的空闲时间里推进创建 (由窗口的 incubation controller 驱动)，结束后通知 PagePreloader
+class PageIncubator : public QQmlIncubator
+{
+public:
+    PageIncubator(PagePreloader *owner, const QUrl &url)
+        : QQmlIncubator(QQmlIncubator::Asynchronous), m_owner(owner), m_url(url)
+    {
+    }
+
+protected:
+    void statusChanged(Status status) override
+    {
+        if (status != Ready && status != Error) {
+            return;
+        }
+        // 回调里不能 clear() incubator，回到事件循环再取结果
+        PagePreloader *owner = m_owner;
+        const QUrl url = m_url;
+        QMetaObject::invokeMethod(owner, [owner, url]() { owner->incubationFinished(url); }, Qt::QueuedConnection);
+    }
+
+private:
+    PagePreloader *m_owner;
+    QUrl m_url;
+};
+
+
+PagePreloader::PagePreloader(QQmlEngine *engine, QObject *parent)
+    : QObject(parent)
+    , m_engine(engine)
+    , m_enabled(qEnvironmentVariable("STV_PAGE_PRELOAD") != "0")
+    , m_pushState(0)
+    , m_pushStartNs(0)
+    , m_pushPreloaded(false)
+{
+    m_clock.start();
+    if (!m_enabled) {
+        qDebug() << "PagePreloader: 已关闭 (STV_PAGE_PRELOAD=0)，页面在 push 时现场创建";
+    }
+}
+
+PagePreloader::~PagePreloader()
+{
+    for (Slot &slot : m_slots) {
+        delete slot.ready.data();
+        delete slot.incubator;   // 会中止进行中的创建
+    }
+}
+
+void PagePreloader::setWindow(QQuickWindow *window)
+{
+    m_window = window;
+    if (!window) {
+        return;
+    }
+    // 没有 incubation controller 时异步创建不会推进 (或退化为同步)
+    if (!m_engine->incubationController()) {
+        m_engine->setIncubationController(window->incubationController());
+    }
+
+    // 以下两个回调在渲染线程 (threaded render loop) 上执行，只读写原子变量
+    connect(window, &QQuickWindow::afterSynchronizing, this, [this]() {
+        m_pushState.testAndSetOrdered(1, 2);
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+        if (m_pushState.testAndSetOrdered(2, 0)) {
+            const qint64 nanoseconds = m_clock.nsecsElapsed() - m_pushStartNs.loadAcquire();
+            QMetaObject::invokeMethod(this, [this, nanoseconds]() { recordPushLatency(nanoseconds); },
+                                      Qt::QueuedConnection);
+        }
+    }, Qt::DirectConnection);
+}
+
+
+// --- 1. 预创建 ---
+void PagePreloader::preload(const QUrl &url)
+{
+    if (!m_enabled || url.isEmpty()) {
+        return;
+    }
+    // 等发起请求的页面先完成首帧，避免与正在进行的 push 争用 GUI 线程
+    QTimer::singleShot(IdleDelayMs, this, [this, url]() { startIncubation(url); });
+}
+
+void PagePreloader::startIncubation(const QUrl &url)
+{
+    Slot &slot = m_slots[url];
+    if (!slot.component) {
+        slot.component = new QQmlComponent(m_engine, url, QQmlComponent::Asynchronous, this);
+        slot.incubator = new PageIncubator(this, url);
+        connect(slot.component, &QQmlComponent::statusChanged, this, [this, url](QQmlComponent::Status status) {
+            if (status == QQmlComponent::Ready) {
+                startIncubation(url);
+            }
+        });
+    }
+    if (slot.component->isLoading()) {
+        return;
+    }
+    if (slot.component->isError()) {
+        qDebug() << "PagePreloader: 组件加载失败" << url << slot.component->errorString();
+        return;
+    }
+    if (slot.ready || !slot.incubator->isNull()) {
+        return;   // 已有现成实例，或正在创建
+    }
+    // 必须在 main.qml 根对象的上下文里创建：页面通过 id 访问 pageStack 等对象，
+    // 根上下文 (rootContext) 里看不到这些 id
+    QQmlContext *context = m_window ? qmlContext(m_window) : nullptr;
+    if (!context) {
+        return;   // 窗口就绪前不预创建，page() 退回现场创建
+    }
+    slot.startedMs = m_clock.elapsed();
+    slot.component->create(*slot.incubator, context);
+}
+
+void PagePreloader::incubationFinished(const QUrl &url)
+{
+    auto it = m_slots.find(url);
+    if (it == m_slots.end() || !it->incubator) {
+        return;
+    }
+    PageIncubator *incubator = it->incubator;
+    if (incubator->isError()) {
+        qDebug() << "PagePreloader: 创建失败" << url << incubator->errors();
+        incubator->clear();
+        return;
+    }
+    if (!incubator->isReady()) {
+        return;
+    }
+
+    QObject *object = incubator->object();
+    incubator->clear();   // Ready 状态下 clear() 不会删除对象
+    QQuickItem *item = qobject_cast<QQuickItem *>(object);
+    if (!item || it->ready) {
+        delete object;
+        return;
+    }
+    // 实例会经 page() 交给 QML，不能让 JS 垃圾回收删掉
+    QQmlEngine::setObjectOwnership(item, QQmlEngine::CppOwnership);
+    it->ready = item;
+    qDebug() << "PagePreloader: 已预创建" << QFileInfo(url.path()).fileName()
+             << "耗时" << m_clock.elapsed() - it->startedMs << "ms (分摊在空闲帧里)";
+}
+
+
+// --- 2. 取用与回收 ---
+QVariant PagePreloader::page(const QUrl &url)
+{
+    auto it = m_slots.find(url);
+    QQuickItem *item = it != m_slots.end() ? it->ready.data() : nullptr;
+    beginPushMeasurement(url, item != nullptr);
+    if (!item) {
+        preload(url);   // 这次现场创建，下次就有现成的
+        return QVariant::fromValue(url);
+    }
+
+    it->ready = nullptr;
+    m_inUse.insert(item, url);
+    // 用完即销毁的页面在空闲时预创建下一个；可复用的页面出栈后自己回到池里
+    if (item->metaObject()->indexOfMethod("resetForReuse()") < 0) {
+        preload(url);
+    }
+    return QVariant::fromValue<QObject *>(item);
+}
+
+void PagePreloader::release(QObject *page)
+{
+    QQuickItem *item = qobject_cast<QQuickItem *>(page);
+    if (!item || !m_inUse.contains(item)) {
+        return;   // StackView 自己创建的页面由它负责销毁
+    }
+    const QUrl url = m_inUse.take(item);
+    // StackView 发出 removed 之后才恢复页面原来的父项，回到事件循环再处理
+    QPointer<QQuickItem> guard(item);
+    QTimer::singleShot(0, this, [this, guard, url]() {
+        if (guard) {
+            recycle(guard, url);
+        }
+    });
+}
+
+void PagePreloader::recycle(QQuickItem *item, const QUrl &url)
+{
+    Slot &slot = m_slots[url];
+    const bool reusable = item->metaObject()->indexOfMethod("resetForReuse()") >= 0;
+    if (!reusable || slot.ready) {
+        item->deleteLater();
+        return;
+    }
+    // 清空页面状态，保留 MediaPlayer/VideoOutput 等对象供下次使用
+    QMetaObject::invokeMethod(item, "resetForReuse");
+    item->setParentItem(nullptr);
+    slot.ready = item;
+    qDebug() << "PagePreloader: 回收" << QFileInfo(url.path()).fileName() << "到池中";
+}
+
+
+// --- 3. push 到首帧耗时 ---
+void PagePreloader::beginPushMeasurement(const QUrl &url, bool preloaded)
+{
+    if (!m_window) {
+        return;
+    }
+    m_pushPage = QFileInfo(url.path()).baseName();
+    m_pushPreloaded = preloaded;
+    m_pushStartNs.storeRelease(m_clock.nsecsElapsed());
+    m_pushState.storeRelease(1);
+}
+
+void PagePreloader::recordPushLatency(qint64 nanoseconds)
+{
+    const double milliseconds = nanoseconds / 1000000.0;
+    qDebug() << "PagePreloader:" << m_pushPage << (m_pushPreloaded ? "(预创建)" : "(现场创建)")
+             << "push 到首帧" << milliseconds << "ms";
+    Metrics::instance()->histogram("stv_page_push_seconds",
+                                   "Latency from StackView push to the first swapped frame, by page and whether it was pre-incubated.",
+                                   Metrics::requestBuckets(),
+                                   Metrics::label("page", m_pushPage) + "," + Metrics::label("preloaded", m_pushPreloaded ? "true" : "false"))
+            ->observe(milliseconds / 1000.0);
+}
@@ -0,0 +1,80 @@
+#ifndef PAGEPRELOADER_H
+#define PAGEPRELOADER_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QUrl>
+#include <QVariant>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+
+#include <QQuickItem>
+
+class QQmlEngine;
+class QQmlComponent;
+class QQuickWindow;
+class PageIncubator;
+
+// 页面预创建：用 QQmlIncubator 在空闲时异步创建 "下一步可能打开" 的页面 (PreviewPage、ShotDetailPage)，
+// 点击时直接把现成的实例交给 StackView，不在 GUI 线程上同步编译/实例化 MediaPlayer、VideoOutput。
+// 定义了 resetForReuse() 的页面 (PreviewPage) 出栈后回收到池里复用，保留其媒体对象；其他页面用完即销毁，
+// 并在空闲时预创建下一个。
+//
+// QML 用法：
+//   pagePreloader.preload(Qt.resolvedUrl("PreviewPage.qml"))          // 页面加载完后登记
+//   pageStack.push(pagePreloader.page(Qt.resolvedUrl("PreviewPage.qml")), { ... })
+//   StackView.onRemoved: pagePreloader.release(previewPage)          // 被预创建的页面里
+//
+// 每次 page() 都会测量 "push 到第一帧" 的耗时 (stv_page_push_seconds{page,preloaded})；
+// STV_PAGE_PRELOAD=0 关闭预创建，用于对比。
+class PagePreloader : public QObject
+{
+    Q_OBJECT
+public:
+    static const int IdleDelayMs = 300;   // 请求预创建后等当前页面的首帧过去再开始
+
+    explicit PagePreloader(QQmlEngine *engine, QObject *parent = nullptr);
+    ~PagePreloader();
+
+    // 用于测量 push 到第一帧的耗时，并在 engine 没有 incubation controller 时安装窗口的；
+    // 页面在窗口 (main.qml 根对象) 的上下文里创建，与 StackView 用 URL 现场创建时可见的 id 一致
+    void setWindow(QQuickWindow *window);
+
+    Q_INVOKABLE void preload(const QUrl &url);
+    // 有现成实例时返回实例 (QObject*)，否则原样返回 url，两者都可以直接交给 StackView.push
+    Q_INVOKABLE QVariant page(const QUrl &url);
+    // 页面出栈后调用；不是本类创建的实例时忽略
+    Q_INVOKABLE void release(QObject *page);
+
+private:
+    struct Slot {
+        QQmlComponent *component = nullptr;
+        PageIncubator *incubator = nullptr;
+        QPointer<QQuickItem> ready;        // 已创建、等待使用的实例
+        qint64 startedMs = 0;
+    };
+
+    friend class PageIncubator;
+    void startIncubation(const QUrl &url);
+    void incubationFinished(const QUrl &url);
+    void recycle(QQuickItem *item, const QUrl &url);
+    void beginPushMeasurement(const QUrl &url, bool preloaded);
+    void recordPushLatency(qint64 nanoseconds);
+
+    QQmlEngine *m_engine;
+    bool m_enabled;
+    QHash<QUrl, Slot> m_slots;
+    QHash<QQuickItem *, QUrl> m_inUse;     // 已交给 StackView 的实例 -> 页面 URL
+
+    // push -> 首帧：GUI 线程记录开始时间，渲染线程在包含这次 push 的同步之后的第一次 frameSwapped 结束
+    QPointer<QQuickWindow> m_window;
+    QElapsedTimer m_clock;
+    QAtomicInt m_pushState;                // 0 空闲, 1 已 push 等待同步, 2 已同步等待交换
+    QAtomicInteger<qint64> m_pushStartNs;
+    QString m_pushPage;
+    bool m_pushPreloaded;
+};
+
+#endif // PAGEPRELOADER_H
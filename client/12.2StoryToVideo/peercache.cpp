@@ -0,0 +1,346 @@
+#include "peercache.h"
+#include "localhttp.h"
+#include "mediacache.h"
+#include "metrics.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkDatagram>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QUuid>
+#include <QDebug>
+
+static const int ConnectionTimeoutMs = 10000;
+static const qint64 UploadChunkBytes = 64 * 1024;
+static const qint64 UploadBufferBytes = 256 * 1024;   // 发送缓冲低于该值时再读下一块
+static const char BeaconMagic[] = "stv-peer";
+
+PeerCache::PeerCache(MediaCache *cache, QObject *parent)
+    : QObject(parent),
+      m_cache(cache),
+      m_instanceId(QUuid::createUuid().toString(QUuid::WithoutBraces)),
+      m_discoveryPort(DefaultDiscoveryPort),
+      m_generation(0),
+      m_uploads(0),
+      m_udp(nullptr),
+      m_server(nullptr),
+      m_beaconTimer(nullptr),
+      m_network(nullptr)
+{
+    // 新文件入库后递增版本号，peer 收到下一个 beacon 时重新拉取索引
+    connect(m_cache, &MediaCache::cached, this, [this]() { ++m_generation; });
+}
+
+PeerCache::~PeerCache()
+{
+}
+
+QString PeerCache::urlKey(const QString &url)
+{
+    return QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex();
+}
+
+
+// --- 1. 启动 ---
+bool PeerCache::startFromEnvironment()
+{
+    const QByteArray value = qgetenv("STV_PEER_CACHE").trimmed();
+    if (value.isEmpty() || value == "0" || m_server) {
+        return false;
+    }
+    bool ok = false;
+    const int port = value.toInt(&ok);
+    if (ok && port > 1 && port <= 65535) {
+        m_discoveryPort = quint16(port);
+    }
+
+    // HTTP 端口由系统分配，同一台机器上可以同时跑多个实例
+    m_server = new QTcpServer(this);
+    if (!m_server->listen(QHostAddress::AnyIPv4, 0)) {
+        qDebug() << "PeerCache: 无法监听 HTTP 端口" << m_server->errorString();
+        delete m_server;
+        m_server = nullptr;
+        return false;
+    }
+    LocalHttp::serve(m_server, this, ConnectionTimeoutMs, [this](QTcpSocket *socket, const QByteArray &method, const QByteArray &path) {
+        handleRequest(socket, method, path);
+    });
+
+    // 共享绑定发现端口：本机多个实例都能收到彼此的广播
+    m_udp = new QUdpSocket(this);
+    if (!m_udp->bind(QHostAddress::AnyIPv4, m_discoveryPort,
+                     QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)) {
+        qDebug() << "PeerCache: 无法绑定发现端口" << m_discoveryPort << m_udp->errorString();
+    }
+    connect(m_udp, &QUdpSocket::readyRead, this, &PeerCache::readBeacons);
+
+    m_network = new QNetworkAccessManager(this);
+
+    m_beaconTimer = new QTimer(this);
+    m_beaconTimer->setInterval(BeaconIntervalMs);
+    connect(m_beaconTimer, &QTimer::timeout, this, [this]() {
+        expirePeers();
+        sendBeacon();
+    });
+    m_beaconTimer->start();
+    sendBeacon();
+
+    Metrics::instance()->gauge("stv_peer_cache_peers", "LAN peers currently advertising their media cache.",
+                               this, [this]() { return double(m_peers.size()); });
+
+    qDebug() << "PeerCache: 已启用，实例" << m_instanceId << "HTTP 端口" << m_server->serverPort()
+             << "发现端口" << m_discoveryPort;
+    return true;
+}
+
+
+// --- 2. 发现 ---
+void PeerCache::sendBeacon()
+{
+    QJsonObject beacon;
+    beacon["app"] = QString::fromLatin1(BeaconMagic);
+    beacon["v"] = 1;
+    beacon["id"] = m_instanceId;
+    beacon["port"] = int(m_server->serverPort());
+    beacon["gen"] = double(m_generation);
+    m_udp->writeDatagram(QJsonDocument(beacon).toJson(QJsonDocument::Compact),
+                         QHostAddress::Broadcast, m_discoveryPort);
+}
+
+void PeerCache::readBeacons()
+{
+    while (m_udp->hasPendingDatagrams()) {
+        const QNetworkDatagram datagram = m_udp->receiveDatagram(4096);
+        const QJsonObject beacon = QJsonDocument::fromJson(datagram.data()).object();
+        if (beacon["app"].toString() != QLatin1String(BeaconMagic) || beacon["v"].toInt() != 1) {
+            continue;
+        }
+        const QString id = beacon["id"].toString();
+        const int port = beacon["port"].toInt();
+        if (id.isEmpty() || id == m_instanceId || port <= 0 || port > 65535) {
+            continue;
+        }
+
+        const bool isNew = !m_peers.contains(id);
+        Peer &peer = m_peers[id];
+        if (isNew) {
+            peer.generation = -1;
+            peer.fetching = false;
+            qDebug() << "PeerCache: 发现 peer" << id << datagram.senderAddress().toString() << port;
+        }
+        peer.address = QHostAddress(datagram.senderAddress().toIPv4Address());
+        peer.port = quint16(port);
+        peer.lastSeen = QDateTime::currentMSecsSinceEpoch();
+
+        if (qint64(beacon["gen"].toDouble()) != peer.generation && !peer.fetching) {
+            fetchIndex(id);
+        }
+    }
+}
+
+void PeerCache::fetchIndex(const QString &peerId)
+{
+    auto it = m_peers.find(peerId);
+    if (it == m_peers.end()) {
+        return;
+    }
+    it->fetching = true;
+
+    QUrl url;
+    url.setScheme("http");
+    url.setHost(it->address.toString());
+    url.setPort(it->port);
+    url.setPath("/index");
+    QNetworkReply *reply = m_network->get(QNetworkRequest(url));
+    QTimer::singleShot(ConnectionTimeoutMs, reply, &QNetworkReply::abort);
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, peerId]() {
+        reply->deleteLater();
+        auto it = m_peers.find(peerId);
+        if (it == m_peers.end()) {
+            return;
+        }
+        it->fetching = false;
+        if (reply->error() != QNetworkReply::NoError) {
+            qDebug() << "PeerCache: 拉取索引失败" << peerId << reply->errorString();
+            return;
+        }
+        const QJsonObject root = QJsonDocument::fromJson(reply->readAll()).object();
+        const QJsonObject entries = root["entries"].toObject();
+        QHash<QString, QByteArray> parsed;
+        for (auto e = entries.constBegin(); e != entries.constEnd(); ++e) {
+            const QByteArray digest = QByteArray::fromHex(e.value().toString().toLatin1());
+            if (digest.size() == 32) {
+                parsed.insert(e.key(), digest);
+            }
+        }
+        it->entries = parsed;
+        it->generation = qint64(root["gen"].toDouble());
+        qDebug() << "PeerCache: peer" << peerId << "提供" << parsed.size() << "个文件";
+    });
+}
+
+void PeerCache::expirePeers()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_peers.begin(); it != m_peers.end();) {
+        if (now - it->lastSeen > PeerTimeoutMs) {
+            qDebug() << "PeerCache: peer 离线" << it.key();
+            it = m_peers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+
+// --- 3. 查找 ---
+QUrl PeerCache::locate(const QString &url, QByteArray *sha256) const
+{
+    if (!isEnabled()) {
+        return QUrl();
+    }
+    const QString key = urlKey(url);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto it = m_peers.constBegin(); it != m_peers.constEnd(); ++it) {
+        if (now - it->lastSeen > PeerTimeoutMs) {
+            continue;
+        }
+        auto entry = it->entries.constFind(key);
+        if (entry == it->entries.constEnd()) {
+            continue;
+        }
+        QUrl source;
+        source.setScheme("http");
+        source.setHost(it->address.toString());
+        source.setPort(it->port);
+        source.setPath("/blobs/" + QString::fromLatin1(entry->toHex()));
+        if (sha256) {
+            *sha256 = entry.value();
+        }
+        return source;
+    }
+    return QUrl();
+}
+
+void PeerCache::reportBadSource(const QUrl &source, const QByteArray &sha256)
+{
+    for (auto it = m_peers.begin(); it != m_peers.end(); ++it) {
+        if (it->address.toString() != source.host() || it->port != source.port()) {
+            continue;
+        }
+        for (auto e = it->entries.begin(); e != it->entries.end();) {
+            if (e.value() == sha256) {
+                e = it->entries.erase(e);
+            } else {
+                ++e;
+            }
+        }
+    }
+}
+
+
+// --- 4. 对 peer 提供文件 ---
+void PeerCache::handleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &path)
+{
+    if (method != "GET" && method != "HEAD") {
+        writeSimple(socket, "405 Method Not Allowed", "method not allowed\n");
+    } else if (path == "/index") {
+        LocalHttp::respond(socket, method, "200 OK", "application/json", indexDocument());
+    } else if (path.startsWith("/blobs/")) {
+        serveBlob(socket, method, path.mid(7));
+    } else {
+        writeSimple(socket, "404 Not Found", "not found\n");
+    }
+}
+
+void PeerCache::serveBlob(QTcpSocket *socket, const QByteArray &method, const QByteArray &hexDigest)
+{
+    static MetricCounter *served = Metrics::instance()->counter(
+                "stv_peer_uploads_total", "Blobs requested by LAN peers, by result.", Metrics::label("result", "ok"));
+    static MetricCounter *missing = Metrics::instance()->counter(
+                "stv_peer_uploads_total", "Blobs requested by LAN peers, by result.", Metrics::label("result", "missing"));
+    static MetricCounter *busy = Metrics::instance()->counter(
+                "stv_peer_uploads_total", "Blobs requested by LAN peers, by result.", Metrics::label("result", "busy"));
+
+    // 只接受 64 位十六进制摘要，路径不会拼进文件系统
+    const QByteArray digest = QByteArray::fromHex(hexDigest);
+    const QString path = digest.size() == 32 && hexDigest.size() == 64 ? m_cache->pathForDigest(digest) : QString();
+    if (path.isEmpty()) {
+        missing->inc();
+        writeSimple(socket, "404 Not Found", "unknown blob\n");
+        return;
+    }
+    if (m_uploads >= MaxConcurrentUploads) {
+        busy->inc();
+        socket->write("HTTP/1.1 503 Service Unavailable\r\nRetry-After: 2\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+        socket->disconnectFromHost();
+        return;
+    }
+
+    // 文件随 socket 一起释放
+    QFile *file = new QFile(path, socket);
+    if (!file->open(QIODevice::ReadOnly)) {
+        missing->inc();
+        writeSimple(socket, "404 Not Found", "unreadable blob\n");
+        return;
+    }
+    served->inc();
+
+    socket->write("HTTP/1.1 200 OK\r\n"
+                  "Content-Type: application/octet-stream\r\n"
+                  "Content-Length: " + QByteArray::number(file->size()) + "\r\n"
+                  "X-Content-SHA256: " + hexDigest.toLower() + "\r\n"
+                  "Connection: close\r\n\r\n");
+    if (method == "HEAD") {
+        socket->disconnectFromHost();
+        return;
+    }
+
+    // 按发送缓冲分块读文件，大视频不会整体读进内存
+    ++m_uploads;
+    connect(socket, &QObject::destroyed, this, [this]() { --m_uploads; });
+    auto pump = [socket, file]() {
+        while (socket->bytesToWrite() < UploadBufferBytes && !file->atEnd()) {
+            const QByteArray chunk = file->read(UploadChunkBytes);
+            if (chunk.isEmpty()) {
+                break;
+            }
+            socket->write(chunk);
+            Metrics::instance()->counter("stv_peer_upload_bytes_total", "Bytes sent to LAN peers.")
+                    ->inc(quint64(chunk.size()));
+        }
+        if (file->atEnd() && socket->state() == QAbstractSocket::ConnectedState) {
+            socket->disconnectFromHost();
+        }
+    };
+    connect(socket, &QTcpSocket::bytesWritten, socket, pump);
+    pump();
+}
+
+void PeerCache::writeSimple(QTcpSocket *socket, const QByteArray &status, const QByteArray &body)
+{
+    LocalHttp::respond(socket, "GET", status, "text/plain; charset=utf-8", body);
+}
+
+QByteArray PeerCache::indexDocument() const
+{
+    QJsonObject entries;
+    const QHash<QString, QByteArray> index = m_cache->digestIndex();
+    for (auto it = index.constBegin(); it != index.constEnd(); ++it) {
+        entries.insert(it.key(), QString::fromLatin1(it->toHex()));
+    }
+    QJsonObject root;
+    root["id"] = m_instanceId;
+    root["gen"] = double(m_generation);
+    root["entries"] = entries;
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
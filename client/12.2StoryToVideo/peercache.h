@@ -0,0 +1,80 @@
+#ifndef PEERCACHE_H
+#define PEERCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QHostAddress>
+#include <QUrl>
+
+class MediaCache;
+class QNetworkAccessManager;
+class QTcpServer;
+class QTcpSocket;
+class QTimer;
+class QUdpSocket;
+
+// 局域网对等缓存：多台工作站共享已下载的图片/视频，减少经 FRP 隧道重复拉取。
+// - 每隔几秒在 UDP 端口上广播 beacon (实例 id + HTTP 端口 + 索引版本号)
+// - 收到新的 peer 或版本号变化时拉取其索引 GET /index (URL 摘要 -> 内容 SHA-256)
+// - 本机 HTTP 端口按内容哈希提供文件 GET /blobs/<sha256>，响应带 X-Content-SHA256
+// MediaCache 下载前先问 locate()，peer 取回的内容按 SHA-256 校验，失败再回源到 Gateway。
+// 设置环境变量 STV_PEER_CACHE 才启用 ("1" 使用默认发现端口，或直接给出端口号)。
+class PeerCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PeerCache(MediaCache *cache, QObject *parent = nullptr);
+    ~PeerCache();
+
+    static const quint16 DefaultDiscoveryPort = 45454;
+    static const int BeaconIntervalMs = 5000;
+    static const int PeerTimeoutMs = 20000;      // 超过该时间没收到 beacon 视为离线
+    static const int MaxConcurrentUploads = 4;   // 同时向 peer 发送的文件数
+
+    // 读取 STV_PEER_CACHE 并开始广播/监听；未设置时什么也不做
+    bool startFromEnvironment();
+    bool isEnabled() const { return m_server != nullptr; }
+
+    // 局域网内持有该 URL 内容的 peer 下载地址，没有时返回无效 QUrl；sha256 返回期望摘要
+    QUrl locate(const QString &url, QByteArray *sha256) const;
+    // peer 返回错误或内容校验失败：忘掉它对这份内容的声明
+    void reportBadSource(const QUrl &source, const QByteArray &sha256);
+
+    int peerCount() const { return m_peers.size(); }
+
+    // 索引与 peer 之间共用的 URL 摘要 (SHA-1 十六进制)
+    static QString urlKey(const QString &url);
+
+private:
+    struct Peer {
+        QHostAddress address;
+        quint16 port;
+        qint64 lastSeen;                       // ms
+        qint64 generation;                     // 已拉取索引对应的版本号，-1 表示尚未拉取
+        bool fetching;
+        QHash<QString, QByteArray> entries;    // URL 摘要 -> SHA-256
+    };
+
+    void sendBeacon();
+    void readBeacons();
+    void fetchIndex(const QString &peerId);
+    void expirePeers();
+
+    void handleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &path);
+    void serveBlob(QTcpSocket *socket, const QByteArray &method, const QByteArray &hexDigest);
+    void writeSimple(QTcpSocket *socket, const QByteArray &status, const QByteArray &body);
+    QByteArray indexDocument() const;
+
+    MediaCache *m_cache;
+    QString m_instanceId;
+    quint16 m_discoveryPort;
+    qint64 m_generation;                       // 本机缓存内容的版本号，新文件入库时递增
+    int m_uploads;
+    QUdpSocket *m_udp;
+    QTcpServer *m_server;
+    QTimer *m_beaconTimer;
+    QNetworkAccessManager *m_network;
+    QHash<QString, Peer> m_peers;              // 实例 id -> peer
+};
+
+#endif // PEERCACHE_H
@@ -0,0 +1,85 @@
+#include "sessionsnapshot.h"
+#include <QCborMap>
+#include <QCborValue>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+SessionSnapshot::SessionSnapshot(QObject *parent)
+    : QObject(parent)
+{
+}
+
+QString SessionSnapshot::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/session.snapshot";
+}
+
+bool SessionSnapshot::load(const QString &path)
+{
+    m_project.clear();
+    if (qEnvironmentVariable("STV_WARM_START") == "0") {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QCborParserError error;
+    const QCborValue value = QCborValue::fromCbor(file.readAll(), &error);
+    if (error.error != QCborError::NoError || !value.isMap()) {
+        qDebug() << "SessionSnapshot: 快照损坏，忽略:" << error.errorString();
+        return false;
+    }
+    const QVariantMap snapshot = value.toMap().toVariantMap();
+    if (snapshot.value("version").toInt() != FormatVersion) {
+        return false;
+    }
+    const QDateTime savedAt = QDateTime::fromMSecsSinceEpoch(snapshot.value("savedAt").toLongLong());
+    if (savedAt.daysTo(QDateTime::currentDateTime()) > MaxAgeDays) {
+        qDebug() << "SessionSnapshot: 快照已过期 (" << savedAt.toString(Qt::ISODate) << ")";
+        return false;
+    }
+
+    m_project = snapshot.value("project").toMap();
+    qDebug() << "SessionSnapshot: 恢复项目" << m_project.value("id").toString()
+             << m_project.value("shots").toList().size() << "个分镜," << file.size() << "字节,"
+             << timer.elapsed() << "ms";
+    return hasProject();
+}
+
+bool SessionSnapshot::save(const QVariantMap &project, const QString &path) const
+{
+    if (project.value("id").toString().isEmpty()) {
+        QFile::remove(path);
+        return true;
+    }
+
+    QVariantMap snapshot;
+    snapshot["version"] = FormatVersion;
+    snapshot["savedAt"] = QDateTime::currentMSecsSinceEpoch();
+    snapshot["project"] = project;
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "SessionSnapshot: 无法写入" << path;
+        return false;
+    }
+    file.write(QCborValue::fromVariant(snapshot).toCbor());
+    if (!file.commit()) {
+        qDebug() << "SessionSnapshot: 保存失败" << path;
+        return false;
+    }
+    qDebug() << "SessionSnapshot: 已保存项目" << project.value("id").toString() << "->" << path;
+    return true;
+}
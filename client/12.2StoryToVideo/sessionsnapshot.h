@@ -0,0 +1,38 @@
+#ifndef SESSIONSNAPSHOT_H
+#define SESSIONSNAPSHOT_H
+
+#include <QObject>
+#include <QVariantMap>
+
+// 上次会话的界面快照 (热启动)：退出时保存当前项目与分镜行，启动时在加载 QML 之前同步读出，
+// 第一帧就用它渲染故事板，再由 StoryboardPage 在后台向服务端刷新。
+// 文件为 CBOR (比缩进 JSON 小、解析快)；分镜图片优先记录媒体缓存里的本地文件，恢复时不走网络。
+// STV_WARM_START=0 关闭恢复 (仍会保存)。
+class SessionSnapshot : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool hasProject READ hasProject CONSTANT)
+    Q_PROPERTY(QVariantMap project READ project CONSTANT)
+
+public:
+    static const int FormatVersion = 1;
+    static const int MaxAgeDays = 30;      // 更早的快照不再恢复
+
+    explicit SessionSnapshot(QObject *parent = nullptr);
+
+    // AppDataLocation/session.snapshot
+    static QString defaultPath();
+
+    // 启动时调用；文件不存在、版本不符或已过期时返回 false
+    bool load(const QString &path = defaultPath());
+    // project: { id, title, refreshable, shots: [...] }，为空时删除快照
+    bool save(const QVariantMap &project, const QString &path = defaultPath()) const;
+
+    bool hasProject() const { return !m_project.value("id").toString().isEmpty(); }
+    QVariantMap project() const { return m_project; }
+
+private:
+    QVariantMap m_project;
+};
+
+#endif // SESSIONSNAPSHOT_H
@@ -0,0 +1,319 @@
+#include "soaktest.h"
+#include "ViewModel.h"
+#include "commandline.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QTimer>
+#include <QVariantMap>
+#include <QDebug>
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#if defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#endif
+
+static const int DrainDelayMs = 3000;
+
+// --- 1. 参数 ---
+bool SoakTest::parseArguments(const QStringList &arguments, Options *options)
+{
+    const CommandLine::Options parsed = CommandLine::parse(arguments);
+    if (!parsed.contains("--soak")) {
+        return false;
+    }
+
+    // 未给值的选项保持 Options 中的默认值
+    options->pipelines = CommandLine::intValue(parsed, "--soak", options->pipelines, 1);
+    options->concurrency = CommandLine::intValue(parsed, "--soak-concurrency", options->concurrency, 1);
+    options->warmupPipelines = CommandLine::intValue(parsed, "--soak-warmup", options->warmupPipelines, 0);
+    options->sampleIntervalMs = CommandLine::intValue(parsed, "--soak-interval-ms", options->sampleIntervalMs, 100);
+    options->pipelineTimeoutMs = CommandLine::intValue(parsed, "--soak-timeout-ms", options->pipelineTimeoutMs, 1000);
+    if (!parsed.value("--soak-max-rss-mb").isEmpty()) {
+        options->maxRssGrowthMb = parsed.value("--soak-max-rss-mb").toDouble();
+    }
+    if (!parsed.value("--soak-max-heap-mb").isEmpty()) {
+        options->maxHeapGrowthMb = parsed.value("--soak-max-heap-mb").toDouble();
+    }
+    if (!parsed.value("--soak-max-objects").isEmpty()) {
+        options->maxObjectGrowth = parsed.value("--soak-max-objects").toInt();
+    }
+    if (!parsed.value("--soak-max-failure-ratio").isEmpty()) {
+        options->maxFailureRatio = parsed.value("--soak-max-failure-ratio").toDouble();
+    }
+    if (!parsed.value("--soak-report").isEmpty()) {
+        options->reportPath = parsed.value("--soak-report");
+    }
+    return true;
+}
+
+SoakTest::SoakTest(ViewModel *viewModel, const Options &options, QObject *parent)
+    : QObject(parent),
+      m_viewModel(viewModel),
+      m_options(options),
+      m_started(0),
+      m_completed(0),
+      m_failed(0),
+      m_errors(0),
+      m_haveBaseline(false),
+      m_draining(false)
+{
+    m_sampleTimer = new QTimer(this);
+    m_sampleTimer->setInterval(m_options.sampleIntervalMs);
+    connect(m_sampleTimer, &QTimer::timeout, this, [this]() {
+        const Sample sample = takeSample();
+        qDebug().noquote() << QString("SoakTest: %1s 完成 %2/%3 失败 %4 | RSS %5 MB 堆 %6 MB QObject %7")
+                              .arg(sample.elapsedMs / 1000).arg(m_completed).arg(m_options.pipelines).arg(m_failed)
+                              .arg(sample.rssBytes / 1048576.0, 0, 'f', 1)
+                              .arg(sample.heapBytes / 1048576.0, 0, 'f', 1)
+                              .arg(sample.objects);
+        expireStalled();
+    });
+
+    connect(m_viewModel, &ViewModel::storyboardGenerated, this, &SoakTest::onStoryboardGenerated);
+    connect(m_viewModel, &ViewModel::imageGenerationFinished, this,
+            [this](const QString &shotId, const QString &) { onImageFinished(shotId); });
+    connect(m_viewModel, &ViewModel::videoResourceReady, this,
+            [this](const QString &storyId, const QString &) { onVideoReady(storyId); });
+    connect(m_viewModel, &ViewModel::generationFailed, this, [this](const QString &errorMsg) {
+        // 失败信号不带项目 ID；对应的流程由超时回收
+        ++m_errors;
+        qDebug() << "SoakTest: 生成失败" << errorMsg;
+    });
+}
+
+void SoakTest::start()
+{
+    qDebug() << "SoakTest: 开始，流程数" << m_options.pipelines << "并发" << m_options.concurrency
+             << "预热" << m_options.warmupPipelines;
+    m_clock.start();
+    m_samples.append(takeSample());
+    m_sampleTimer->start();
+    launchPipelines();
+}
+
+
+// --- 2. 流程驱动 ---
+void SoakTest::launchPipelines()
+{
+    while (!m_draining && m_started < m_options.pipelines
+           && m_pendingCreates.size() + m_running.size() < m_options.concurrency) {
+        ++m_started;
+        m_pendingCreates.append(m_clock.elapsed());
+        // 保持在章节模式阈值以下，每个流程对应一个服务端项目
+        const QString story = QString("第%1个浸泡测试故事。侦探在雨夜追赶嫌疑人。两人在天台对峙。真相终于大白。")
+                .arg(m_started);
+        m_viewModel->generateStoryboard(story, "movie");
+    }
+
+    if (!m_draining && m_started >= m_options.pipelines && m_pendingCreates.isEmpty() && m_running.isEmpty()) {
+        // 等待 deleteLater、最后的轮询和缓存下载完成后再取最终样本
+        m_draining = true;
+        QTimer::singleShot(DrainDelayMs, this, &SoakTest::conclude);
+    }
+}
+
+void SoakTest::onStoryboardGenerated(const QVariant &storyData)
+{
+    if (m_pendingCreates.isEmpty()) {
+        return;
+    }
+    const QVariantMap story = storyData.toMap();
+    const QString storyId = story.value("id").toString();
+    m_running.insert(storyId, m_pendingCreates.takeFirst());
+
+    // 重生成第一张分镜图，覆盖 UpdateShot 路径；没有分镜时直接合成视频
+    const QVariantList shots = story.value("shots").toList();
+    if (shots.isEmpty()) {
+        m_viewModel->startVideoCompilation(storyId);
+        return;
+    }
+    const QVariantMap shot = shots.first().toMap();
+    const QString shotId = shot.value("id").toString();
+    m_shotStory.insert(shotId, storyId);
+    m_viewModel->generateShotImage(shotId, shot.value("prompt").toString() + ", soak", "cut");
+}
+
+void SoakTest::onImageFinished(const QString &shotId)
+{
+    const QString storyId = m_shotStory.take(shotId);
+    if (m_running.contains(storyId)) {
+        m_viewModel->startVideoCompilation(storyId);
+    }
+}
+
+void SoakTest::onVideoReady(const QString &storyId)
+{
+    finishPipeline(storyId, true);
+}
+
+void SoakTest::finishPipeline(const QString &storyId, bool ok)
+{
+    if (!m_running.remove(storyId)) {
+        return;
+    }
+    for (auto it = m_shotStory.begin(); it != m_shotStory.end();) {
+        if (it.value() == storyId) {
+            it = m_shotStory.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    if (ok) {
+        ++m_completed;
+    } else {
+        ++m_failed;
+    }
+
+    if (!m_haveBaseline && m_completed >= m_options.warmupPipelines) {
+        m_baseline = takeSample();
+        m_haveBaseline = true;
+        qDebug() << "SoakTest: 预热完成，记录基线";
+    }
+    launchPipelines();
+}
+
+void SoakTest::expireStalled()
+{
+    const qint64 now = m_clock.elapsed();
+    while (!m_pendingCreates.isEmpty() && now - m_pendingCreates.first() > m_options.pipelineTimeoutMs) {
+        m_pendingCreates.removeFirst();
+        ++m_failed;
+    }
+    QStringList stalled;
+    for (auto it = m_running.constBegin(); it != m_running.constEnd(); ++it) {
+        if (now - it.value() > m_options.pipelineTimeoutMs) {
+            stalled.append(it.key());
+        }
+    }
+    for (const QString &storyId : stalled) {
+        qDebug() << "SoakTest: 流程超时" << storyId;
+        finishPipeline(storyId, false);
+    }
+    launchPipelines();
+}
+
+
+// --- 3. 采样 ---
+qint64 SoakTest::residentBytes()
+{
+#if defined(Q_OS_LINUX)
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields[1].toLongLong() * sysconf(_SC_PAGESIZE) : -1;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count)
+            != KERN_SUCCESS) {
+        return -1;
+    }
+    return qint64(info.resident_size);
+#else
+    return -1;
+#endif
+}
+
+qint64 SoakTest::heapBytes()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    return qint64(info.uordblks + info.hblkhd);
+#elif defined(__GLIBC__)
+    const struct mallinfo info = mallinfo();
+    return qint64(info.uordblks) + qint64(info.hblkhd);
+#elif defined(Q_OS_MACOS)
+    return qint64(mstats().bytes_used);
+#else
+    return -1;
+#endif
+}
+
+int SoakTest::liveObjectCount()
+{
+    // Qt 没有公开的全局 QObject 计数，统计应用对象树 (回复、定时器、文件等都挂在树上)
+    QCoreApplication *app = QCoreApplication::instance();
+    return app ? 1 + app->findChildren<QObject *>().size() : -1;
+}
+
+SoakTest::Sample SoakTest::takeSample()
+{
+    Sample sample;
+    sample.elapsedMs = m_clock.elapsed();
+    sample.completed = m_completed;
+    sample.rssBytes = residentBytes();
+    sample.heapBytes = heapBytes();
+    sample.objects = liveObjectCount();
+    m_samples.append(sample);
+    return sample;
+}
+
+
+// --- 4. 结论 ---
+void SoakTest::conclude()
+{
+    m_sampleTimer->stop();
+    const Sample last = takeSample();
+    const Sample base = m_haveBaseline ? m_baseline : m_samples.first();
+
+    const double rssGrowthMb = (last.rssBytes >= 0 && base.rssBytes >= 0)
+            ? (last.rssBytes - base.rssBytes) / 1048576.0 : 0;
+    const double heapGrowthMb = (last.heapBytes >= 0 && base.heapBytes >= 0)
+            ? (last.heapBytes - base.heapBytes) / 1048576.0 : 0;
+    const int objectGrowth = last.objects - base.objects;
+    const double failureRatio = m_started > 0 ? double(m_failed) / m_started : 0;
+
+    QString reportPath = m_options.reportPath;
+    if (reportPath.isEmpty()) {
+        reportPath = QDir::tempPath() + "/stv-soak-" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + ".csv";
+    }
+    QFile report(reportPath);
+    if (report.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        QTextStream out(&report);
+        out << "elapsed_ms,completed,rss_bytes,heap_bytes,qobjects\n";
+        for (const Sample &sample : m_samples) {
+            out << sample.elapsedMs << ',' << sample.completed << ',' << sample.rssBytes << ','
+                << sample.heapBytes << ',' << sample.objects << '\n';
+        }
+    }
+
+    int exitCode = Passed;
+    QStringList reasons;
+    if (rssGrowthMb > m_options.maxRssGrowthMb) {
+        reasons << QString("RSS 增长 %1 MB > %2 MB").arg(rssGrowthMb, 0, 'f', 1).arg(m_options.maxRssGrowthMb);
+        exitCode = GrowthExceeded;
+    }
+    if (heapGrowthMb > m_options.maxHeapGrowthMb) {
+        reasons << QString("堆增长 %1 MB > %2 MB").arg(heapGrowthMb, 0, 'f', 1).arg(m_options.maxHeapGrowthMb);
+        exitCode = GrowthExceeded;
+    }
+    if (objectGrowth > m_options.maxObjectGrowth) {
+        reasons << QString("QObject 增加 %1 > %2").arg(objectGrowth).arg(m_options.maxObjectGrowth);
+        exitCode = GrowthExceeded;
+    }
+    if (exitCode == Passed && failureRatio > m_options.maxFailureRatio) {
+        // 大量失败时增长数据没有意义 (例如 Gateway 不可达)
+        reasons << QString("失败比例 %1% > %2%").arg(failureRatio * 100, 0, 'f', 1).arg(m_options.maxFailureRatio * 100);
+        exitCode = TooManyFailures;
+    }
+
+    qDebug().noquote() << QString("SoakTest: 结束，用时 %1s，完成 %2，失败 %3，错误信号 %4")
+                          .arg(last.elapsedMs / 1000).arg(m_completed).arg(m_failed).arg(m_errors);
+    qDebug().noquote() << QString("SoakTest: 相对基线 RSS %1 MB，堆 %2 MB，QObject %3；采样已写入 %4")
+                          .arg(rssGrowthMb, 0, 'f', 1).arg(heapGrowthMb, 0, 'f', 1).arg(objectGrowth).arg(reportPath);
+    qDebug().noquote() << (exitCode == Passed ? QString("SoakTest: 通过") : "SoakTest: 失败 - " + reasons.join("; "));
+
+    emit finished(exitCode);
+}
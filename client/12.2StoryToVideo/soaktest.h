@@ -0,0 +1,98 @@
+#ifndef SOAKTEST_H
+#define SOAKTEST_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class ViewModel;
+class QTimer;
+
+// 浸泡测试：不加载 QML，直接通过 ViewModel/NetworkManager 反复跑完整流程
+// (创建项目 -> 分镜 -> 重生成一张分镜图 -> 合成视频 -> 缓存视频)，
+// 定期采样 RSS、存活 QObject 数量与堆占用，结束时与预热后的基线比较，增长超过阈值即以非零退出码结束。
+//
+// 用法 (配合本地 mock-server)：
+//   MOCK_TIME_SCALE=0.05 MOCK_PUBLIC_URL=http://127.0.0.1:8888 python mock-server/main.py
+//   STV_GATEWAY_URL=http://127.0.0.1:8888 ./StoryToVideoGenerator -platform offscreen --soak=2000
+class SoakTest : public QObject
+{
+    Q_OBJECT
+public:
+    struct Options {
+        int pipelines = 2000;            // 总流程数
+        int concurrency = 8;             // 同时进行的流程数
+        int warmupPipelines = 50;        // 完成这么多流程后取基线 (缓存、连接池等一次性分配已稳定)
+        int sampleIntervalMs = 5000;
+        int pipelineTimeoutMs = 120000;  // 单个流程超时视为失败
+        double maxRssGrowthMb = 32;
+        double maxHeapGrowthMb = 32;
+        int maxObjectGrowth = 50;
+        double maxFailureRatio = 0.05;
+        QString reportPath;              // 采样 CSV，默认写到临时目录
+    };
+
+    // 退出码
+    enum ExitCode {
+        Passed = 0,
+        GrowthExceeded = 1,
+        TooManyFailures = 2
+    };
+
+    // 命令行中有 --soak[=N] 时返回 true 并填充 options；其余 --soak-xxx=value 参数覆盖默认值
+    static bool parseArguments(const QStringList &arguments, Options *options);
+
+    SoakTest(ViewModel *viewModel, const Options &options, QObject *parent = nullptr);
+
+    void start();
+
+    // 采样函数，平台不支持时返回 -1
+    static qint64 residentBytes();
+    static qint64 heapBytes();
+    static int liveObjectCount();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    struct Sample {
+        qint64 elapsedMs;
+        int completed;
+        qint64 rssBytes;
+        qint64 heapBytes;
+        int objects;
+    };
+
+    void launchPipelines();
+    void onStoryboardGenerated(const QVariant &storyData);
+    void onImageFinished(const QString &shotId);
+    void onVideoReady(const QString &storyId);
+    void finishPipeline(const QString &storyId, bool ok);
+    void expireStalled();
+    Sample takeSample();
+    void conclude();
+
+    ViewModel *m_viewModel;
+    Options m_options;
+    QElapsedTimer m_clock;
+    QTimer *m_sampleTimer;
+
+    int m_started;
+    int m_completed;
+    int m_failed;
+    int m_errors;                        // generationFailed 次数 (无法对应到具体流程)
+    QList<qint64> m_pendingCreates;      // 已提交、尚未拿到项目 ID 的流程的开始时间
+    QHash<QString, qint64> m_running;    // 项目 ID -> 开始时间
+    QHash<QString, QString> m_shotStory; // 正在重生成的分镜 ID -> 项目 ID
+
+    QVector<Sample> m_samples;
+    Sample m_baseline;
+    bool m_haveBaseline;
+    bool m_draining;
+};
+
+#endif // SOAKTEST_H
@@ -0,0 +1,125 @@
+#include "storysplitter.h"
+#include <QRegularExpression>
+#include <QtGlobal>
+
+// 在 [from, to) 内从后往前找最后一个句末位置 (返回句末之后的下标)，找不到返回 -1
+static int lastSentenceEnd(const QString &text, int from, int to)
+{
+    static const QString enders = QStringLiteral("。！？!?；;…\n");
+    for (int i = to - 1; i > from; --i) {
+        const QChar c = text.at(i);
+        if (enders.contains(c)) {
+            // 吞掉紧随的右引号/括号
+            int end = i + 1;
+            while (end < text.size() && QStringLiteral("”’」』）)\"").contains(text.at(end))) {
+                ++end;
+            }
+            return end;
+        }
+        if (c == '.' && (i + 1 >= text.size() || text.at(i + 1).isSpace())) {
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+// 把一段文本按目标长度贪心打包：优先在段落边界切，超长段落退化到句末切
+static QStringList packSection(const QString &section, int target)
+{
+    QStringList pieces;
+    const QStringList paragraphs = section.split(QRegularExpression("\\n\\s*\\n"), Qt::SkipEmptyParts);
+
+    QString current;
+    auto flush = [&]() {
+        if (!current.trimmed().isEmpty()) {
+            pieces.append(current.trimmed());
+        }
+        current.clear();
+    };
+
+    for (QString paragraph : paragraphs) {
+        paragraph = paragraph.trimmed();
+        if (!current.isEmpty() && current.size() + paragraph.size() > target) {
+            flush();
+        }
+        // 单个段落远超目标长度：在句末切开
+        while (paragraph.size() > target * 2) {
+            int cut = lastSentenceEnd(paragraph, target / 2, target + target / 2);
+            if (cut < 0) {
+                cut = target;
+            }
+            current += paragraph.left(cut);
+            flush();
+            paragraph = paragraph.mid(cut).trimmed();
+        }
+        if (!current.isEmpty()) {
+            current += "\n\n";
+        }
+        current += paragraph;
+    }
+    flush();
+    return pieces;
+}
+
+QStringList StorySplitter::split(const QString &storyText)
+{
+    const QString text = storyText.trimmed();
+    if (text.size() < ChapterModeThreshold) {
+        return QStringList() << text;
+    }
+
+    const int target = qMax(TargetChapterChars, text.size() / MaxChapters + 1);
+
+    // 1. 显式章节标题
+    static const QRegularExpression heading(
+        QStringLiteral("^[ \\t　]*(第[零一二三四五六七八九十百千两〇0-9]+[章节回幕卷]|chapter\\s+[0-9ivxlc]+\\b|#{1,3}\\s+\\S)"),
+        QRegularExpression::MultilineOption | QRegularExpression::CaseInsensitiveOption);
+
+    QStringList sections;
+    QList<int> starts;
+    QRegularExpressionMatchIterator it = heading.globalMatch(text);
+    while (it.hasNext()) {
+        starts.append(it.next().capturedStart());
+    }
+    if (starts.size() >= 2) {
+        starts[0] = 0; // 第一个标题之前的楔子并入第一章
+        for (int i = 0; i < starts.size(); ++i) {
+            const int end = i + 1 < starts.size() ? starts[i + 1] : text.size();
+            sections.append(text.mid(starts[i], end - starts[i]));
+        }
+    } else {
+        sections.append(text);
+    }
+
+    // 2. 过长的章节再按段落/句子切分
+    QStringList chapters;
+    for (const QString &section : sections) {
+        if (section.size() > target * 2) {
+            chapters.append(packSection(section, target));
+        } else if (!section.trimmed().isEmpty()) {
+            chapters.append(section.trimmed());
+        }
+    }
+
+    // 3. 合并过短的章节，并把章节数限制在 MaxChapters 以内
+    QStringList merged;
+    for (const QString &chapter : chapters) {
+        if (!merged.isEmpty() && (chapter.size() < target / 4 || merged.last().size() < target / 4)) {
+            merged.last() += "\n\n" + chapter;
+        } else {
+            merged.append(chapter);
+        }
+    }
+    while (merged.size() > MaxChapters) {
+        // 合并相邻长度之和最小的一对
+        int best = 0;
+        for (int i = 1; i + 1 < merged.size(); ++i) {
+            if (merged[i].size() + merged[i + 1].size() < merged[best].size() + merged[best + 1].size()) {
+                best = i;
+            }
+        }
+        merged[best] += "\n\n" + merged[best + 1];
+        merged.removeAt(best + 1);
+    }
+    return merged;
+}
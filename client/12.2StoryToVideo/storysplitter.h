@@ -0,0 +1,22 @@
+#ifndef STORYSPLITTER_H
+#define STORYSPLITTER_H
+
+#include <QString>
+#include <QStringList>
+
+// 长故事的章节切分：按自然边界把文本切成若干章节，各章节作为独立子项目并行提交。
+// 边界优先级：章节标题 (第X章 / Chapter N / Markdown 标题) > 空行段落 > 句末标点。
+namespace StorySplitter
+{
+    // 短于该长度的故事不切分 (字符数)
+    const int ChapterModeThreshold = 2400;
+    // 单个章节的目标长度
+    const int TargetChapterChars = 1200;
+    // 同时提交的子项目上限，超出时放大章节长度
+    const int MaxChapters = 8;
+
+    // 返回按顺序排列的章节；不需要切分时只有一个元素
+    QStringList split(const QString &storyText);
+}
+
+#endif // STORYSPLITTER_H
@@ -0,0 +1,73 @@
+#include "streamdigest.h"
+#include <QList>
+#include <QNetworkReply>
+
+static QByteArray decodeDigestValue(QByteArray value)
+{
+    value = value.trimmed();
+    // RFC 9530 结构化字段的字节序列写作 :base64:
+    if (value.size() >= 2 && value.startsWith(':') && value.endsWith(':')) {
+        value = value.mid(1, value.size() - 2);
+    }
+    // 十六进制 (64 字符) 或 base64 (44 字符)
+    if (value.size() == 64) {
+        const QByteArray raw = QByteArray::fromHex(value);
+        if (raw.size() == 32) {
+            return raw;
+        }
+    }
+    const QByteArray raw = QByteArray::fromBase64(value);
+    return raw.size() == 32 ? raw : QByteArray();
+}
+
+static QByteArray findSha256(const QByteArray &header)
+{
+    // 多个算法以逗号分隔：sha-512=..., sha-256=...
+    const QList<QByteArray> items = header.split(',');
+    for (const QByteArray &item : items) {
+        const int eq = item.indexOf('=');
+        if (eq <= 0) {
+            continue;
+        }
+        if (item.left(eq).trimmed().toLower() == "sha-256") {
+            return decodeDigestValue(item.mid(eq + 1));
+        }
+    }
+    return QByteArray();
+}
+
+QByteArray StreamDigest::expectedDigest(const QNetworkReply *reply)
+{
+    if (!reply) {
+        return QByteArray();
+    }
+    if (reply->hasRawHeader("Repr-Digest")) {
+        const QByteArray digest = findSha256(reply->rawHeader("Repr-Digest"));
+        if (!digest.isEmpty()) {
+            return digest;
+        }
+    }
+    if (reply->hasRawHeader("Digest")) {
+        const QByteArray digest = findSha256(reply->rawHeader("Digest"));
+        if (!digest.isEmpty()) {
+            return digest;
+        }
+    }
+    if (reply->hasRawHeader("X-Content-SHA256")) {
+        return decodeDigestValue(reply->rawHeader("X-Content-SHA256"));
+    }
+    return QByteArray();
+}
+
+bool StreamDigest::verify(const QNetworkReply *reply, const QByteArray &actual, QString *errorMsg)
+{
+    const QByteArray expected = expectedDigest(reply);
+    if (expected.isEmpty() || expected == actual) {
+        return true;
+    }
+    if (errorMsg) {
+        *errorMsg = QString("完整性校验失败: 期望 SHA-256 %1，实际 %2")
+                        .arg(QString::fromLatin1(expected.toHex()), QString::fromLatin1(actual.toHex()));
+    }
+    return false;
+}
@@ -0,0 +1,42 @@
+#ifndef STREAMDIGEST_H
+#define STREAMDIGEST_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+
+class QNetworkReply;
+
+// 下载过程中的增量 SHA-256：每个 readyRead 数据块写盘的同时送入哈希，
+// 下载结束即得到摘要，校验与去重都不必再从磁盘读回文件。
+class StreamDigest
+{
+public:
+    StreamDigest() : m_hash(QCryptographicHash::Sha256), m_bytes(0) {}
+
+    void addData(const QByteArray &data)
+    {
+        m_hash.addData(data);
+        m_bytes += data.size();
+    }
+
+    qint64 bytes() const { return m_bytes; }
+
+    // 只能在数据全部写入后调用一次
+    QByteArray result() { return m_hash.result(); }
+
+    // 从响应头取服务端声明的 SHA-256 (原始字节)，没有时返回空：
+    //   Repr-Digest: sha-256=:<base64>:   (RFC 9530)
+    //   Digest: SHA-256=<base64>           (RFC 3230)
+    //   X-Content-SHA256: <hex>
+    static QByteArray expectedDigest(const QNetworkReply *reply);
+
+    // 比对结果；没有服务端摘要时视为通过，errorMsg 给出不一致的详情
+    static bool verify(const QNetworkReply *reply, const QByteArray &actual, QString *errorMsg = nullptr);
+
+private:
+    QCryptographicHash m_hash;
+    qint64 m_bytes;
+};
+
+#endif // STREAMDIGEST_H
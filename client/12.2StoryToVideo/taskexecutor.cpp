@@ -0,0 +1,291 @@
+#include "taskexecutor.h"
+#include "commandline.h"
+#include "imagescaler.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+
+// 当前线程所属的执行器与队列下标 (非工作线程为 nullptr / -1)
+static thread_local TaskExecutor *t_owner = nullptr;
+static thread_local int t_workerIndex = -1;
+
+TaskExecutor::TaskExecutor(int workerCount, QObject *parent)
+    : QObject(parent)
+{
+    if (workerCount <= 0) {
+        // 保留一个核心给 GUI 线程
+        workerCount = qMax(1, QThread::idealThreadCount() - 1);
+    }
+
+    m_queues.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        m_queues.append(new WorkerQueue);
+    }
+
+    m_workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        QThread *thread = QThread::create([this, i]() { workerLoop(i); });
+        thread->setObjectName(QString("TaskExecutor-%1").arg(i));
+        m_workers.append(thread);
+        thread->start();
+    }
+
+    qDebug() << "TaskExecutor 启动，工作线程数:" << workerCount;
+}
+
+TaskExecutor::~TaskExecutor()
+{
+    {
+        QMutexLocker locker(&m_sleepMutex);
+        m_stopping.storeRelease(1);
+        m_wakeUp.wakeAll();
+    }
+
+    for (QThread *thread : m_workers) {
+        thread->wait();
+        delete thread;
+    }
+    qDeleteAll(m_queues);
+}
+
+TaskExecutor *TaskExecutor::instance()
+{
+    // 函数内静态变量的初始化是线程安全的；main() 中会先在 GUI 线程触发一次
+    static TaskExecutor *s_instance = new TaskExecutor(0, QCoreApplication::instance());
+    return s_instance;
+}
+
+
+// --- 1. 任务提交 ---
+CancellationToken TaskExecutor::submit(Job job, Priority priority)
+{
+    CancellationToken token;
+    submit(job, token, priority);
+    return token;
+}
+
+void TaskExecutor::submit(Job job, const CancellationToken &token, Priority priority)
+{
+    if (m_stopping.loadAcquire()) {
+        return;
+    }
+
+    // 工作线程内部提交的子任务放回自己的队列 (缓存局部性最好)，外部提交则轮转分发
+    int index;
+    if (t_owner == this && t_workerIndex >= 0) {
+        index = t_workerIndex;
+    } else {
+        index = (m_nextQueue.fetchAndAddRelaxed(1) & 0x7fffffff) % m_queues.size();
+    }
+
+    Task task;
+    task.job = job;
+    task.token = token;
+    {
+        QMutexLocker locker(&m_queues[index]->mutex);
+        m_queues[index]->lanes[priority].push_back(task);
+    }
+    m_pending.ref();
+
+    QMutexLocker locker(&m_sleepMutex);
+    m_wakeUp.wakeOne();
+}
+
+
+// --- 2. 取任务：本地 LIFO，窃取 FIFO ---
+bool TaskExecutor::takeLocal(int index, int lane, Task &out)
+{
+    WorkerQueue *queue = m_queues[index];
+    QMutexLocker locker(&queue->mutex);
+    std::deque<Task> &deque = queue->lanes[lane];
+    if (deque.empty()) {
+        return false;
+    }
+    out = deque.back();
+    deque.pop_back();
+    return true;
+}
+
+bool TaskExecutor::steal(int thief, int lane, Task &out)
+{
+    const int count = m_queues.size();
+    for (int offset = 1; offset < count; ++offset) {
+        WorkerQueue *victim = m_queues[(thief + offset) % count];
+        // tryLock：对方正忙于操作自己的队列时直接换下一个，避免窃取方互相阻塞
+        if (!victim->mutex.tryLock()) {
+            continue;
+        }
+        std::deque<Task> &deque = victim->lanes[lane];
+        if (!deque.empty()) {
+            out = deque.front();
+            deque.pop_front();
+            victim->mutex.unlock();
+            return true;
+        }
+        victim->mutex.unlock();
+    }
+    return false;
+}
+
+bool TaskExecutor::nextTask(int index, Task &out)
+{
+    // Interactive 通道整体优先：先查本地，再窃取；都没有才轮到 Background
+    for (int lane = Interactive; lane <= Background; ++lane) {
+        if (takeLocal(index, lane, out) || steal(index, lane, out)) {
+            m_running.ref();
+            m_pending.deref();
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskExecutor::workerLoop(int index)
+{
+    t_owner = this;
+    t_workerIndex = index;
+
+    while (!m_stopping.loadAcquire()) {
+        Task task;
+        if (nextTask(index, task)) {
+            if (!task.token.isCancelled()) {
+                task.job(task.token);
+            }
+            if (!m_running.deref() && m_pending.loadAcquire() == 0) {
+                QMutexLocker locker(&m_sleepMutex);
+                m_idle.wakeAll();
+            }
+            continue;
+        }
+
+        QMutexLocker locker(&m_sleepMutex);
+        // tryLock 窃取可能漏掉任务，因此带超时等待，兜底重新扫描
+        if (m_pending.loadAcquire() == 0 && !m_stopping.loadAcquire()) {
+            m_wakeUp.wait(&m_sleepMutex, 50);
+        }
+    }
+
+    t_owner = nullptr;
+    t_workerIndex = -1;
+}
+
+void TaskExecutor::waitForDone()
+{
+    QMutexLocker locker(&m_sleepMutex);
+    while (m_pending.loadAcquire() > 0 || m_running.loadAcquire() > 0) {
+        m_idle.wait(&m_sleepMutex, 50);
+    }
+}
+
+
+// --- 4. 基准 ---
+bool TaskExecutor::runFromArguments(const QStringList &arguments, int *exitCode)
+{
+    const CommandLine::Options options = CommandLine::parse(arguments);
+    if (!options.contains("--executor-bench")) {
+        return false;
+    }
+    *exitCode = runBenchmark(CommandLine::intValue(options, "--executor-bench", 500, 1));
+    return true;
+}
+
+int TaskExecutor::runBenchmark(int decodeCount)
+{
+    QTemporaryDir temp;
+    if (!temp.isValid()) {
+        qDebug() << "TaskExecutor: 无法创建临时目录";
+        return 2;
+    }
+
+    // 与分镜图相近的 1280x720 JPEG；解码任务轮流读取这些文件 (文件内容不同，避免全部命中同一份解码缓存)
+    const int distinct = qMin(decodeCount, 24);
+    QStringList files;
+    QRandomGenerator random(20240501);
+    for (int i = 0; i < distinct; ++i) {
+        QImage image(1280, 720, QImage::Format_RGB32);
+        for (int y = 0; y < image.height(); ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+            for (int x = 0; x < image.width(); ++x) {
+                const int noise = int(random.bounded(24));
+                line[x] = qRgb((x / 5 + i * 10 + noise) % 256, (y / 3 + noise) % 256, ((x + y) / 7 + i * 30) % 256);
+            }
+        }
+        const QString path = temp.filePath(QString("frame_%1.jpg").arg(i));
+        if (!image.save(path, "JPG", 85)) {
+            qDebug() << "TaskExecutor: 基准图片写入失败" << path;
+            return 2;
+        }
+        files.append(path);
+    }
+
+    // 与 ThumbnailResponse 相同的工作：QImageReader 解码后缩到最长边 256
+    auto decode = [](const QString &path) {
+        QImageReader reader(path);
+        const QImage decoded = reader.read();
+        return !decoded.isNull() && !ImageScaler::fitWithin(decoded, 256, ImageScaler::Area).isNull();
+    };
+
+    QVector<int> workerCounts;
+    const int cores = qMax(1, QThread::idealThreadCount());
+    for (int n = 1; n < cores; n *= 2) {
+        workerCounts.append(n);
+    }
+    workerCounts.append(cores);
+
+    qDebug().noquote() << QString("TaskExecutor: %1 次缩略图解码 (1280x720 JPEG -> 256)，%2 个逻辑核心")
+                          .arg(decodeCount).arg(cores);
+    QAtomicInt failures;
+    double singleMs = 0.0;
+    QElapsedTimer timer;
+    for (int workers : workerCounts) {
+        TaskExecutor executor(workers);
+        timer.start();
+        for (int i = 0; i < decodeCount; ++i) {
+            const QString path = files[i % distinct];
+            executor.submit([path, decode, &failures](const CancellationToken &) {
+                if (!decode(path)) {
+                    failures.ref();
+                }
+            });
+        }
+        executor.waitForDone();
+        const double ms = timer.nsecsElapsed() / 1e6;
+        if (workers == 1) {
+            singleMs = ms;
+        }
+        qDebug().noquote() << QString("TaskExecutor: %1 线程  %2 ms，%3 次/秒，加速 %4 倍 (效率 %5%)")
+                              .arg(workers, 2).arg(ms, 0, 'f', 1)
+                              .arg(decodeCount * 1000.0 / ms, 0, 'f', 1)
+                              .arg(singleMs / ms, 0, 'f', 2)
+                              .arg(singleMs / ms / workers * 100.0, 0, 'f', 0);
+    }
+
+    // 优先级通道：整批后台解码已排队时，再各提交一个 Interactive 与 Background 任务，比较开始执行前的等待
+    {
+        TaskExecutor executor(cores);
+        for (int i = 0; i < decodeCount; ++i) {
+            const QString path = files[i % distinct];
+            executor.submit([path, decode](const CancellationToken &) { decode(path); });
+        }
+        std::atomic<qint64> interactiveWaitNs(-1);
+        std::atomic<qint64> backgroundWaitNs(-1);
+        timer.start();
+        executor.submit([&](const CancellationToken &) { backgroundWaitNs.store(timer.nsecsElapsed()); }, Background);
+        executor.submit([&](const CancellationToken &) { interactiveWaitNs.store(timer.nsecsElapsed()); }, Interactive);
+        executor.waitForDone();
+        qDebug().noquote() << QString("TaskExecutor: 积压 %1 个后台任务时，Interactive 任务等待 %2 ms，Background 任务等待 %3 ms")
+                              .arg(decodeCount)
+                              .arg(interactiveWaitNs.load() / 1e6, 0, 'f', 2)
+                              .arg(backgroundWaitNs.load() / 1e6, 0, 'f', 1);
+    }
+
+    if (failures.loadAcquire() > 0) {
+        qDebug() << "TaskExecutor: 解码失败" << failures.loadAcquire() << "次";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+#ifndef TASKEXECUTOR_H
+#define TASKEXECUTOR_H
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QVector>
+#include <QList>
+#include <QAtomicInt>
+#include <QMetaObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QStringList>
+#include <deque>
+#include <functional>
+#include <atomic>
+
+// 协作式取消句柄：任务在循环中调用 isCancelled() 自行退出
+class CancellationToken
+{
+public:
+    CancellationToken() : m_flag(new std::atomic<bool>(false)) {}
+
+    void cancel() const { m_flag->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return m_flag->load(std::memory_order_relaxed); }
+
+private:
+    QSharedPointer<std::atomic<bool>> m_flag;
+};
+
+// 客户端共享的后台执行器 (work-stealing 线程池)
+// - 每个工作线程拥有自己的双端队列：本线程 LIFO 取任务，空闲线程从其他队列头部 FIFO 窃取
+// - 两条优先级通道：Interactive (用户正在等待的结果) 永远先于 Background 执行
+// - 结果通过 Qt 事件循环投递回 context 对象所在线程 (通常是 GUI 线程)
+//
+// 基准：
+//   ./StoryToVideoGenerator --executor-bench[=N]   N 次缩略图解码 (JPEG 读取 + 缩小到 256)，按 1..核数个工作线程报告耗时与加速比 (默认 500)
+class TaskExecutor : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority {
+        Interactive = 0,
+        Background = 1
+    };
+
+    typedef std::function<void(const CancellationToken &)> Job;
+
+    explicit TaskExecutor(int workerCount = 0, QObject *parent = nullptr);
+    ~TaskExecutor();
+
+    // 进程级共享实例 (缩略图、哈希、JSON 解码等 CPU 任务统一走这里)
+    static TaskExecutor *instance();
+
+    int workerCount() const { return m_workers.size(); }
+    int pendingCount() const { return m_pending.loadAcquire(); }
+
+    // --- 1. 提交纯后台任务 (无返回值) ---
+    CancellationToken submit(Job job, Priority priority = Background);
+    void submit(Job job, const CancellationToken &token, Priority priority = Background);
+
+    // --- 2. 提交任务并在 context 线程接收结果 ---
+    // work 在工作线程执行；done 通过 QueuedConnection 在 context 线程执行。
+    // context 被销毁或 token 被取消时 done 不会被调用。
+    template <typename Work, typename Done>
+    CancellationToken run(QObject *context, Work work, Done done, Priority priority = Background)
+    {
+        CancellationToken token;
+        run(context, token, work, done, priority);
+        return token;
+    }
+
+    template <typename Work, typename Done>
+    void run(QObject *context, const CancellationToken &token, Work work, Done done, Priority priority = Background)
+    {
+        // 工作线程不能直接访问 context (可能已被销毁)：结果投递给与 context 同线程的中转对象，
+        // 共享指针保证投递时它仍然存在；在 context 线程上再检查 context 是否存活
+        QPointer<QObject> guard(context);
+        QSharedPointer<QObject> relay(new QObject, &QObject::deleteLater);
+        relay->moveToThread(context->thread());
+        submit([guard, relay, work, done](const CancellationToken &t) {
+            auto result = work(t);
+            if (t.isCancelled())
+                return;
+            QMetaObject::invokeMethod(relay.data(), [t, guard, relay, done, result]() {
+                if (guard && !t.isCancelled())
+                    done(result);
+            }, Qt::QueuedConnection);
+        }, token, priority);
+    }
+
+    // 阻塞直到队列清空 (仅用于退出流程)
+    void waitForDone();
+
+    // 处理 --executor-bench；返回 false 表示不是该命令
+    static bool runFromArguments(const QStringList &arguments, int *exitCode);
+
+    // 每个工作线程数各建一个执行器跑同一批解码，打印扩展性；再测后台任务积压时 Interactive 任务的等待时间
+    static int runBenchmark(int decodeCount);
+
+private:
+    struct Task {
+        Job job;
+        CancellationToken token;
+    };
+
+    struct WorkerQueue {
+        QMutex mutex;
+        std::deque<Task> lanes[2];
+    };
+
+    void workerLoop(int index);
+    bool takeLocal(int index, int lane, Task &out);
+    bool steal(int thief, int lane, Task &out);
+    bool nextTask(int index, Task &out);
+
+    QVector<QThread *> m_workers;
+    QVector<WorkerQueue *> m_queues;
+
+    QMutex m_sleepMutex;
+    QWaitCondition m_wakeUp;
+    QWaitCondition m_idle;
+    QAtomicInt m_pending;
+    QAtomicInt m_running;
+    QAtomicInt m_nextQueue;
+    QAtomicInt m_stopping;
+};
+
+#endif // TASKEXECUTOR_H
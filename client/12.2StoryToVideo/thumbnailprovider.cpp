@@ -0,0 +1,207 @@
+#include "thumbnailprovider.h"
+#include "imagescaler.h"
+#include "taskexecutor.h"
+#include "imagehash.h"
+#include "assetindex.h"
+#include "mediaworkerclient.h"
+#include "metrics.h"
+#include <QImageReader>
+#include <QMutexLocker>
+#include <QPointer>
+#include <QUrl>
+#include <QDebug>
+
+QMutex ThumbnailProvider::s_cacheMutex;
+// 开销按像素计，约 64 张 256px 缩略图
+QCache<QString, QImage> ThumbnailProvider::s_cache(256 * 256 * 64);
+
+static QString cacheKey(const QString &path, double time, const QSize &size)
+{
+    return QString("%1#t=%2@%3x%4").arg(path).arg(time).arg(size.width()).arg(size.height());
+}
+
+
+// --- 1. ThumbnailResponse ---
+namespace {
+
+struct DecodedThumbnail {
+    QImage image;
+    QString error;
+};
+
+// 在工作线程执行：只使用按值传入的参数，不访问 response
+DecodedThumbnail decodeThumbnail(const QString &path, const QSize &requestedSize, const QString &key,
+                                 const CancellationToken &token)
+{
+    DecodedThumbnail result;
+    if (token.isCancelled() || ThumbnailProvider::lookup(key, result.image)) {
+        return result;
+    }
+
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+    QImage decoded = reader.read();
+
+    if (!decoded.isNull()) {
+        // 图片首次进入缓存时计算感知哈希，写入资产索引用于近似重复检测
+        AssetIndex::instance()->recordImage(path, ImageHash::dHash(decoded));
+    }
+
+    if (decoded.isNull()) {
+        result.error = QString("缩略图解码失败 %1: %2").arg(path, reader.errorString());
+    } else if (requestedSize.isValid() && !requestedSize.isEmpty()) {
+        const QSize target = decoded.size().scaled(requestedSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+        result.image = ImageScaler::downscale(decoded, target, ImageScaler::Area);
+    } else {
+        result.image = ImageScaler::fitWithin(decoded, ThumbnailProvider::DefaultMaxEdge, ImageScaler::Area);
+    }
+
+    if (!result.image.isNull()) {
+        ThumbnailProvider::store(key, result.image);
+    }
+    return result;
+}
+
+} // namespace
+
+ThumbnailResponse::ThumbnailResponse(const QString &path, double time, const QSize &requestedSize)
+    : m_path(path), m_time(time), m_requestedSize(requestedSize)
+{
+    static MetricCounter *hits = Metrics::instance()->counter(
+                "stv_thumbnail_cache_lookups_total", "Thumbnail memory cache lookups by result.",
+                Metrics::label("result", "hit"));
+    static MetricCounter *misses = Metrics::instance()->counter(
+                "stv_thumbnail_cache_lookups_total", "Thumbnail memory cache lookups by result.",
+                Metrics::label("result", "miss"));
+
+    const QString key = cacheKey(m_path, m_time, m_requestedSize);
+    if (ThumbnailProvider::lookup(key, m_image)) {
+        hits->inc();
+        finish();
+        return;
+    }
+    misses->inc();
+
+    MediaWorkerClient *worker = MediaWorkerClient::instance();
+    if (worker->isAvailable()) {
+        // 解码在子进程中进行；回调在 GUI 线程执行，而 response 属于图片加载线程，
+        // 因此结果先投递给本线程的中转对象，再检查 response 是否还在
+        const QSize maxSize = (m_requestedSize.isValid() && !m_requestedSize.isEmpty())
+                ? m_requestedSize
+                : QSize(ThumbnailProvider::DefaultMaxEdge, ThumbnailProvider::DefaultMaxEdge);
+        QPointer<ThumbnailResponse> self(this);
+        QSharedPointer<QObject> relay(new QObject, &QObject::deleteLater);
+        const CancellationToken token = m_token;
+        worker->requestThumbnail(m_path, maxSize, m_time, [self, relay, token, key, path](const MediaWorkerClient::Result &result) {
+            if (!result.unavailable) {
+                if (!result.image.isNull()) {
+                    ThumbnailProvider::store(key, result.image);
+                }
+                if (!result.dhash.isEmpty()) {
+                    AssetIndex::instance()->recordImage(path, ImageHash::fromHex(result.dhash));
+                }
+            }
+            if (token.isCancelled()) {
+                return;
+            }
+            QMetaObject::invokeMethod(relay.data(), [self, relay, token, result]() {
+                if (!self || token.isCancelled()) {
+                    return;
+                }
+                if (result.unavailable) {
+                    self->decodeInBackground();
+                    return;
+                }
+                self->m_image = result.image;
+                self->m_error = result.error;
+                self->finish();
+            }, Qt::QueuedConnection);
+        });
+        return;
+    }
+
+    decodeInBackground();
+}
+
+void ThumbnailResponse::decodeInBackground()
+{
+    const QString path = m_path;
+    const QSize requestedSize = m_requestedSize;
+    const QString key = cacheKey(m_path, m_time, m_requestedSize);
+    // 缩略图是用户正在看的内容，走 Interactive 通道；run() 只在 response 仍存在且未取消时回调
+    TaskExecutor::instance()->run(this, m_token, [path, requestedSize, key](const CancellationToken &token) {
+        return decodeThumbnail(path, requestedSize, key, token);
+    }, [this](const DecodedThumbnail &decoded) {
+        m_image = decoded.image;
+        m_error = decoded.error;
+        finish();
+    }, TaskExecutor::Interactive);
+}
+
+void ThumbnailResponse::finish()
+{
+    // 结果与取消可能先后到达，只通知一次；排队到 response 所在线程再通知，保证引擎已经连接 finished 信号
+    if (!m_finished.testAndSetOrdered(0, 1)) {
+        return;
+    }
+    QMetaObject::invokeMethod(this, [this]() { emit finished(); }, Qt::QueuedConnection);
+}
+
+QQuickTextureFactory *ThumbnailResponse::textureFactory() const
+{
+    return QQuickTextureFactory::textureFactoryForImage(m_image);
+}
+
+QString ThumbnailResponse::errorString() const
+{
+    return m_error;
+}
+
+void ThumbnailResponse::cancel()
+{
+    // 丢弃排队中的解码；仍然通知 finished，引擎没有立即删除 response 时可以据此回收。
+    // 排队的通知以 this 为接收者，response 被删除时随之丢弃
+    m_token.cancel();
+    finish();
+}
+
+
+// --- 2. ThumbnailProvider ---
+ThumbnailProvider::ThumbnailProvider()
+{
+    qDebug() << "ThumbnailProvider 使用指令集:" << ImageScaler::activeInstructionSet();
+}
+
+QQuickImageResponse *ThumbnailProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
+{
+    // id 即本地文件路径 (QML 中可能经过百分号编码)
+    QString path = QUrl::fromPercentEncoding(id.toUtf8());
+    // 媒体片段语法 "#t=<秒>"：视频取该时刻的帧 (拖动预览)
+    double time = 0;
+    const int fragment = path.lastIndexOf("#t=");
+    if (fragment >= 0) {
+        time = path.mid(fragment + 3).toDouble();
+        path.truncate(fragment);
+    }
+    if (path.startsWith("file://")) {
+        path = QUrl(path).toLocalFile();
+    }
+    return new ThumbnailResponse(path, time, requestedSize);
+}
+
+bool ThumbnailProvider::lookup(const QString &key, QImage &image)
+{
+    QMutexLocker locker(&s_cacheMutex);
+    QImage *cached = s_cache.object(key);
+    if (!cached) {
+        return false;
+    }
+    image = *cached;
+    return true;
+}
+
+void ThumbnailProvider::store(const QString &key, const QImage &image)
+{
+    QMutexLocker locker(&s_cacheMutex);
+    s_cache.insert(key, new QImage(image), qMax(1, image.width() * image.height()));
+}
@@ -0,0 +1,57 @@
+#ifndef THUMBNAILPROVIDER_H
+#define THUMBNAILPROVIDER_H
+
+#include <QQuickAsyncImageProvider>
+#include <QQuickImageResponse>
+#include <QImage>
+#include <QCache>
+#include <QMutex>
+#include <QAtomicInt>
+#include "taskexecutor.h"
+
+// QML 侧通过 "image://thumbnail/<本地文件路径>" 请求缩略图，视频可附加 "#t=<秒>" 取指定时刻的帧；
+// 解码 + 缩小优先交给 stv-mediaworker 子进程，不可用时在 TaskExecutor 中完成，不占用 QML 图片加载线程。
+class ThumbnailResponse : public QQuickImageResponse
+{
+public:
+    ThumbnailResponse(const QString &path, double time, const QSize &requestedSize);
+
+    QQuickTextureFactory *textureFactory() const override;
+    QString errorString() const override;
+    void cancel() override;
+
+private:
+    // 引擎可能在 cancel() 之后随时删除 response：后台解码与子进程回调只按值持有参数，
+    // 结果经与 response 同线程的中转对象投递，投递时再用 QPointer 确认 response 仍然存在
+    void decodeInBackground();
+    void finish();
+
+    QString m_path;
+    double m_time;
+    QSize m_requestedSize;
+    QImage m_image;
+    QString m_error;
+    CancellationToken m_token;
+    QAtomicInt m_finished;
+};
+
+class ThumbnailProvider : public QQuickAsyncImageProvider
+{
+public:
+    ThumbnailProvider();
+
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
+
+    // 未指定 sourceSize 时的默认最长边
+    static const int DefaultMaxEdge = 256;
+
+    // 进程内缩略图缓存 (按 路径 + 尺寸)，工作线程与 GUI 线程共用
+    static bool lookup(const QString &key, QImage &image);
+    static void store(const QString &key, const QImage &image);
+
+private:
+    static QMutex s_cacheMutex;
+    static QCache<QString, QImage> s_cache;
+};
+
+#endif // THUMBNAILPROVIDER_H
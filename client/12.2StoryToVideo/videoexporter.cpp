@@ -1,4 +1,6 @@
 #include "VideoExporter.h"
+#include "streamdigest.h"
+#include <QSaveFile>
 #include <QDebug>
 
 VideoExporter::VideoExporter(QObject *parent)
@@ -11,30 +13,67 @@ void VideoExporter::exportVideo(const QString &videoUrl, const QString &saveFile
 {
     qDebug() << "开始下载视频: " << videoUrl;
 
+    // 边下载边写盘，同时增量计算 SHA-256 用于与服务端摘要头比对 (导出文件不进缓存索引，摘要只用于校验)。
+    // 写入 QSaveFile 的临时文件，下载与校验都成功后才替换目标文件；失败时已有的同名文件保持不变
+    QSaveFile *file = new QSaveFile(saveFilePath, this);
+    if (!file->open(QIODevice::WriteOnly)) {
+        emit exportFailed("无法写入文件: " + saveFilePath);
+        delete file;
+        return;
+    }
+    QSharedPointer<StreamDigest> digest(new StreamDigest);
+
     // Qt5.8 需要明确创建 request 对象，不能用临时变量
     QUrl url(videoUrl);
     QNetworkRequest request(url);
 
     QNetworkReply *reply = m_manager->get(request);
 
-    connect(reply, &QNetworkReply::finished, [this, reply, saveFilePath]() {
+    connect(reply, &QNetworkReply::readyRead, this, [reply, file, digest]() {
+        const QByteArray data = reply->readAll();
+        if (file->write(data) != data.size()) {
+            // 磁盘写满等错误：停止下载，finished 中按写入失败处理
+            reply->abort();
+            return;
+        }
+        digest->addData(data);
+    });
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, file, digest, saveFilePath]() {
+        reply->deleteLater();
+        file->deleteLater();
+
+        if (file->error() != QFileDevice::NoError) {
+            file->cancelWriting();
+            emit exportFailed("无法写入文件: " + saveFilePath + " (" + file->errorString() + ")");
+            return;
+        }
         if (reply->error() != QNetworkReply::NoError) {
+            file->cancelWriting();
             emit exportFailed("下载失败: " + reply->errorString());
-            reply->deleteLater();
             return;
         }
 
-        QFile file(saveFilePath);
-        if (!file.open(QIODevice::WriteOnly)) {
-            emit exportFailed("无法写入文件: " + saveFilePath);
-            reply->deleteLater();
+        const QByteArray tail = reply->readAll();
+        if (file->write(tail) != tail.size()) {
+            file->cancelWriting();
+            emit exportFailed("无法写入文件: " + saveFilePath + " (" + file->errorString() + ")");
             return;
         }
+        digest->addData(tail);
 
-        file.write(reply->readAll());
-        file.close();
+        QString verifyError;
+        if (!StreamDigest::verify(reply, digest->result(), &verifyError)) {
+            file->cancelWriting();
+            emit exportFailed(verifyError);
+            return;
+        }
+        if (!file->commit()) {
+            emit exportFailed("无法保存文件: " + saveFilePath + " (" + file->errorString() + ")");
+            return;
+        }
 
+        qDebug() << "视频下载完成:" << saveFilePath << digest->bytes() << "bytes sha256:" << digest->result().toHex();
         emit exportFinished("视频导出成功！");
-        reply->deleteLater();
     });
 }
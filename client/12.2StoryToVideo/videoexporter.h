@@ -5,6 +5,7 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QFile>
+#include <QSharedPointer>
 
 class VideoExporter : public QObject
 {
@@ -0,0 +1,351 @@
+#include "waveformpeaks.h"
+#include "localvideorenderer.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const quint32 PeaksMagic = 0x53545650;   // "STVP"
+const quint32 PeaksVersion = 1;
+const int ReadBlockBytes = 1 << 20;
+const int DecodeTimeoutMs = 30000;       // ffmpeg 超过该时间没有输出视为卡死
+
+// 流式累积第 0 级峰值：每 BaseSamplesPerPeak 个采样输出一对 (min, max)
+class PeakAccumulator
+{
+public:
+    void add(qint16 sample)
+    {
+        m_low = qMin(m_low, sample);
+        m_high = qMax(m_high, sample);
+        ++m_total;
+        if (++m_pending == WaveformPeaks::BaseSamplesPerPeak) {
+            flush();
+        }
+    }
+
+    // 小端 16 位单声道采样
+    void addLittleEndian(const char *data, int sampleCount)
+    {
+        const uchar *bytes = reinterpret_cast<const uchar *>(data);
+        for (int i = 0; i < sampleCount; ++i) {
+            add(qFromLittleEndian<qint16>(bytes + 2 * i));
+        }
+    }
+
+    void flush()
+    {
+        if (m_pending == 0) {
+            return;
+        }
+        m_base << m_low << m_high;
+        m_low = 32767;
+        m_high = -32768;
+        m_pending = 0;
+    }
+
+    const QVector<qint16> &base() const { return m_base; }
+    qint64 total() const { return m_total; }
+
+private:
+    QVector<qint16> m_base;
+    qint16 m_low = 32767;
+    qint16 m_high = -32768;
+    int m_pending = 0;
+    qint64 m_total = 0;
+};
+
+// PCM 16 位 WAV：直接解析，多声道取平均；不是这种格式时返回 false 交给 ffmpeg
+bool decodeWav(const QString &path, PeakAccumulator *peaks, int *sampleRate)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray riff = file.read(12);
+    if (riff.size() < 12 || !riff.startsWith("RIFF") || riff.mid(8, 4) != "WAVE") {
+        return false;
+    }
+
+    int channels = 0;
+    int bits = 0;
+    for (;;) {
+        const QByteArray header = file.read(8);
+        if (header.size() < 8) {
+            return false;
+        }
+        const QByteArray id = header.left(4);
+        const quint32 size = qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(header.constData() + 4));
+        if (id == "fmt ") {
+            const QByteArray fmt = file.read(size);
+            if (fmt.size() < 16) {
+                return false;
+            }
+            const uchar *f = reinterpret_cast<const uchar *>(fmt.constData());
+            const int format = qFromLittleEndian<quint16>(f);
+            channels = qFromLittleEndian<quint16>(f + 2);
+            *sampleRate = int(qFromLittleEndian<quint32>(f + 4));
+            bits = qFromLittleEndian<quint16>(f + 14);
+            if (format != 1 || bits != 16 || channels < 1 || *sampleRate <= 0) {
+                return false;
+            }
+        } else if (id == "data") {
+            if (channels == 0) {
+                return false;
+            }
+            break;
+        } else if (!file.seek(file.pos() + size + (size & 1))) {
+            return false;
+        }
+    }
+
+    // 逐块读取 data，块大小对齐到整帧
+    const int frameBytes = 2 * channels;
+    const int blockBytes = ReadBlockBytes - ReadBlockBytes % frameBytes;
+    for (;;) {
+        const QByteArray block = file.read(blockBytes);
+        const int frames = block.size() / frameBytes;
+        if (frames == 0) {
+            break;
+        }
+        const uchar *bytes = reinterpret_cast<const uchar *>(block.constData());
+        for (int i = 0; i < frames; ++i) {
+            int sum = 0;
+            for (int c = 0; c < channels; ++c) {
+                sum += qFromLittleEndian<qint16>(bytes + i * frameBytes + 2 * c);
+            }
+            peaks->add(qint16(sum / channels));
+        }
+    }
+    return true;
+}
+
+// 其他格式交给 ffmpeg 解码为 s16le 单声道，从管道边读边累积
+bool decodeWithFfmpeg(const QString &path, PeakAccumulator *peaks, QString *errorMsg)
+{
+    const QString ffmpeg = LocalVideoRenderer::ffmpegPath();
+    if (ffmpeg.isEmpty()) {
+        *errorMsg = "未找到 ffmpeg，无法解码该音频格式";
+        return false;
+    }
+
+    QProcess process;
+    process.start(ffmpeg, {"-v", "error", "-i", path, "-vn", "-ac", "1",
+                           "-ar", QString::number(WaveformPeaks::DecodeSampleRate), "-f", "s16le", "-"});
+    if (!process.waitForStarted(5000)) {
+        *errorMsg = "ffmpeg 启动失败: " + process.errorString();
+        return false;
+    }
+
+    QByteArray pending;
+    for (;;) {
+        const bool ready = process.waitForReadyRead(DecodeTimeoutMs);
+        pending += process.readAllStandardOutput();
+        const int usable = pending.size() & ~1;
+        peaks->addLittleEndian(pending.constData(), usable / 2);
+        pending.remove(0, usable);
+        if (!ready) {
+            if (process.state() != QProcess::NotRunning) {
+                process.kill();
+                process.waitForFinished();
+                *errorMsg = "ffmpeg 解码超时";
+                return false;
+            }
+            break;
+        }
+    }
+    process.waitForFinished();
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        *errorMsg = "ffmpeg 解码失败: " + QString::fromUtf8(process.readAllStandardError()).trimmed();
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+// --- 1. 生成 ---
+bool WaveformPeaks::build(const QString &audioPath, const QString &peaksPath, QString *errorMsg)
+{
+    QString error;
+    PeakAccumulator accumulator;
+    int sampleRate = 0;
+    if (!decodeWav(audioPath, &accumulator, &sampleRate)) {
+        accumulator = PeakAccumulator();
+        sampleRate = DecodeSampleRate;
+        if (!decodeWithFfmpeg(audioPath, &accumulator, &error)) {
+            if (errorMsg) {
+                *errorMsg = error;
+            }
+            return false;
+        }
+    }
+    accumulator.flush();
+    if (accumulator.total() == 0) {
+        if (errorMsg) {
+            *errorMsg = "音频中没有采样: " + audioPath;
+        }
+        return false;
+    }
+
+    const WaveformPeaks peaks = fromBaseLevel(sampleRate, accumulator.total(), accumulator.base());
+    QDir().mkpath(QFileInfo(peaksPath).absolutePath());
+    if (!peaks.save(peaksPath)) {
+        if (errorMsg) {
+            *errorMsg = "无法写入峰值文件: " + peaksPath;
+        }
+        return false;
+    }
+    qDebug() << "WaveformPeaks:" << audioPath << peaks.durationSeconds() << "s," << peaks.levels().size() << "级 ->" << peaksPath;
+    return true;
+}
+
+WaveformPeaks WaveformPeaks::fromBaseLevel(int sampleRate, qint64 totalSamples, const QVector<qint16> &base)
+{
+    WaveformPeaks peaks;
+    peaks.m_sampleRate = sampleRate;
+    peaks.m_totalSamples = totalSamples;
+
+    Level level;
+    level.samplesPerPeak = BaseSamplesPerPeak;
+    level.minMax = base;
+    peaks.m_levels.append(level);
+
+    while (level.count() / LevelFactor >= MinPeaksPerLevel) {
+        Level coarser;
+        coarser.samplesPerPeak = level.samplesPerPeak * LevelFactor;
+        const int count = (level.count() + LevelFactor - 1) / LevelFactor;
+        coarser.minMax.resize(count * 2);
+        for (int i = 0; i < count; ++i) {
+            qint16 low = 32767;
+            qint16 high = -32768;
+            const int end = qMin(level.count(), (i + 1) * LevelFactor);
+            for (int j = i * LevelFactor; j < end; ++j) {
+                low = qMin(low, level.minMax.at(2 * j));
+                high = qMax(high, level.minMax.at(2 * j + 1));
+            }
+            coarser.minMax[2 * i] = low;
+            coarser.minMax[2 * i + 1] = high;
+        }
+        peaks.m_levels.append(coarser);
+        level = coarser;
+    }
+    return peaks;
+}
+
+
+// --- 2. 查询 ---
+QVector<float> WaveformPeaks::range(double startSeconds, double endSeconds, int buckets) const
+{
+    QVector<float> result;
+    if (!isValid() || buckets <= 0 || endSeconds <= startSeconds) {
+        return result;
+    }
+    result.reserve(buckets * 2);
+
+    const double firstSample = startSeconds * m_sampleRate;
+    const double samplesPerBucket = (endSeconds - startSeconds) * m_sampleRate / buckets;
+
+    // 选每个峰值覆盖的采样数不超过每个桶的最粗一级
+    int chosen = 0;
+    for (int i = 0; i < m_levels.size(); ++i) {
+        if (m_levels[i].samplesPerPeak <= samplesPerBucket) {
+            chosen = i;
+        }
+    }
+    const Level &level = m_levels[chosen];
+
+    for (int b = 0; b < buckets; ++b) {
+        const qint64 from = qint64(std::floor((firstSample + b * samplesPerBucket) / level.samplesPerPeak));
+        qint64 to = qint64(std::floor((firstSample + (b + 1) * samplesPerBucket) / level.samplesPerPeak));
+        to = qMax(to, from + 1);   // 放大到单个峰值以下时，相邻桶共用同一个峰值
+
+        qint16 low = 0;
+        qint16 high = 0;
+        bool any = false;
+        for (qint64 i = qMax<qint64>(0, from); i < qMin<qint64>(level.count(), to); ++i) {
+            const qint16 l = level.minMax[int(2 * i)];
+            const qint16 h = level.minMax[int(2 * i + 1)];
+            low = any ? qMin(low, l) : l;
+            high = any ? qMax(high, h) : h;
+            any = true;
+        }
+        result << low / 32768.0f << high / 32768.0f;
+    }
+    return result;
+}
+
+
+// --- 3. 文件格式 ---
+// 小端：magic, version, sampleRate, totalSamples, levelCount，
+// 然后每级 samplesPerPeak, count, count 对 (min, max) int16
+bool WaveformPeaks::save(const QString &peaksPath) const
+{
+    QSaveFile file(peaksPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out << PeaksMagic << PeaksVersion << qint32(m_sampleRate) << qint64(m_totalSamples) << qint32(m_levels.size());
+    for (const Level &level : m_levels) {
+        out << qint32(level.samplesPerPeak) << qint32(level.count());
+        for (qint16 value : level.minMax) {
+            out << value;
+        }
+    }
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+WaveformPeaks WaveformPeaks::load(const QString &peaksPath)
+{
+    WaveformPeaks peaks;
+    QFile file(peaksPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return peaks;
+    }
+    QDataStream in(&file);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint32 sampleRate = 0;
+    qint64 totalSamples = 0;
+    qint32 levelCount = 0;
+    in >> magic >> version >> sampleRate >> totalSamples >> levelCount;
+    if (magic != PeaksMagic || version != PeaksVersion || sampleRate <= 0 || levelCount <= 0 || levelCount > 32) {
+        return WaveformPeaks();
+    }
+
+    for (int i = 0; i < levelCount; ++i) {
+        qint32 samplesPerPeak = 0;
+        qint32 count = 0;
+        in >> samplesPerPeak >> count;
+        // 防止损坏的文件让我们分配超出文件大小的内存
+        if (samplesPerPeak <= 0 || count < 0 || qint64(count) * 4 > file.size()) {
+            return WaveformPeaks();
+        }
+        Level level;
+        level.samplesPerPeak = samplesPerPeak;
+        level.minMax.resize(count * 2);
+        for (qint16 &value : level.minMax) {
+            in >> value;
+        }
+        peaks.m_levels.append(level);
+    }
+    if (in.status() != QDataStream::Ok) {
+        return WaveformPeaks();
+    }
+    peaks.m_sampleRate = sampleRate;
+    peaks.m_totalSamples = totalSamples;
+    return peaks;
+}
@@ -0,0 +1,50 @@
+#ifndef WAVEFORMPEAKS_H
+#define WAVEFORMPEAKS_H
+
+#include <QString>
+#include <QVector>
+
+// 音频波形的多级峰值 (类似图片的 mipmap)：
+// 第 0 级每 BaseSamplesPerPeak 个采样记一对 (min, max)，之后每级把 LevelFactor 个峰值合并为一个。
+// 时间线按 "每像素采样数" 选最接近而不更粗的一级，任意缩放都只需读取与像素数同量级的数据，
+// 不必在 GUI 线程解码音频。峰值文件由 build() 在工作线程生成，格式见 save()。
+class WaveformPeaks
+{
+public:
+    struct Level {
+        int samplesPerPeak = 0;
+        QVector<qint16> minMax;    // min0, max0, min1, max1, ...
+        int count() const { return minMax.size() / 2; }
+    };
+
+    static const int DecodeSampleRate = 22050;    // ffmpeg 解码时重采样为单声道 22.05 kHz
+    static const int BaseSamplesPerPeak = 128;
+    static const int LevelFactor = 4;
+    static const int MinPeaksPerLevel = 64;       // 峰值数少于该值时不再生成更粗的级别
+
+    bool isValid() const { return !m_levels.isEmpty() && m_sampleRate > 0; }
+    int sampleRate() const { return m_sampleRate; }
+    qint64 totalSamples() const { return m_totalSamples; }
+    double durationSeconds() const { return m_sampleRate > 0 ? double(m_totalSamples) / m_sampleRate : 0; }
+    const QVector<Level> &levels() const { return m_levels; }
+
+    // [startSeconds, endSeconds) 映射为 buckets 对 (min, max)，取值 -1..1
+    QVector<float> range(double startSeconds, double endSeconds, int buckets) const;
+
+    // 解码音频并写出峰值文件 (阻塞，须在工作线程调用)。
+    // PCM WAV 直接解析；其他格式经 ffmpeg 流式解码，整段 PCM 不会留在内存里
+    static bool build(const QString &audioPath, const QString &peaksPath, QString *errorMsg = nullptr);
+
+    static WaveformPeaks load(const QString &peaksPath);
+    bool save(const QString &peaksPath) const;
+
+private:
+    // 由第 0 级逐级合并出更粗的级别
+    static WaveformPeaks fromBaseLevel(int sampleRate, qint64 totalSamples, const QVector<qint16> &base);
+
+    int m_sampleRate = 0;
+    qint64 m_totalSamples = 0;
+    QVector<Level> m_levels;
+};
+
+#endif // WAVEFORMPEAKS_H
@@ -7,13 +7,40 @@
 2. GET /v1/api/tasks/:task_id -> 查询任务状态
 3. GET /v1/api/projects/:project_id/shots -> 获取分镜列表
 4. POST /v1/api/projects/:project_id/video -> 触发视频生成
+5. POST /v1/api/tasks/priority -> 客户端上报分镜任务优先级 (视口优先)
+6. POST /v1/api/projects/:project_id/tts -> 触发旁白配音 (project_audio 任务，结果为 WAV)
+7. GET /v1/api/tasks/:task_id?wait=N&since=<updated_at> -> 长轮询：状态变化或 N 秒超时后返回
+
+另外提供与云端 Gateway 相同的路径 (/v1/projects/...、/tasks/...)，
+客户端设置 STV_GATEWAY_URL=http://127.0.0.1:8888 即可直接连到本服务 (浸泡测试使用)。
+MOCK_TIME_SCALE 缩放所有任务耗时，MOCK_PUBLIC_URL 设置后结果资源改由本服务 /media 提供。
+MOCK_MAX_QUEUE 模拟过载：GPU 队列达到该长度后提交类接口返回 429 + Retry-After，
+任务查询响应带 queue_depth 字段和 X-Queue-Depth 头。
+分镜列表的 blurhash 字段为占位图编码 (按分镜 ID 合成的模糊画面)，客户端在图片到达前先显示。
+MOCK_LONG_POLL=0 模拟不支持长轮询的服务端 (忽略 wait 参数，也不返回 X-Long-Poll 头)。
+视频结果带 renditions 字段 (按请求的分辨率阶梯给出各档码率与地址)，客户端按测得的带宽选择播放档位；
+各档是用 ffmpeg 按该档分辨率/码率合成的真实 MP4 (缓存在 MOCK_MEDIA_DIR，支持 Range)，地址取自请求的 Host；
+找不到 ffmpeg 时不给出档位，成片指向外网示例视频。
+MOCK_THROTTLE_KBPS 限制 /media 的下载速率，模拟隧道带宽 (例如 MOCK_THROTTLE_KBPS=2000)。
 """
 
 import asyncio
+import colorsys
+import hashlib
+import io
+import math
+import os
+import re
+import shutil
+import subprocess
+import tempfile
+import threading
+import wave
 import uuid
 from datetime import datetime
 from typing import Dict, List, Optional
-from fastapi import FastAPI, HTTPException, BackgroundTasks
+from fastapi import FastAPI, HTTPException, BackgroundTasks, Request, Response
+from fastapi.responses import StreamingResponse
 from fastapi.middleware.cors import CORSMiddleware
 from pydantic import BaseModel
 
@@ -48,6 +75,30 @@ PROJECT_STATUS_CREATED = "created"
 PROJECT_STATUS_TEXT_GENERATED = "text_generated"
 PROJECT_STATUS_READY = "ready"
 
+# 模拟 GPU 并发数：分镜图片任务排队执行，按优先级出队
+GPU_WORKERS = int(os.environ.get("MOCK_GPU_WORKERS", "2"))
+# 未收到客户端提示的任务排在所有提示过的任务之后
+DEFAULT_PRIORITY = 1000
+
+# 任务耗时缩放 (浸泡测试用 0.05 之类的小值加速)
+TIME_SCALE = float(os.environ.get("MOCK_TIME_SCALE", "1.0"))
+# 设置后图片/视频结果指向本服务的 /media，不依赖外网
+PUBLIC_URL = os.environ.get("MOCK_PUBLIC_URL", "").rstrip("/")
+# GPU 队列上限，达到后拒绝新的提交 (0 表示不限制)
+MAX_QUEUE = int(os.environ.get("MOCK_MAX_QUEUE", "0"))
+# 长轮询：wait 上限 (秒)；MOCK_LONG_POLL=0 时关闭
+LONG_POLL = os.environ.get("MOCK_LONG_POLL", "1") != "0"
+LONG_POLL_MAX_WAIT = 30.0
+# /media 下载限速 (kbit/s，0 表示不限)
+THROTTLE_KBPS = int(os.environ.get("MOCK_THROTTLE_KBPS", "0"))
+
+# 视频档位：分辨率 -> 码率 (kbit/s)；模拟成片时长 (秒)，决定各档文件大小
+RENDITION_BITRATES = {"1920x1080": 5000, "1280x720": 2800, "854x480": 1400, "640x360": 800}
+MOCK_VIDEO_SECONDS = 10
+# 合成的档位视频缓存目录 (按分辨率各一份，所有项目共用)
+MEDIA_DIR = os.environ.get("MOCK_MEDIA_DIR") or os.path.join(tempfile.gettempdir(), "stv-mock-media")
+FFMPEG = shutil.which("ffmpeg")
+
 # 分镜状态
 SHOT_STATUS_PENDING = "pending"
 SHOT_STATUS_PROCESSING = "processing"
@@ -60,6 +111,7 @@ class TaskResult(BaseModel):
     resource_type: Optional[str] = None
     resource_id: Optional[str] = None
     resource_url: Optional[str] = None
+    renditions: Optional[List[Dict]] = None
 
 class Task(BaseModel):
     id: str
@@ -87,6 +139,7 @@ class Shot(BaseModel):
     audio_path: str = ""
     transition: str = "cut"
     duration: float = 3.0
+    blurhash: str = ""
     status: str = SHOT_STATUS_PENDING
     created_at: str
     updated_at: str
@@ -112,11 +165,94 @@ tasks: Dict[str, Task] = {}
 shots: Dict[str, Shot] = {}  # key: shot_id
 project_shots: Dict[str, List[str]] = {}  # key: project_id, value: [shot_ids]
 
+# GPU 队列：等待执行的任务 -> 模拟耗时
+gpu_pending: Dict[str, float] = {}
+gpu_running = 0
+
+# 长轮询等待者：task_id -> 任务下次变化时 set 的事件
+task_waiters: Dict[str, asyncio.Event] = {}
+
 # ==================== 工具函数 ====================
 
 def now_iso() -> str:
     return datetime.utcnow().isoformat() + "Z"
 
+BASE83 = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz#$%*+,-.:;=?@[]^_{|}~"
+
+def _encode83(value: int, length: int) -> str:
+    return "".join(BASE83[(value // 83 ** (length - 1 - i)) % 83] for i in range(length))
+
+def _srgb_to_linear(value: int) -> float:
+    v = value / 255
+    return v / 12.92 if v <= 0.04045 else ((v + 0.055) / 1.055) ** 2.4
+
+def _linear_to_srgb(value: float) -> int:
+    v = max(0.0, min(1.0, value))
+    srgb = v * 12.92 if v <= 0.0031308 else 1.055 * v ** (1 / 2.4) - 0.055
+    return int(srgb * 255 + 0.5)
+
+def _sign_pow(value: float, exponent: float) -> float:
+    return math.copysign(abs(value) ** exponent, value)
+
+def encode_blurhash(pixels: List[tuple], width: int, height: int, cx: int = 4, cy: int = 3) -> str:
+    """BlurHash 编码：pixels 为按行排列的 (r, g, b) 0..255"""
+    linear = [tuple(_srgb_to_linear(c) for c in p) for p in pixels]
+    factors = []
+    for j in range(cy):
+        for i in range(cx):
+            norm = 1 if i == 0 and j == 0 else 2
+            r = g = b = 0.0
+            for y in range(height):
+                cos_y = math.cos(math.pi * j * y / height)
+                for x in range(width):
+                    basis = norm * math.cos(math.pi * i * x / width) * cos_y
+                    pr, pg, pb = linear[y * width + x]
+                    r += basis * pr
+                    g += basis * pg
+                    b += basis * pb
+            scale = 1 / (width * height)
+            factors.append((r * scale, g * scale, b * scale))
+
+    dc, ac = factors[0], factors[1:]
+    result = _encode83((cx - 1) + (cy - 1) * 9, 1)
+    if ac:
+        actual_max = max(abs(c) for f in ac for c in f)
+        quantised_max = int(max(0, min(82, math.floor(actual_max * 166 - 0.5))))
+        maximum = (quantised_max + 1) / 166
+        result += _encode83(quantised_max, 1)
+    else:
+        maximum = 1.0
+        result += _encode83(0, 1)
+    result += _encode83((_linear_to_srgb(dc[0]) << 16) + (_linear_to_srgb(dc[1]) << 8) + _linear_to_srgb(dc[2]), 4)
+    for f in ac:
+        q = [int(max(0, min(18, math.floor(_sign_pow(c / maximum, 0.5) * 9 + 9.5)))) for c in f]
+        result += _encode83(q[0] * 19 * 19 + q[1] * 19 + q[2], 2)
+    return result
+
+def make_placeholder(seed: str, size: int = 16) -> str:
+    """按种子合成一幅 "天空 + 地面 + 太阳" 的小图并编码为 BlurHash (模拟服务端从生成图缩略得到)"""
+    digest = hashlib.sha1(seed.encode()).digest()
+    hue = digest[0] / 255
+    sky_top = colorsys.hsv_to_rgb(hue, 0.45, 0.95)
+    sky_bottom = colorsys.hsv_to_rgb((hue + 0.08) % 1, 0.25, 1.0)
+    ground = colorsys.hsv_to_rgb((hue + 0.35) % 1, 0.6, 0.45)
+    horizon = 0.55 + digest[1] / 255 * 0.2
+    sun_x, sun_y = digest[2] / 255, 0.15 + digest[3] / 255 * 0.3
+    pixels = []
+    for y in range(size):
+        v = (y + 0.5) / size
+        for x in range(size):
+            u = (x + 0.5) / size
+            if v > horizon:
+                c = ground
+            else:
+                t = v / horizon
+                c = tuple(a + (b - a) * t for a, b in zip(sky_top, sky_bottom))
+                if (u - sun_x) ** 2 + (v - sun_y) ** 2 < 0.012:
+                    c = (1.0, 0.93, 0.7)
+            pixels.append(tuple(int(ch * 255) for ch in c))
+    return encode_blurhash(pixels, size, size)
+
 def generate_mock_shots(project_id: str, story_text: str, style: str) -> List[Shot]:
     """模拟 LLM 生成分镜"""
     # 简单地按句号分割故事，生成分镜
@@ -142,10 +278,57 @@ def generate_mock_shots(project_id: str, story_text: str, style: str) -> List[Sh
             created_at=now,
             updated_at=now
         )
+        shot.blurhash = make_placeholder(shot.id)
         result.append(shot)
     
     return result
 
+def touch_task(task: Task):
+    """任务有变化：更新时间戳 (即长轮询的 since 版本) 并唤醒等待者"""
+    task.updated_at = now_iso()
+    event = task_waiters.pop(task.id, None)
+    if event:
+        event.set()
+
+def gpu_sort_key(task_id: str):
+    """优先级数值越小越先执行；同优先级按分镜顺序、创建时间"""
+    task = tasks[task_id]
+    params = task.parameters or {}
+    return (params.get("priority", DEFAULT_PRIORITY), params.get("shot_order", 0), task.created_at)
+
+def schedule_gpu_task(task_id: str, duration: float):
+    """加入 GPU 队列，有空闲 worker 时立即出队"""
+    gpu_pending[task_id] = duration
+    dispatch_gpu_tasks()
+
+def dispatch_gpu_tasks():
+    global gpu_running
+    while gpu_pending and gpu_running < GPU_WORKERS:
+        task_id = min(gpu_pending, key=gpu_sort_key)
+        duration = gpu_pending.pop(task_id)
+        gpu_running += 1
+        asyncio.create_task(run_gpu_task(task_id, duration))
+
+def check_overload():
+    """GPU 队列已满时拒绝提交，Retry-After 按排在前面的任务耗时估算"""
+    if MAX_QUEUE <= 0 or len(gpu_pending) < MAX_QUEUE:
+        return
+    backlog = sum(gpu_pending.values()) * TIME_SCALE / max(GPU_WORKERS, 1)
+    retry_after = max(1, int(backlog))
+    raise HTTPException(
+        status_code=429,
+        detail="GPU queue is full",
+        headers={"Retry-After": str(retry_after), "X-Queue-Depth": str(len(gpu_pending))}
+    )
+
+async def run_gpu_task(task_id: str, duration: float):
+    global gpu_running
+    try:
+        await simulate_task_execution(task_id, duration)
+    finally:
+        gpu_running -= 1
+        dispatch_gpu_tasks()
+
 async def simulate_task_execution(task_id: str, duration: float = 3.0):
     """模拟任务执行过程"""
     task = tasks.get(task_id)
@@ -156,21 +339,28 @@ async def simulate_task_execution(task_id: str, duration: float = 3.0):
     task.status = TASK_STATUS_PROCESSING
     task.progress = 0
     task.message = "正在处理..."
-    task.updated_at = now_iso()
+    touch_task(task)
     
     # 模拟进度更新
     steps = 10
     for i in range(steps):
-        await asyncio.sleep(duration / steps)
+        await asyncio.sleep(duration * TIME_SCALE / steps)
         task.progress = int((i + 1) / steps * 100)
         task.message = f"处理中 {task.progress}%"
-        task.updated_at = now_iso()
+        touch_task(task)
     
+    # 视频任务：先准备好各档的真实片段，结果里只给出能播放的地址
+    if task.type == TASK_TYPE_PROJECT_VIDEO:
+        requested = (task.parameters or {}).get("renditions") or list(RENDITION_BITRATES)
+        for resolution in set(requested) | {"1920x1080"}:
+            if resolution in RENDITION_BITRATES:
+                await asyncio.to_thread(ensure_clip, resolution)
+
     # 任务完成
     task.status = TASK_STATUS_FINISHED
     task.progress = 100
     task.message = "完成"
-    task.updated_at = now_iso()
+    touch_task(task)
     
     # 根据任务类型设置结果
     if task.type == TASK_TYPE_PROJECT_TEXT:
@@ -204,9 +394,10 @@ async def simulate_task_execution(task_id: str, duration: float = 3.0):
                                 t.parameters["prompt"] = shot.prompt
                         
                         t.status = TASK_STATUS_PENDING
-                        t.updated_at = now_iso()
-                        # 异步执行
-                        asyncio.create_task(simulate_task_execution(t.id, 2.0))
+                        t.message = "排队中"
+                        touch_task(t)
+                        # 进入 GPU 队列，按优先级执行
+                        schedule_gpu_task(t.id, 2.0)
     
     elif task.type == TASK_TYPE_SHOT_IMAGE:
         # 图片任务完成，更新 shot 的 image_path
@@ -214,6 +405,8 @@ async def simulate_task_execution(task_id: str, duration: float = 3.0):
         if shot:
             # 使用模拟图片 URL
             image_url = f"https://picsum.photos/seed/{task.shot_id}/512/512"
+            if PUBLIC_URL:
+                image_url = f"{PUBLIC_URL}/media/{task.shot_id}.png"
             shot.image_path = image_url
             shot.status = SHOT_STATUS_COMPLETED
             shot.updated_at = now_iso()
@@ -237,17 +430,41 @@ async def simulate_task_execution(task_id: str, duration: float = 3.0):
                 project.updated_at = now_iso()
     
     elif task.type == TASK_TYPE_PROJECT_VIDEO:
-        # 视频任务完成
+        # 视频任务完成：resource_url 始终是最高档 (导出使用)，各档由本服务 /media 提供
+        base_url = (task.parameters or {}).get("base_url") or PUBLIC_URL
+        requested = (task.parameters or {}).get("renditions") or list(RENDITION_BITRATES)
+        # 片段已在上面合成 (或合成失败)，这里只检查文件
+        if os.path.exists(clip_path("1920x1080")):
+            full_url = f"{base_url}/media/{task.project_id}_1080p.mp4"
+        else:
+            full_url = "https://sample-videos.com/video321/mp4/720/big_buck_bunny_720p_1mb.mp4"
+        renditions = []
+        for resolution in requested:
+            if resolution not in RENDITION_BITRATES or not os.path.exists(clip_path(resolution)):
+                continue
+            height = resolution.split("x")[1]
+            url = f"{base_url}/media/{task.project_id}_{height}p.mp4"
+            renditions.append({"resolution": resolution, "bitrate": RENDITION_BITRATES[resolution], "url": url})
         task.result = TaskResult(
             resource_type="video",
             resource_id=task.project_id,
-            resource_url=f"https://sample-videos.com/video321/mp4/720/big_buck_bunny_720p_1mb.mp4"
+            resource_url=full_url,
+            renditions=renditions
         )
         project = projects.get(task.project_id)
         if project:
             project.video_url = task.result.resource_url
             project.updated_at = now_iso()
 
+    elif task.type == TASK_TYPE_PROJECT_AUDIO:
+        # 配音任务完成：WAV 始终由本服务 /media 提供
+        base_url = (task.parameters or {}).get("base_url") or PUBLIC_URL
+        task.result = TaskResult(
+            resource_type="audio",
+            resource_id=task.project_id,
+            resource_url=f"{base_url}/media/{task.project_id}.wav"
+        )
+
 # ==================== API 接口 ====================
 
 @app.get("/health")
@@ -269,6 +486,8 @@ async def create_project(
     创建项目 - 支持 Query 参数格式（客户端使用）
     返回: project_id, text_task_id, shot_task_ids
     """
+    check_overload()
+
     # 兼容拼写错误
     if Desription and not Description:
         Description = Desription
@@ -364,6 +583,7 @@ async def get_shots(project_id: str):
                 "audioPath": shot.audio_path,
                 "transition": shot.transition,
                 "duration": shot.duration,
+                "blurhash": shot.blurhash,
                 "status": shot.status
             })
     return {"shots": result}
@@ -379,11 +599,28 @@ async def get_shot_detail(project_id: str, shot_id: str):
 # ---------- 任务接口 ----------
 
 @app.get("/v1/api/tasks/{task_id}")
-async def get_task_status(task_id: str):
-    """查询任务状态"""
+async def get_task_status(task_id: str, response: Response = None,
+                          wait: Optional[float] = None, since: Optional[str] = None):
+    """
+    查询任务状态
+    带 wait 时为长轮询：since 与当前 updated_at 相同且任务未结束时，挂起到任务变化或 wait 秒超时
+    """
     task = tasks.get(task_id)
     if not task:
         raise HTTPException(status_code=404, detail="Task not found")
+    if LONG_POLL and wait is not None:
+        wait = max(0.0, min(wait, LONG_POLL_MAX_WAIT))
+        if (since is not None and since == task.updated_at
+                and task.status not in (TASK_STATUS_FINISHED, TASK_STATUS_FAILED)):
+            event = task_waiters.setdefault(task_id, asyncio.Event())
+            try:
+                await asyncio.wait_for(event.wait(), timeout=wait)
+            except asyncio.TimeoutError:
+                pass
+        if response is not None:
+            response.headers["X-Long-Poll"] = str(int(wait))
+    if response is not None:
+        response.headers["X-Queue-Depth"] = str(len(gpu_pending))
     
     result = {
         "task": {
@@ -397,19 +634,55 @@ async def get_task_status(task_id: str):
             "parameters": task.parameters,
             "result": task.result.model_dump() if task.result else None,
             "created_at": task.created_at,
-            "updated_at": task.updated_at
+            "updated_at": task.updated_at,
+            "queue_depth": len(gpu_pending)
         }
     }
     return result
 
+class TaskPriority(BaseModel):
+    task_id: str
+    priority: int
+
+class TaskPriorityBatch(BaseModel):
+    tasks: List[TaskPriority]
+
+@app.post("/v1/api/tasks/priority")
+async def update_task_priorities(batch: TaskPriorityBatch):
+    """
+    更新任务优先级 (数值越小越先执行)
+    只影响尚未开始的任务；已在执行或已完成的任务忽略
+    """
+    updated = 0
+    for item in batch.tasks:
+        task = tasks.get(item.task_id)
+        if not task or task.status not in (TASK_STATUS_BLOCKED, TASK_STATUS_PENDING):
+            continue
+        if task.parameters is None:
+            task.parameters = {}
+        task.parameters["priority"] = item.priority
+        touch_task(task)
+        updated += 1
+
+    return {
+        "updated": updated,
+        "queue": sorted(gpu_pending, key=gpu_sort_key)
+    }
+
 # ---------- 视频生成接口 ----------
 
+class VideoRequest(BaseModel):
+    format: Optional[str] = "mp4"
+    resolution: Optional[str] = None
+    renditions: Optional[List[str]] = None
+
 @app.post("/v1/api/projects/{project_id}/video")
-async def generate_video(project_id: str):
-    """触发视频生成任务"""
+async def generate_video(project_id: str, request: Request, body: Optional[VideoRequest] = None):
+    """触发视频生成任务；renditions 为希望额外得到的分辨率阶梯"""
     project = projects.get(project_id)
     if not project:
         raise HTTPException(status_code=404, detail="Project not found")
+    check_overload()
     
     now = now_iso()
     video_task_id = str(uuid.uuid4())
@@ -420,6 +693,7 @@ async def generate_video(project_id: str):
         status=TASK_STATUS_PENDING,
         progress=0,
         message="等待执行",
+        parameters={"renditions": body.renditions if body else None, "base_url": public_base_url(request)},
         created_at=now,
         updated_at=now
     )
@@ -430,6 +704,212 @@ async def generate_video(project_id: str):
     
     return {"task_id": video_task_id}
 
+# ---------- 配音接口 ----------
+
+class TtsRequest(BaseModel):
+    voice: Optional[str] = None
+    format: Optional[str] = "wav"
+
+@app.post("/v1/api/projects/{project_id}/tts")
+async def generate_tts(project_id: str, request: Request, body: Optional[TtsRequest] = None):
+    """触发整段旁白的 TTS 任务"""
+    project = projects.get(project_id)
+    if not project:
+        raise HTTPException(status_code=404, detail="Project not found")
+    check_overload()
+
+    now = now_iso()
+    task_id = str(uuid.uuid4())
+    tasks[task_id] = Task(
+        id=task_id,
+        project_id=project_id,
+        type=TASK_TYPE_PROJECT_AUDIO,
+        status=TASK_STATUS_PENDING,
+        progress=0,
+        message="等待执行",
+        parameters={"voice": body.voice if body else None, "base_url": public_base_url(request)},
+        created_at=now,
+        updated_at=now
+    )
+    asyncio.create_task(simulate_task_execution(task_id, 3.0))
+    return {"task_id": task_id}
+
+# ---------- 分镜重生成接口 ----------
+
+class ShotUpdate(BaseModel):
+    prompt: Optional[str] = None
+    style: Optional[str] = None
+
+@app.post("/v1/api/projects/{project_id}/shots/{shot_id}")
+async def regenerate_shot(project_id: str, shot_id: str, body: ShotUpdate):
+    """修改提示词并重新生成分镜图片，返回新的 shot_image 任务"""
+    shot = shots.get(shot_id)
+    if not shot or shot.project_id != project_id:
+        raise HTTPException(status_code=404, detail="Shot not found")
+    check_overload()
+    if body.prompt:
+        shot.prompt = body.prompt
+    shot.status = SHOT_STATUS_PROCESSING
+    shot.updated_at = now_iso()
+
+    now = now_iso()
+    task_id = str(uuid.uuid4())
+    tasks[task_id] = Task(
+        id=task_id,
+        project_id=project_id,
+        shot_id=shot_id,
+        type=TASK_TYPE_SHOT_IMAGE,
+        status=TASK_STATUS_PENDING,
+        progress=0,
+        message="排队中",
+        parameters={"shot_id": shot_id, "prompt": shot.prompt, "shot_order": shot.order},
+        created_at=now,
+        updated_at=now
+    )
+    schedule_gpu_task(task_id, 2.0)
+    return {"task_id": task_id}
+
+# ---------- 模拟资源 ----------
+
+# 固定内容，客户端媒体缓存只需下载一次
+SAMPLE_MEDIA = bytes(range(256)) * 1024
+
+_wav_cache: Dict[str, bytes] = {}
+
+def make_narration_wav(name: str, seconds: float = 30.0, rate: int = 22050) -> bytes:
+    """合成一段 "旁白"：按句子起伏的包络调制的正弦波，波形上能看出停顿"""
+    if name not in _wav_cache:
+        seed = sum(name.encode()) % 7
+        frames = bytearray()
+        for i in range(int(seconds * rate)):
+            t = i / rate
+            sentence = (t + seed) % 4.0
+            envelope = 0.0 if sentence > 3.3 else math.sin(math.pi * sentence / 3.3) * (0.5 + 0.5 * math.sin(t * 7.0))
+            value = int(envelope * 12000 * math.sin(2 * math.pi * 180 * t))
+            frames += value.to_bytes(2, "little", signed=True)
+        buffer = io.BytesIO()
+        with wave.open(buffer, "wb") as wav:
+            wav.setnchannels(1)
+            wav.setsampwidth(2)
+            wav.setframerate(rate)
+            wav.writeframes(bytes(frames))
+        _wav_cache[name] = buffer.getvalue()
+    return _wav_cache[name]
+
+_clip_lock = threading.Lock()
+
+def public_base_url(request: Request) -> str:
+    """结果中的 /media 地址：MOCK_PUBLIC_URL 优先，否则用客户端访问本服务时的地址 (Host 头)"""
+    return PUBLIC_URL or str(request.base_url).rstrip("/")
+
+def clip_path(resolution: str) -> str:
+    return os.path.join(MEDIA_DIR, f"clip_{resolution.split('x')[1]}p.mp4")
+
+def ensure_clip(resolution: str) -> Optional[str]:
+    """按档位的分辨率与码率合成一段可播放的 MP4 (H.264，moov 前置，每 2 秒一个关键帧)；没有 ffmpeg 时返回 None"""
+    width, height = resolution.split("x")
+    path = clip_path(resolution)
+    with _clip_lock:
+        if os.path.exists(path):
+            return path
+        if not FFMPEG:
+            print("⚠️ 未找到 ffmpeg，视频结果不提供档位")
+            return None
+        os.makedirs(MEDIA_DIR, exist_ok=True)
+        bitrate = RENDITION_BITRATES[resolution]
+        partial = path + ".part.mp4"
+        # 叠加噪声让编码器用满码率，文件大小 ≈ 码率 x 时长，限速时才能测出与档位对应的带宽
+        command = [FFMPEG, "-y", "-loglevel", "error",
+                   "-f", "lavfi", "-i", f"testsrc2=size={width}x{height}:rate=24",
+                   "-t", str(MOCK_VIDEO_SECONDS), "-vf", "noise=alls=12:allf=t",
+                   "-c:v", "libx264", "-preset", "veryfast", "-pix_fmt", "yuv420p",
+                   "-b:v", f"{bitrate}k", "-maxrate", f"{bitrate}k", "-bufsize", f"{bitrate * 2}k",
+                   "-g", "48", "-movflags", "+faststart", partial]
+        result = subprocess.run(command, capture_output=True)
+        if result.returncode != 0:
+            print(f"⚠️ 合成 {resolution} 档视频失败: {result.stderr.decode(errors='replace').strip()}")
+            if os.path.exists(partial):
+                os.remove(partial)
+            return None
+        os.replace(partial, path)
+        print(f"🎬 已合成 {resolution} 档视频 ({os.path.getsize(path) // 1024} KB)")
+        return path
+
+def media_content(name: str) -> Optional[bytes]:
+    """<项目>_<高度>p.mp4 为对应档位的合成视频 (sample.mp4 为最高档)，其余为固定内容"""
+    if name.endswith(".mp4"):
+        resolution = "1920x1080"
+        for candidate in RENDITION_BITRATES:
+            if name.endswith(f"_{candidate.split('x')[1]}p.mp4"):
+                resolution = candidate
+        path = ensure_clip(resolution)
+        if not path:
+            return None
+        with open(path, "rb") as clip:
+            return clip.read()
+    return SAMPLE_MEDIA
+
+def byte_range(header: Optional[str], size: int):
+    """解析单段 Range (bytes=a-b / bytes=a- / bytes=-n)；不支持或越界时返回 None"""
+    match = re.fullmatch(r"bytes=(\d*)-(\d*)", (header or "").strip())
+    if not match or (not match.group(1) and not match.group(2)):
+        return None
+    if match.group(1):
+        start = int(match.group(1))
+        end = min(int(match.group(2)), size - 1) if match.group(2) else size - 1
+    else:
+        start = max(0, size - int(match.group(2)))
+        end = size - 1
+    return (start, end) if start <= end < size else None
+
+async def throttled(content: bytes, kbps: int):
+    chunk = 16 * 1024
+    delay = chunk * 8 / (kbps * 1000)
+    for offset in range(0, len(content), chunk):
+        yield content[offset:offset + chunk]
+        await asyncio.sleep(delay)
+
+@app.get("/media/{name}")
+async def get_media(name: str, request: Request):
+    if name.endswith(".wav"):
+        content, media_type = make_narration_wav(name), "audio/wav"
+    else:
+        # 首次请求某一档时可能需要现场合成，放到线程里不阻塞事件循环
+        content = await asyncio.to_thread(media_content, name)
+        if content is None:
+            raise HTTPException(status_code=404, detail="ffmpeg not available")
+        media_type = "video/mp4" if name.endswith(".mp4") else "image/png"
+
+    # 播放器切换档位时从当前位置继续，需要按范围读取
+    headers = {"Accept-Ranges": "bytes"}
+    status_code = 200
+    requested = byte_range(request.headers.get("range"), len(content))
+    if requested:
+        start, end = requested
+        headers["Content-Range"] = f"bytes {start}-{end}/{len(content)}"
+        content = content[start:end + 1]
+        status_code = 206
+    headers["Content-Length"] = str(len(content))
+    if THROTTLE_KBPS > 0:
+        return StreamingResponse(throttled(content, THROTTLE_KBPS), status_code=status_code,
+                                 media_type=media_type, headers=headers)
+    return Response(content=content, status_code=status_code, media_type=media_type, headers=headers)
+
+# ---------- Gateway 兼容路径 ----------
+# 云端 Gateway 的路径没有 /api 前缀，任务查询直接返回任务对象 (不包在 "task" 下)
+
+app.add_api_route("/v1/projects", create_project, methods=["POST"])
+app.add_api_route("/v1/projects/{project_id}/shots", get_shots, methods=["GET"])
+app.add_api_route("/v1/projects/{project_id}/shots/{shot_id}", regenerate_shot, methods=["POST"])
+app.add_api_route("/v1/projects/{project_id}/video", generate_video, methods=["POST"])
+app.add_api_route("/v1/projects/{project_id}/tts", generate_tts, methods=["POST"])
+app.add_api_route("/tasks/priority", update_task_priorities, methods=["POST"])
+
+@app.get("/tasks/{task_id}")
+async def get_task_status_gateway(task_id: str, response: Response,
+                                  wait: Optional[float] = None, since: Optional[str] = None):
+    return (await get_task_status(task_id, response, wait, since))["task"]
+
 # ==================== 启动服务 ====================
 
 if __name__ == "__main__":